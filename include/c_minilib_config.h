@@ -31,6 +31,10 @@
 
    Supported input formats:
      - Environment-style `.env` files (key=value syntax)
+       Values may be quoted with `"` or `'`, quoted values may span
+       multiple lines and double quoted ones support `\n`, `\t`, `\r`,
+       `\"` and `\\` escapes. `#` starts a comment, `export ` prefix is
+       ignored. Malformed lines are reported with line and column.
 
    Arrays are flattened by encoding their indices into keys. For example:
        ARR=          → absent
@@ -74,6 +78,8 @@ void cmc_lib_destroy(void);
 struct cmc_TreeNode {
   struct cmc_TreeNode **subnodes;
   uint32_t subnodes_len;
+  // Capacity of `subnodes`, it grows geometrically and never shrinks.
+  uint32_t subnodes_max;
 };
 
 /**
@@ -105,20 +111,95 @@ enum cmc_ConfigFieldTypeEnum {
   cmc_ConfigFieldTypeEnum_MAX,
 };
 
+/**
+ * Strings up to this length are stored inside the field, without allocation.
+ */
+#define CMC_FIELD_INLINE_STR_MAX 15
+
 /**
  * Represents a single configuration field.
  */
 struct cmc_ConfigField {
+  // Read-only, equal names of heap fields share memory.
   char *name;
+  // Points at the value, NULL if the field has none. Integers and short
+  //  strings point into `_value`, longer strings are allocated.
   void *value;
   bool optional;
   enum cmc_ConfigFieldTypeEnum type;
   struct cmc_TreeNode _self;
+  // Case-folded hash of `name` and base power of it's length, parsers
+  //  compose hashes of flattened names out of these.
+  uint64_t _name_hash;
+  uint64_t _name_hash_pow;
+  // Storage of array elements instantiated in bulk, elements living in it
+  //  are marked as borrowed.
+  struct cmc_ConfigField *_elements;
+  bool _is_borrowed;
+  // Arena holding all memory of the field and it's subfields, NULL if the
+  //  field lives on the heap.
+  struct cmc_Arena *_arena;
+  // `value` is a reference into the shared value store.
+  bool _is_value_shared;
+  // Name or default value point into a schema descriptor, see
+  //  `cmc_ConfigFieldDescriptor`.
+  bool _is_name_borrowed;
+  bool _is_value_borrowed;
+  // Dense id given by the last indexing of the config, see
+  //  `cmc_FieldHandle`.
+  uint32_t _id;
+  // Open addressing table of children of big dicts, slot holds index of
+  //  the subnode plus one, 0 marks an empty slot. NULL for small dicts.
+  uint32_t *_dict_slots;
+  uint32_t _dict_slots_max;
+  // Number of array elements, see `cmc_field_array_len`. Parsed arrays of
+  //  integers and strings keep values of their elements in one block,
+  //  only the prototype is left in subnodes. Strings block starts with
+  //  offsets of NUL terminated values, relative to the block.
+  uint32_t _array_len;
+  int32_t *_ints;
+  uint32_t *_strs;
+  // Copy of the prototype of an array of dicts or arrays taken before it
+  //  is first parsed. Prototype is parsed as the first element, parsing
+  //  again resets it from the copy, so no stale value is kept or cloned.
+  struct cmc_ConfigField *_prototype;
+  // Member of elements of an array of dicts which parsing indexes, see
+  //  `cmc_field_array_index`.
+  char *_index_key;
+  struct cmc_FieldIndexSlot *_index_slots;
+  uint32_t _index_slots_max;
+  // Inline value storage, `type` tells which member is in use.
+  union {
+    int32_t int_value;
+    char str_value[CMC_FIELD_INLINE_STR_MAX + 1];
+  } _value;
+};
+
+/**
+ * Static description of a field, schemas of many fields are declared as
+ * `static const` tables and registered by `cmc_config_add_schema`. Name
+ * and default value are borrowed, not copied, so the table has to outlive
+ * the config. Default value points to `int` or NUL terminated string.
+ * Array has exactly one child, the prototype of its elements.
+ */
+struct cmc_ConfigFieldDescriptor {
+  const char *name;
+  enum cmc_ConfigFieldTypeEnum type;
+  const void *default_value;
+  bool optional;
+  const struct cmc_ConfigFieldDescriptor *children;
+  uint32_t children_len;
+  // Array of dicts only, member to index elements by, see
+  //  `cmc_field_array_index`. NULL for none.
+  const char *index_by;
 };
 
 /**
  * Create a new configuration field.
- * Allocates memory and stores optional default value.
+ * Allocates memory and stores optional default value. Memory comes from
+ * the allocator of the calling thread, which is the config's allocator
+ * only while config functions run, libc otherwise, see `allocator` in
+ * `cmc_ConfigSettings`.
  */
 cme_error_t cmc_field_create(const char *name,
                              const enum cmc_ConfigFieldTypeEnum type,
@@ -140,6 +221,58 @@ cme_error_t cmc_field_get_str(const struct cmc_ConfigField *field,
  * Get the parsed integer value of a field.
  */
 cme_error_t cmc_field_get_int(const struct cmc_ConfigField *field, int *output);
+/**
+ * Find a child of a dictionary by key, keys are matched case-insensitively.
+ * Dicts with more than a few children keep a hash table of them, which is
+ * updated as children are added, so lookups do not scan.
+ */
+cme_error_t cmc_field_dict_get(const struct cmc_ConfigField *field,
+                               const char *key,
+                               struct cmc_ConfigField **child);
+/**
+ * Number of elements of an array. Parsing keeps the prototype of an array
+ * which got no values, it is not counted.
+ */
+cme_error_t cmc_field_array_len(const struct cmc_ConfigField *field,
+                                uint32_t *len);
+/**
+ * Get the element at `index` of an array of integers or strings, without
+ * iterating.
+ */
+cme_error_t cmc_field_array_get_int(const struct cmc_ConfigField *field,
+                                    const uint32_t index, int *output);
+cme_error_t cmc_field_array_get_str(const struct cmc_ConfigField *field,
+                                    const uint32_t index, char **output);
+/**
+ * Parsed arrays of integers store values of all their elements in one
+ * contiguous buffer and have no element fields. `ints` receives the
+ * buffer and `len` it's length, buffer is valid until the array is parsed
+ * again or a subfield is added to it. Arrays which were not parsed have
+ * no buffer, they fail with ENODATA.
+ */
+cme_error_t cmc_field_array_ints(const struct cmc_ConfigField *field,
+                                 const int32_t **ints, uint32_t *len);
+/**
+ * Declare an index on an array of dicts, keyed by value of the member
+ * `key` of it's elements, which has to be a string or an integer. The
+ * index is built every time the array is parsed, so
+ * `cmc_field_array_find` does not scan the elements. Elements without
+ * the member are not indexed, of elements with equal values the first
+ * one is found.
+ */
+cme_error_t cmc_field_array_index(struct cmc_ConfigField *field,
+                                  const char *key);
+/**
+ * Find the element of an array of dicts whose member `key` equals
+ * `value`. Arrays without an index on `key`, or not parsed since it was
+ * declared or since a subfield was added to them, are scanned.
+ */
+cme_error_t cmc_field_array_find(const struct cmc_ConfigField *field,
+                                 const char *key, const char *value,
+                                 struct cmc_ConfigField **element);
+cme_error_t cmc_field_array_find_int(const struct cmc_ConfigField *field,
+                                     const char *key, const int value,
+                                     struct cmc_ConfigField **element);
 
 /**
  * Convert a tree node pointer back to its containing field.
@@ -156,13 +289,26 @@ struct cmc_ConfigField *cmc_field_of_node(struct cmc_TreeNode *node_ptr);
   }
 
 /**
- * Specialized iterator for array of scalar types.
+ * Value of the element at `index` of an array, NULL if it has none.
+ * `index` has to be below the array's length.
+ */
+void *cmc_field_array_value(const struct cmc_ConfigField *field,
+                            const uint32_t index);
+
+/**
+ * Specialized iterator for array of scalar types. Parsed arrays have no
+ * element fields, `__var_subfield` is then the array's prototype.
  */
 #define CMC_FOREACH_FIELD_ARRAY(var, type, field, func)                        \
-  CMC_TREE_SUBNODES_FOREACH(__##var##subnode, ((*(field))->_self)) {           \
+  for (uint32_t __##var##_i = 0; __##var##_i < (*(field))->_array_len;         \
+       __##var##_i++) {                                                        \
     struct cmc_ConfigField *__##var##_subfield =                               \
-        cmc_field_of_node(__##var##subnode);                                   \
-    type var = __##var##_subfield->value;                                      \
+        cmc_field_of_node((*(field))->_self.subnodes                           \
+                              [(*(field))->_ints || (*(field))->_strs          \
+                                   ? 0                                         \
+                                   : __##var##_i]);                            \
+    type var = cmc_field_array_value(*(field), __##var##_i);                   \
+    (void)__##var##_subfield;                                                  \
     func                                                                       \
   }
 
@@ -192,6 +338,71 @@ enum cmc_LogLevelEnum {
   cmc_LogLevelEnum_DEBUG,
 };
 
+/**
+ * How a configuration file is loaded before parsing.
+ *  - READ copies the whole file into a heap buffer.
+ *  - MMAP maps the file read-only, values are copied only once they are
+ *    stored in a field.
+ */
+enum cmc_InputModeEnum {
+  cmc_InputModeEnum_READ,
+  cmc_InputModeEnum_MMAP,
+};
+
+/**
+ * Where memory of fields and parsed values comes from.
+ *  - HEAP allocates every name, value and subfield vector separately.
+ *  - ARENA places fields created by `cmc_config_field_create` and
+ *    everything parsed into them in big blocks owned by the config. They
+ *    are released at once by `cmc_config_destroy`, or kept for reuse by
+ *    `cmc_config_reset`.
+ *  - STATIC is ARENA over memory supplied by the caller in
+ *    `static_memory`, nothing is allocated from the heap. The config
+ *    itself, it's settings, fields and parsed values are placed there.
+ *    Parser temporaries use `scratch_memory` if it is given, so they are
+ *    dropped after each parse, otherwise they stay in `static_memory`
+ *    until `cmc_config_reset`. Functions fail with ENOMEM once the memory
+ *    is used up. Input is tokenized by a single thread.
+ */
+enum cmc_MemoryModeEnum {
+  cmc_MemoryModeEnum_HEAP,
+  cmc_MemoryModeEnum_ARENA,
+  cmc_MemoryModeEnum_STATIC,
+};
+
+/**
+ * How parsed string values are stored.
+ *  - COPY gives every field it's own copy of the value.
+ *  - SHARED hash-conses values in a process wide store, equal values of
+ *    all fields and configs share one reference counted copy, so they are
+ *    equal only if their pointers are. Shared values are read-only. Can
+ *    be combined with HEAP memory mode only. Elements of arrays of
+ *    strings are copied into the array's buffer, see `_strs`.
+ */
+enum cmc_ValueModeEnum {
+  cmc_ValueModeEnum_COPY,
+  cmc_ValueModeEnum_SHARED,
+};
+
+/**
+ * Heap allocator of a config, set in `cmc_ConfigSettings`. Hooks get `ctx`
+ * as their last argument, NULL hook falls back to libc, so an allocator
+ * without hooks only counts. Counters are maintained by the library,
+ * `allocations` counts malloc and realloc calls, `bytes` is memory in use
+ * and `peak_bytes` it's maximum. Memory is freed through the allocator it
+ * came from, so the allocator has to outlive every config, field and
+ * frozen snapshot using it. Not thread safe, use one allocator per config.
+ */
+struct cmc_Allocator {
+  void *(*malloc)(size_t size, void *ctx);
+  void *(*realloc)(void *ptr, size_t size, void *ctx);
+  void (*free)(void *ptr, void *ctx);
+  void *ctx;
+  uint64_t allocations;
+  size_t bytes;
+  size_t peak_bytes;
+};
+
 /**
  * Configuration system settings (parsing context).
  */
@@ -200,6 +411,21 @@ struct cmc_ConfigSettings {
   uint32_t paths_length;
   char *name;
   void (*log_func)(enum cmc_LogLevelEnum log_level, char *msg);
+  enum cmc_InputModeEnum input_mode;
+  enum cmc_MemoryModeEnum memory_mode;
+  enum cmc_ValueModeEnum value_mode;
+  // Threads used to tokenize big `.env` files, 0 or 1 parses in the
+  //  calling thread. Result does not depend on the number of threads.
+  uint32_t threads;
+  // Memory owned by the caller for STATIC memory mode, it has to outlive
+  //  the config. Scratch memory is optional.
+  void *static_memory;
+  size_t static_memory_size;
+  void *scratch_memory;
+  size_t scratch_memory_size;
+  // Heap allocator used while config functions run, NULL means libc.
+  //  Fields created by `cmc_field_create` outside of them use libc.
+  struct cmc_Allocator *allocator;
 };
 
 /**
@@ -209,28 +435,226 @@ struct cmc_ConfigSettings {
 struct cmc_Config {
   struct cmc_ConfigSettings *settings;
   struct cmc_TreeNode _fields;
+  // Parser and it's state while push parsing is in progress.
+  struct cmc_ConfigParseInterface *_parser;
+  void *_parser_state;
+  // Memory of fields in ARENA and STATIC memory modes, NULL otherwise.
+  struct cmc_Arena *_arena;
+  // Memory of parser temporaries in STATIC memory mode, NULL otherwise.
+  struct cmc_Arena *_scratch;
+  // Blocks of fields added by `cmc_config_add_schema` in HEAP memory mode.
+  struct cmc_ConfigSchema *_schemas;
+  // Index of fields built by parsing, see `cmc_config_get`. Dropped when
+  //  the schema changes.
+  struct cmc_Lookup *_lookup;
+  // Shape of the last index, generation is bumped when it changes.
+  uint64_t _shape;
+  uint32_t _generation;
 };
 
 /**
  * Create a new configuration context.
- * Allocates memory and copies the provided settings.
+ * Allocates memory and copies the provided settings. In STATIC memory
+ * mode the config is placed in `settings->static_memory`.
  */
 cme_error_t cmc_config_create(const struct cmc_ConfigSettings *settings,
                               struct cmc_Config **config);
+/**
+ * Same as `cmc_field_create`, but the field is allocated from memory of
+ * the config, see `cmc_MemoryModeEnum`. Such field belongs to the config
+ * and is released together with it, it can only be added to the config
+ * or to other fields created by this function.
+ */
+cme_error_t cmc_config_field_create(const char *name,
+                                    const enum cmc_ConfigFieldTypeEnum type,
+                                    const void *default_value,
+                                    const bool optional,
+                                    struct cmc_Config *config,
+                                    struct cmc_ConfigField **field);
+/**
+ * Drop all fields of the config, so the schema can be built and parsed
+ * again. In ARENA memory mode memory is kept for reuse instead of being
+ * returned to the system.
+ */
+void cmc_config_reset(struct cmc_Config *config);
 /**
  * Add a top-level field to the configuration schema.
  */
 cme_error_t cmc_config_add_field(struct cmc_ConfigField *field,
                                  struct cmc_Config *config);
+/**
+ * Add top-level fields described by `descriptors`, together with their
+ * children, to the configuration schema. All fields are placed in one
+ * block owned by the config, `fields` receives it, `(*fields)[i]`
+ * belongs to `descriptors[i]`. `fields` may be NULL.
+ */
+cme_error_t
+cmc_config_add_schema(const struct cmc_ConfigFieldDescriptor *descriptors,
+                      const uint32_t descriptors_len,
+                      struct cmc_Config *config,
+                      struct cmc_ConfigField **fields);
 /**
  * Parse configuration from disk into fields values.
  * Automatically selects the best parser (e.g. `.env`).
  */
 cme_error_t cmc_config_parse(struct cmc_Config *config);
 
+/**
+ * Push-style parsing, for config arriving in pieces (pipe, socket).
+ * Bytes are fed in chunks of any size, lines may be split between chunks.
+ * Values are bound to fields by `cmc_config_parse_end`. If feeding fails
+ * parsing is aborted and has to start over with `cmc_config_parse_begin`.
+ */
+cme_error_t cmc_config_parse_begin(struct cmc_Config *config);
+cme_error_t cmc_config_parse_feed(const char *buffer, const size_t buffer_len,
+                                  struct cmc_Config *config);
+cme_error_t cmc_config_parse_end(struct cmc_Config *config);
+
+/**
+ * Find a field by path of names separated by `.`, array elements are
+ * selected by `[index]`, like `dhcp4.subnet4[3].pools[0].pool`. Names are
+ * matched case-insensitively. After parsing each segment costs one probe
+ * of a hash index and nothing is allocated. Until the first parse, or
+ * after fields are added to the config, children are scanned instead.
+ * Subfields added to parsed fields are indexed by the next parse.
+ * Elements of parsed arrays of integers and strings have no fields, they
+ * are read by `cmc_config_get_str` and `cmc_config_get_int` only.
+ */
+cme_error_t cmc_config_get(const struct cmc_Config *config, const char *path,
+                           struct cmc_ConfigField **field);
+/**
+ * Same as `cmc_field_get_str` and `cmc_field_get_int` for a field found by
+ * `cmc_config_get`, field of another type is rejected.
+ */
+cme_error_t cmc_config_get_str(const struct cmc_Config *config,
+                               const char *path, char **output);
+cme_error_t cmc_config_get_int(const struct cmc_Config *config,
+                               const char *path, int *output);
+
+/**
+ * Field resolved once by `cmc_config_handle_init`, for fields read over
+ * and over. Parsing gives every field a dense id, handle reads the field
+ * of it's id straight from an array. Handles survive reloads, a reload
+ * which changes shape of the config, that is names, types or array
+ * lengths, bumps config's generation and the handle resolves `path`
+ * again on next read. `path` is borrowed and has to outlive the handle.
+ */
+struct cmc_FieldHandle {
+  const char *path;
+  uint32_t id;
+  uint32_t generation;
+  // Index of an element of a parsed array of integers or strings, which
+  //  has no field, `id` is then the array's. UINT32_MAX for fields.
+  uint32_t element;
+};
+
+cme_error_t cmc_config_handle_init(const struct cmc_Config *config,
+                                   const char *path,
+                                   struct cmc_FieldHandle *handle);
+cme_error_t cmc_config_handle_get(const struct cmc_Config *config,
+                                  struct cmc_FieldHandle *handle,
+                                  struct cmc_ConfigField **field);
+cme_error_t cmc_config_handle_get_str(const struct cmc_Config *config,
+                                      struct cmc_FieldHandle *handle,
+                                      char **output);
+cme_error_t cmc_config_handle_get_int(const struct cmc_Config *config,
+                                      struct cmc_FieldHandle *handle,
+                                      int *output);
+
 /**
  * Free all memory associated with the configuration object.
  */
 void cmc_config_destroy(struct cmc_Config **config);
 
+/******************************************************************************
+ *                             Frozen config
+ ******************************************************************************/
+
+/**
+ * Read-only snapshot of a parsed config, for big or long lived configs.
+ * Fields live in one contiguous array and are linked by 32-bit indices,
+ * children of a field are stored next to each other. Names and string
+ * values are kept in a separate string table, integers are stored inline.
+ * Field 0 is the root, which holds top-level fields, index 0 also marks
+ * missing child or sibling.
+ */
+#define CMC_FROZEN_NONE 0
+
+#define CMC_FROZEN_TYPE_MASK 0x0f
+#define CMC_FROZEN_FLAG_OPTIONAL 0x10
+#define CMC_FROZEN_FLAG_HAS_VALUE 0x20
+
+struct cmc_FrozenField {
+  uint32_t name;  // Offset in `strings`
+  uint32_t value; // Offset in `strings`, or the value itself for INT
+  uint32_t first_child;
+  uint32_t next_sibling;
+  uint8_t flags; // Type in `CMC_FROZEN_TYPE_MASK` and `CMC_FROZEN_FLAG_*`
+};
+
+struct cmc_FrozenConfig {
+  struct cmc_FrozenField *fields;
+  uint32_t fields_len;
+  char *strings;
+  uint32_t strings_len;
+  // Names are front-coded, see `cmc_config_freeze_compact`.
+  bool is_compact;
+};
+
+/**
+ * Build a frozen snapshot of the config, usually right after parsing. The
+ * snapshot is independent of the config, which can be destroyed.
+ */
+cme_error_t cmc_config_freeze(const struct cmc_Config *config,
+                              struct cmc_FrozenConfig **frozen);
+
+/**
+ * Same as `cmc_config_freeze` but names are front-coded. Siblings are split
+ * in runs of `CMC_FROZEN_RUN_LEN`, every name keeps only the part which
+ * differs from the first name of it's run. Flattened names of array
+ * elements, like `SUBNET4_123_OPTION_DATA_5`, shrink to a few bytes. Names
+ * are compared in compressed form and decoded by `cmc_frozen_read_name`.
+ */
+#define CMC_FROZEN_RUN_LEN 16
+
+cme_error_t cmc_config_freeze_compact(const struct cmc_Config *config,
+                                      struct cmc_FrozenConfig **frozen);
+void cmc_frozen_destroy(struct cmc_FrozenConfig **frozen);
+
+/**
+ * Find a child of `parent` by name, use `CMC_FROZEN_NONE` as parent to
+ * search top-level fields. Names are matched ignoring case.
+ */
+cme_error_t cmc_frozen_find(const struct cmc_FrozenConfig *frozen,
+                            const uint32_t parent, const char *name,
+                            uint32_t *field);
+/**
+ * Name of the field, NULL for compact snapshots, which have no plain copy
+ * of it.
+ */
+const char *cmc_frozen_get_name(const struct cmc_FrozenConfig *frozen,
+                                const uint32_t field);
+/**
+ * Copy NULL terminated name of the field into `buffer`, works for both
+ * plain and compact snapshots.
+ */
+cme_error_t cmc_frozen_read_name(const struct cmc_FrozenConfig *frozen,
+                                 const uint32_t field, char *buffer,
+                                 const size_t buffer_len);
+enum cmc_ConfigFieldTypeEnum
+cmc_frozen_get_type(const struct cmc_FrozenConfig *frozen,
+                    const uint32_t field);
+cme_error_t cmc_frozen_get_str(const struct cmc_FrozenConfig *frozen,
+                               const uint32_t field, const char **output);
+cme_error_t cmc_frozen_get_int(const struct cmc_FrozenConfig *frozen,
+                               const uint32_t field, int *output);
+
+/**
+ * Iterate over children of a frozen field, `CMC_FROZEN_NONE` iterates over
+ * top-level fields.
+ */
+#define CMC_FROZEN_FOREACH(var, frozen, parent)                                \
+  for (uint32_t var = (frozen)->fields[(parent)].first_child;                  \
+       var != CMC_FROZEN_NONE; var = (frozen)->fields[var].next_sibling)
+
 #endif // C_MINILIB_CONFIG_H
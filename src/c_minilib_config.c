@@ -18,8 +18,11 @@
 
 #include "cmc_parse_interface/cmc_env_parser/cmc_env_parser.h"
 #include "cmc_parse_interface/cmc_parse_interface.h"
+#include "utils/cmc_arena.h"
 #include "utils/cmc_common.h"
 #include "utils/cmc_field.h"
+#include "utils/cmc_heap.h"
+#include "utils/cmc_lookup.h"
 #include "utils/cmc_settings.h"
 #include "utils/cmc_string.h"
 #include "utils/cmc_tree.h"
@@ -27,6 +30,26 @@
 static struct cmc_ConfigParseInterface parsers[cmc_ConfigParseFormat_MAX];
 static int32_t parsers_length = 0;
 
+// Fields added by `cmc_config_add_schema` share one block, they are marked
+//  as borrowed and the block is freed by reset after them.
+struct cmc_ConfigSchema {
+  struct cmc_ConfigSchema *next;
+  struct cmc_ConfigField fields[];
+};
+
+static void cmc_config_scratch_reset(struct cmc_Config *config);
+static cme_error_t cmc_config_index(struct cmc_Config *config);
+static struct cmc_Allocator *
+cmc_config_use_allocator(const struct cmc_Config *config);
+static cme_error_t
+cmc_config_schema_len(const struct cmc_ConfigFieldDescriptor *descriptors,
+                      const uint32_t descriptors_len, uint64_t *fields_len);
+static cme_error_t
+cmc_config_schema_init(const struct cmc_ConfigFieldDescriptor *descriptors,
+                       const uint32_t descriptors_len, struct cmc_Arena *arena,
+                       struct cmc_ConfigField *fields,
+                       struct cmc_ConfigField **free_fields);
+
 cme_error_t cmc_lib_init(void) {
 
   cme_error_t err;
@@ -56,42 +79,129 @@ void cmc_lib_destroy(void) { cme_destroy(); }
 cme_error_t cmc_config_create(const struct cmc_ConfigSettings *settings,
                               struct cmc_Config **config) {
   struct cmc_Config *local_config;
+  struct cmc_Arena *arena = NULL;
   cme_error_t err;
+  struct cmc_Allocator *allocator =
+      cmc_heap_use(settings ? settings->allocator : NULL);
 
   if (!config) {
     err = cme_error(EINVAL, "`config` cannot be NULL");
     goto error_out;
   }
 
-  local_config = malloc(sizeof(struct cmc_Config));
+  // In STATIC memory mode even the config and it's settings are placed in
+  //  caller's memory.
+  if (settings && settings->memory_mode == cmc_MemoryModeEnum_STATIC) {
+    err = cmc_arena_create_static(settings->static_memory,
+                                  settings->static_memory_size, &arena);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  local_config = cmc_alloc(arena, sizeof(struct cmc_Config));
   if (!local_config) {
     err = cme_error(ENOMEM, "Unable to allocate memory for `local_config`");
     goto error_out;
   }
 
+  local_config->_parser = NULL;
+  local_config->_parser_state = NULL;
+  local_config->_arena = arena;
+  local_config->_scratch = NULL;
+  local_config->_schemas = NULL;
+  local_config->_lookup = NULL;
+  local_config->_shape = 0;
+  local_config->_generation = 0;
+
   err = cmc_tree_node_create(&local_config->_fields);
   if (err) {
     goto error_config_cleanup;
   }
 
   if (!settings) {
-    err = cmc_settings_create(0, NULL, NULL, NULL, &local_config->settings);
+    err = cmc_settings_create(arena, 0, NULL, NULL, NULL,
+                              &local_config->settings);
   } else {
     err = cmc_settings_create(
-        settings->paths_length, (const char **)settings->supported_paths,
+        arena, settings->paths_length, (const char **)settings->supported_paths,
         settings->name, settings->log_func, &local_config->settings);
   }
   if (err) {
     goto error_config_cleanup;
   }
 
+  if (settings) {
+    local_config->settings->input_mode = settings->input_mode;
+    local_config->settings->memory_mode = settings->memory_mode;
+    local_config->settings->value_mode = settings->value_mode;
+    local_config->settings->threads = settings->threads;
+    local_config->settings->static_memory = settings->static_memory;
+    local_config->settings->static_memory_size = settings->static_memory_size;
+    local_config->settings->scratch_memory = settings->scratch_memory;
+    local_config->settings->scratch_memory_size =
+        settings->scratch_memory_size;
+    local_config->settings->allocator = settings->allocator;
+  }
+
+  // Arena is dropped without visiting fields, so they could not release
+  //  their shared values.
+  switch (local_config->settings->value_mode) {
+  case cmc_ValueModeEnum_COPY:
+    break;
+  case cmc_ValueModeEnum_SHARED:
+    if (local_config->settings->memory_mode != cmc_MemoryModeEnum_HEAP) {
+      err = cme_error(EINVAL, "SHARED `value_mode` can be used in HEAP "
+                              "`memory_mode` only");
+      goto error_settings_cleanup;
+    }
+    break;
+  default:
+    err = cme_errorf(EINVAL, "Unrecognized `value_mode=%d`",
+                     local_config->settings->value_mode);
+    goto error_settings_cleanup;
+  }
+
+  switch (local_config->settings->memory_mode) {
+  case cmc_MemoryModeEnum_HEAP:
+    break;
+  case cmc_MemoryModeEnum_ARENA:
+    err = cmc_arena_create(0, &local_config->_arena);
+    if (err) {
+      goto error_settings_cleanup;
+    }
+    break;
+  case cmc_MemoryModeEnum_STATIC:
+    // Config and settings survive reset, only fields are dropped.
+    cmc_arena_keep(local_config->_arena);
+    local_config->_scratch = local_config->_arena;
+    if (local_config->settings->scratch_memory) {
+      err = cmc_arena_create_static(local_config->settings->scratch_memory,
+                                    local_config->settings->scratch_memory_size,
+                                    &local_config->_scratch);
+      if (err) {
+        goto error_settings_cleanup;
+      }
+    }
+    break;
+  default:
+    err = cme_errorf(EINVAL, "Unrecognized `memory_mode=%d`",
+                     local_config->settings->memory_mode);
+    goto error_settings_cleanup;
+  }
+
   *config = local_config;
 
+  cmc_heap_use(allocator);
   return NULL;
 
+error_settings_cleanup:
+  cmc_settings_destroy(arena, &local_config->settings);
 error_config_cleanup:
-  free(local_config);
+  cmc_free(arena, local_config);
+  cmc_arena_destroy(&arena);
 error_out:
+  cmc_heap_use(allocator);
   return cme_return(err);
 };
 
@@ -100,52 +210,229 @@ void cmc_config_destroy(struct cmc_Config **config) {
     return;
   }
 
-  cmc_settings_destroy(&(*config)->settings);
+  if ((*config)->_parser) {
+    (*config)->_parser->parse_abort(&(*config)->_parser_state);
+  }
+
+  // In STATIC memory mode config and settings live in the arena.
+  struct cmc_Arena *arena =
+      (*config)->settings->memory_mode == cmc_MemoryModeEnum_STATIC
+          ? (*config)->_arena
+          : NULL;
+
+  cmc_settings_destroy(arena, &(*config)->settings);
+  cmc_config_reset(*config);
+  cmc_arena_destroy(&(*config)->_scratch);
+  cmc_arena_destroy(&(*config)->_arena);
+
+  cmc_free(arena, *config);
+
+  *config = NULL;
+};
+
+void cmc_config_reset(struct cmc_Config *config) {
+  if (!config) {
+    return;
+  }
+
+  // Fields in arena are not visited at all, their memory is kept and
+  //  handed out again to the next schema.
+  if (config->_arena) {
+    cmc_arena_reset(config->_arena);
+    config->_fields.subnodes = NULL;
+    config->_fields.subnodes_len = 0;
+    config->_fields.subnodes_max = 0;
+    config->_schemas = NULL;
+    config->_lookup = NULL;
+    return;
+  }
+
+  cmc_lookup_destroy(NULL, &config->_lookup);
 
-  CMC_TREE_SUBNODES_FOREACH(subnode, (*config)->_fields) {
+  CMC_TREE_SUBNODES_FOREACH(subnode, config->_fields) {
     struct cmc_ConfigField *subfield = cmc_field_of_node(subnode);
     cmc_field_destroy(&subfield);
   }
 
-  cmc_tree_node_destroy(&(*config)->_fields);
+  cmc_tree_node_destroy(NULL, &config->_fields);
 
-  free(*config);
+  while (config->_schemas) {
+    struct cmc_ConfigSchema *next = config->_schemas->next;
+    cmc_heap_free(config->_schemas);
+    config->_schemas = next;
+  }
+}
+
+cme_error_t cmc_config_field_create(const char *name,
+                                    const enum cmc_ConfigFieldTypeEnum type,
+                                    const void *default_value,
+                                    const bool optional,
+                                    struct cmc_Config *config,
+                                    struct cmc_ConfigField **field) {
+  cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
 
-  *config = NULL;
-};
+  if (!config) {
+    err = cme_error(EINVAL, "`config` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmc_field_create_in(name, type, default_value, optional,
+                            config->_arena, field);
+  if (err) {
+    goto error_out;
+  }
+
+  cmc_heap_use(allocator);
+  return NULL;
+
+error_out:
+  cmc_heap_use(allocator);
+  return cme_return(err);
+}
 
 cme_error_t cmc_config_add_field(struct cmc_ConfigField *field,
                                  struct cmc_Config *config) {
   cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
 
   if (!field || !config) {
     err = cme_error(EINVAL, "`field` and `config` cannot be NULL");
     goto error_out;
   }
 
-  err = cmc_tree_node_add_subnode(&field->_self, &config->_fields);
+  if (field->_arena != config->_arena) {
+    err = cme_error(EINVAL, "`field` has to be created by "
+                            "`cmc_config_field_create` in ARENA and STATIC "
+                            "memory modes");
+    goto error_out;
+  }
+
+  err = cmc_tree_node_add_subnode(config->_arena, &field->_self,
+                                  &config->_fields);
   if (err) {
     goto error_out;
   }
+  cmc_lookup_destroy(config->_arena, &config->_lookup);
 
+  cmc_heap_use(allocator);
   return NULL;
 
 error_out:
+  cmc_heap_use(allocator);
   return cme_return(err);
 };
 
+cme_error_t
+cmc_config_add_schema(const struct cmc_ConfigFieldDescriptor *descriptors,
+                      const uint32_t descriptors_len,
+                      struct cmc_Config *config,
+                      struct cmc_ConfigField **fields) {
+  uint64_t fields_len = 0;
+  cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
+
+  if (!descriptors || !config) {
+    err = cme_error(EINVAL, "`descriptors` and `config` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmc_config_schema_len(descriptors, descriptors_len, &fields_len);
+  if (err) {
+    goto error_out;
+  }
+
+  if (fields_len > (SIZE_MAX - sizeof(struct cmc_ConfigSchema)) /
+                       sizeof(struct cmc_ConfigField)) {
+    err = cme_errorf(EFBIG, "Schema is too big `fields_len=%llu`",
+                     (unsigned long long)fields_len);
+    goto error_out;
+  }
+
+  // Zeroed fields have no subnodes, so cleanup can visit all of them.
+  const size_t schema_size = sizeof(struct cmc_ConfigSchema) +
+                             fields_len * sizeof(struct cmc_ConfigField);
+  struct cmc_ConfigSchema *schema = cmc_alloc(config->_arena, schema_size);
+  if (!schema) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `schema`");
+    goto error_out;
+  }
+  memset(schema, 0, schema_size);
+
+  // Top-level fields go first, children of a field are laid out next to
+  //  each other.
+  struct cmc_ConfigField *free_fields = schema->fields + descriptors_len;
+  err = cmc_config_schema_init(descriptors, descriptors_len, config->_arena,
+                               schema->fields, &free_fields);
+  if (err) {
+    goto error_schema_cleanup;
+  }
+
+  err = cmc_tree_node_reserve_subnodes(
+      config->_arena, &config->_fields,
+      config->_fields.subnodes_len + descriptors_len);
+  if (err) {
+    goto error_schema_cleanup;
+  }
+
+  for (uint32_t i = 0; i < descriptors_len; i++) {
+    err = cmc_tree_node_add_subnode(config->_arena, &schema->fields[i]._self,
+                                    &config->_fields);
+    if (err) {
+      goto error_schema_cleanup;
+    }
+  }
+
+  cmc_lookup_destroy(config->_arena, &config->_lookup);
+
+  if (!config->_arena) {
+    schema->next = config->_schemas;
+    config->_schemas = schema;
+  }
+
+  if (fields) {
+    *fields = schema->fields;
+  }
+
+  cmc_heap_use(allocator);
+  return NULL;
+
+error_schema_cleanup:
+  // Fields of the schema own nothing but their subnodes, dict tables and
+  //  index keys, nothing is parsed into them yet.
+  for (uint64_t i = 0; i < fields_len; i++) {
+    cmc_tree_node_destroy(config->_arena, &schema->fields[i]._self);
+    cmc_free(config->_arena, schema->fields[i]._dict_slots);
+    cmc_free(config->_arena, schema->fields[i]._index_key);
+  }
+  cmc_free(config->_arena, schema);
+error_out:
+  cmc_heap_use(allocator);
+  return cme_return(err);
+}
+
 cme_error_t cmc_config_parse(struct cmc_Config *config) { // NOLINT
   struct cmc_ConfigParseInterface *parser;
   cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
 
   if (!config) {
     err = cme_error(EINVAL, "`config` cannot be NULL");
     goto error_out;
   }
 
+  // Parsing resets memory the push parser state may live in.
+  if (config->_parser) {
+    err = cme_error(EALREADY, "Parsing is already in progress");
+    goto error_out;
+  }
+
   CMC_LOG(config->settings, cmc_LogLevelEnum_DEBUG, // NOLINT
           "Starting configuration file parsing");   // NOLINT
 
+  // Parsing replaces array elements, index of old ones cannot be used.
+  cmc_lookup_destroy(config->_arena, &config->_lookup);
+
   bool matched_parser = false;
 
   CMC_FOREACH_PTR(parser, parsers, parsers_length) {
@@ -169,7 +456,7 @@ cme_error_t cmc_config_parse(struct cmc_Config *config) { // NOLINT
       err = parser->is_format(sizeof(file_path) / sizeof(char), file_path,
                               &matched_parser);
       if (err) {
-        return cme_return(err);
+        goto error_out;
       }
 
       if (matched_parser) {
@@ -178,6 +465,7 @@ cme_error_t cmc_config_parse(struct cmc_Config *config) { // NOLINT
 
         err = parser->parse(sizeof(file_path) / sizeof(char), file_path,
                             parser->data, config);
+        cmc_config_scratch_reset(config);
         if (err) {
           parser->destroy((cmc_ConfigParserData *)parser->data);
           goto error_out;
@@ -202,8 +490,268 @@ cme_error_t cmc_config_parse(struct cmc_Config *config) { // NOLINT
     goto error_out;
   }
 
+  err = cmc_config_index(config);
+  if (err) {
+    goto error_out;
+  }
+
+  cmc_heap_use(allocator);
   return NULL;
 
 error_out:
+  cmc_heap_use(allocator);
   return cme_return(err);
 };
+
+cme_error_t cmc_config_parse_begin(struct cmc_Config *config) {
+  struct cmc_ConfigParseInterface *parser;
+  cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
+
+  if (!config) {
+    err = cme_error(EINVAL, "`config` cannot be NULL");
+    goto error_out;
+  }
+
+  if (config->_parser) {
+    err = cme_error(EALREADY, "Parsing is already in progress");
+    goto error_out;
+  }
+
+  CMC_LOG(config->settings, cmc_LogLevelEnum_DEBUG, // NOLINT
+          "Starting configuration push parsing");   // NOLINT
+
+  // There is no path to pick the format by, first parser supporting push
+  //  parsing is used.
+  CMC_FOREACH_PTR(parser, parsers, parsers_length) {
+    if (!parser->parse_begin) {
+      continue;
+    }
+
+    err = parser->parse_begin(config, &config->_parser_state);
+    if (err) {
+      goto error_out;
+    }
+
+    config->_parser = parser;
+
+    cmc_heap_use(allocator);
+    return NULL;
+  }
+
+  err = cme_error(ENOTSUP, "No parser supports push parsing");
+
+error_out:
+  cmc_heap_use(allocator);
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_parse_feed(const char *buffer, const size_t buffer_len,
+                                  struct cmc_Config *config) {
+  cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
+
+  if (!buffer || !config) {
+    err = cme_error(EINVAL, "`buffer` and `config` cannot be NULL");
+    goto error_out;
+  }
+
+  if (!config->_parser) {
+    err = cme_error(EINVAL, "Parsing was not started by "
+                            "`cmc_config_parse_begin`");
+    goto error_out;
+  }
+
+  err = config->_parser->parse_feed(buffer_len, buffer, config->_parser_state);
+  if (err) {
+    goto error_parser_cleanup;
+  }
+
+  cmc_heap_use(allocator);
+  return NULL;
+
+error_parser_cleanup:
+  config->_parser->parse_abort(&config->_parser_state);
+  config->_parser = NULL;
+  cmc_config_scratch_reset(config);
+error_out:
+  cmc_heap_use(allocator);
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_parse_end(struct cmc_Config *config) {
+  cme_error_t err;
+  struct cmc_Allocator *allocator = cmc_config_use_allocator(config);
+
+  if (!config) {
+    err = cme_error(EINVAL, "`config` cannot be NULL");
+    goto error_out;
+  }
+
+  if (!config->_parser) {
+    err = cme_error(EINVAL, "Parsing was not started by "
+                            "`cmc_config_parse_begin`");
+    goto error_out;
+  }
+
+  struct cmc_ConfigParseInterface *parser = config->_parser;
+  config->_parser = NULL;
+
+  cmc_lookup_destroy(config->_arena, &config->_lookup);
+
+  err = parser->parse_end(&config->_parser_state, config);
+  cmc_config_scratch_reset(config);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmc_config_index(config);
+  if (err) {
+    goto error_out;
+  }
+
+  CMC_LOG(config->settings, cmc_LogLevelEnum_DEBUG, // NOLINT
+          "Finished configuration push parsing");   // NOLINT
+
+  cmc_heap_use(allocator);
+  return NULL;
+
+error_out:
+  cmc_heap_use(allocator);
+  return cme_return(err);
+}
+
+static void cmc_config_scratch_reset(struct cmc_Config *config) {
+  // Parser temporaries in scratch memory of their own are dropped once
+  //  parsing is over.
+  if (config->_scratch != config->_arena) {
+    cmc_arena_reset(config->_scratch);
+  }
+}
+
+// Fields are indexed once parsing is over, so path lookups do not scan.
+//  Handles resolved before keep their ids while shape stays the same.
+static cme_error_t cmc_config_index(struct cmc_Config *config) {
+  cme_error_t err;
+
+  err = cmc_lookup_create(config->_arena, &config->_fields, &config->_lookup);
+  if (err) {
+    goto error_out;
+  }
+
+  // Generation 0 marks unresolved handles.
+  if (config->_generation == 0 || config->_lookup->shape != config->_shape) {
+    config->_shape = config->_lookup->shape;
+    config->_generation =
+        config->_generation == UINT32_MAX ? 1 : config->_generation + 1;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t
+cmc_config_schema_len(const struct cmc_ConfigFieldDescriptor *descriptors,
+                      const uint32_t descriptors_len, uint64_t *fields_len) {
+  cme_error_t err;
+
+  if (descriptors_len && !descriptors) {
+    err = cme_error(EINVAL, "`children` cannot be NULL");
+    goto error_out;
+  }
+
+  *fields_len += descriptors_len;
+  if (*fields_len > UINT32_MAX) {
+    err = cme_error(EFBIG, "Schema cannot have more than UINT32_MAX fields");
+    goto error_out;
+  }
+
+  for (uint32_t i = 0; i < descriptors_len; i++) {
+    err = cmc_config_schema_len(descriptors[i].children,
+                                descriptors[i].children_len, fields_len);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t
+cmc_config_schema_init(const struct cmc_ConfigFieldDescriptor *descriptors,
+                       const uint32_t descriptors_len, struct cmc_Arena *arena,
+                       struct cmc_ConfigField *fields,
+                       struct cmc_ConfigField **free_fields) {
+  cme_error_t err;
+
+  for (uint32_t i = 0; i < descriptors_len; i++) {
+    err = cmc_field_init_borrowed(&descriptors[i], arena, &fields[i]);
+    if (err) {
+      goto error_out;
+    }
+    fields[i]._is_borrowed = true;
+  }
+
+  for (uint32_t i = 0; i < descriptors_len; i++) {
+    const struct cmc_ConfigFieldDescriptor *descriptor = &descriptors[i];
+    // Only child of an array is the prototype of its elements.
+    if (descriptor->type == cmc_ConfigFieldTypeEnum_ARRAY &&
+        descriptor->children_len != 1) {
+      err = cme_errorf(EINVAL,
+                       "Array `name=%s` needs exactly one child, got %u",
+                       descriptor->name, descriptor->children_len);
+      goto error_out;
+    }
+
+    if (!descriptor->children_len) {
+      continue;
+    }
+
+    struct cmc_ConfigField *children = *free_fields;
+    *free_fields += descriptor->children_len;
+
+    err = cmc_tree_node_reserve_subnodes(arena, &fields[i]._self,
+                                         descriptor->children_len);
+    if (err) {
+      goto error_out;
+    }
+
+    err = cmc_config_schema_init(descriptor->children,
+                                 descriptor->children_len, arena, children,
+                                 free_fields);
+    if (err) {
+      goto error_out;
+    }
+
+    for (uint32_t j = 0; j < descriptor->children_len; j++) {
+      err = cmc_field_add_subfield(&fields[i], &children[j]);
+      if (err) {
+        goto error_out;
+      }
+    }
+
+    if (descriptor->index_by) {
+      err = cmc_field_array_index(&fields[i], descriptor->index_by);
+      if (err) {
+        goto error_out;
+      }
+    }
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// Heap memory allocated while a config function runs comes from config's
+//  allocator, the previous allocator is restored on return.
+static struct cmc_Allocator *
+cmc_config_use_allocator(const struct cmc_Config *config) {
+  return cmc_heap_use(config ? config->settings->allocator : NULL);
+}
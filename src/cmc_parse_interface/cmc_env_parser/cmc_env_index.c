@@ -0,0 +1,758 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "c_minilib_config.h"
+#include "cmc_env_index.h"
+#include "cmc_env_lexer.h"
+#include "cmc_env_scan.h"
+#include "utils/cmc_arena.h"
+#include "utils/cmc_hash.h"
+
+// Smallest chunk worth a thread of it's own.
+#define CMC_ENV_INDEX_CHUNK_MIN (64 * 1024)
+
+// Trie node of a key, `_` separated prefix or the whole key.
+struct cmc_EnvIndexSegment {
+  uint32_t name_len;
+  uint32_t hash;
+};
+
+// Token with it's segments, which follow segments of the previous token.
+struct cmc_EnvIndexKey {
+  struct cmc_EnvToken token;
+  uint32_t segments_len;
+};
+
+/*
+ * Part of the buffer tokenized by a worker thread. Chunks start right after
+ * a newline, keys are kept until all chunks are done, so they can be
+ * inserted in buffer order and the last definition still wins. Workers
+ * hash the keys too, inserting them only links the trie nodes.
+ */
+struct cmc_EnvIndexChunk {
+  const char *buffer;
+  uint32_t begin;
+  uint32_t end;
+  struct cmc_EnvScanTable table;
+  struct cmc_EnvLexer lexer;
+  struct cmc_EnvIndexKey *keys;
+  uint32_t keys_len;
+  uint32_t keys_max;
+  struct cmc_EnvIndexSegment *segments;
+  uint32_t segments_len;
+  uint32_t segments_max;
+  // Set if scan, lexing or token storage failed in the worker.
+  bool is_failed;
+  bool is_threaded;
+  pthread_t thread;
+};
+
+struct cmc_EnvIndexEmitData {
+  struct cmc_EnvIndex *index;
+  cme_error_t err;
+};
+
+static cme_error_t cmc_env_index_lex(struct cmc_EnvIndex *index,
+                                     const uint32_t buffer_len,
+                                     const uint32_t threads);
+static cme_error_t cmc_env_index_lex_chunks(struct cmc_EnvIndex *index,
+                                            struct cmc_EnvIndexChunk *chunks,
+                                            const uint32_t chunks_len,
+                                            const uint32_t buffer_len,
+                                            struct cmc_EnvLexer *lexer);
+static void *cmc_env_index_chunk_worker(void *data);
+static bool cmc_env_index_chunk_emit(const struct cmc_EnvToken *token,
+                                     void *data);
+static bool cmc_env_index_emit(const struct cmc_EnvToken *token, void *data);
+static cme_error_t cmc_env_index_feed(struct cmc_EnvIndex *index,
+                                      struct cmc_EnvLexer *lexer,
+                                      const uint32_t begin, const uint32_t end,
+                                      const struct cmc_EnvScanTable *table);
+static cme_error_t cmc_env_index_insert(struct cmc_EnvIndex *index,
+                                        const struct cmc_EnvToken *token);
+static cme_error_t
+cmc_env_index_insert_hashed(struct cmc_EnvIndex *index,
+                            const struct cmc_EnvIndexKey *key,
+                            const struct cmc_EnvIndexSegment *segments);
+static struct cmc_EnvIndexEntry *
+cmc_env_index_link(struct cmc_EnvIndex *index,
+                   struct cmc_EnvIndexEntry *parent,
+                   const uint32_t name_offset, const uint32_t name_len,
+                   const uint32_t hash);
+static void cmc_env_index_set_value(struct cmc_EnvIndexEntry *entry,
+                                    const struct cmc_EnvToken *token);
+static struct cmc_EnvIndexEntry *
+cmc_env_index_upsert(struct cmc_EnvIndex *index, const uint32_t name_offset,
+                     const uint32_t name_len, const uint32_t hash,
+                     bool *created);
+static cme_error_t cmc_env_index_reserve(struct cmc_EnvIndex *index,
+                                         const uint32_t entries_len);
+static cme_error_t cmc_env_index_store_reserve(struct cmc_EnvIndex *index,
+                                               const uint32_t store_len);
+
+cme_error_t cmc_env_index_create(struct cmc_Arena *arena, const char *buffer,
+                                 const size_t buffer_len,
+                                 const uint32_t threads,
+                                 struct cmc_EnvIndex *index) {
+  cme_error_t err;
+
+  if (!buffer || !index) {
+    err = cme_error(EINVAL, "`buffer` and `index` cannot be NULL");
+    goto error_out;
+  }
+
+  if (buffer_len > UINT32_MAX) {
+    err = cme_errorf(EFBIG, "Config is too big `buffer_len=%zu`", buffer_len);
+    goto error_out;
+  }
+
+  // Size the table for one entry per line, prefixes of nested keys grow
+  //  it further. Load factor is kept under 1/2.
+  uint32_t lines_len = 1;
+  const char *line = buffer;
+  while ((line = memchr(line, '\n', buffer_len - (line - buffer)))) {
+    lines_len++;
+    line++;
+  }
+
+  index->arena = arena;
+  index->buffer = buffer;
+  index->entries_max = 16;
+  while (index->entries_max < lines_len * 2) {
+    index->entries_max *= 2;
+  }
+  index->entries_len = 0;
+  index->store = NULL;
+  index->store_len = 0;
+  index->store_max = 0;
+  index->entries = cmc_calloc(index->arena, index->entries_max,
+                              sizeof(struct cmc_EnvIndexEntry));
+  if (!index->entries) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `index->entries`");
+    goto error_out;
+  }
+
+  // Buffer is only read, every name and value is kept as a view into it.
+  err = cmc_env_index_lex(index, buffer_len, threads);
+  if (err) {
+    goto error_entries_cleanup;
+  }
+
+  return NULL;
+
+error_entries_cleanup:
+  cmc_free(index->arena, index->entries);
+  index->entries = NULL;
+error_out:
+  return cme_return(err);
+}
+
+void cmc_env_index_destroy(struct cmc_EnvIndex *index) {
+  if (!index) {
+    return;
+  }
+
+  cmc_free(index->arena, index->entries);
+  cmc_free(index->arena, index->store);
+  index->buffer = NULL;
+  index->entries = NULL;
+  index->entries_len = 0;
+  index->entries_max = 0;
+  index->store = NULL;
+  index->store_len = 0;
+  index->store_max = 0;
+}
+
+cme_error_t cmc_env_index_init(struct cmc_Arena *arena,
+                               struct cmc_EnvIndex *index) {
+  cme_error_t err;
+
+  if (!index) {
+    err = cme_error(EINVAL, "`index` cannot be NULL");
+    goto error_out;
+  }
+
+  index->arena = arena;
+  index->buffer = NULL;
+  index->entries_len = 0;
+  index->entries_max = 16;
+  index->store = NULL;
+  index->store_len = 0;
+  index->store_max = 0;
+  index->entries = cmc_calloc(index->arena, index->entries_max,
+                              sizeof(struct cmc_EnvIndexEntry));
+  if (!index->entries) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `index->entries`");
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_env_index_add(struct cmc_EnvIndex *index, const char *buffer,
+                              const struct cmc_EnvToken *token) {
+  cme_error_t err;
+
+  if (!index || !buffer || !token) {
+    err = cme_error(EINVAL, "`index`, `buffer` and `token` cannot be NULL");
+    goto error_out;
+  }
+
+  if (token->name_len + (uint64_t)token->value_len >
+      UINT32_MAX - index->store_len) {
+    err = cme_errorf(EFBIG, "Config is too big `store_len=%u`",
+                     index->store_len);
+    goto error_out;
+  }
+
+  err = cmc_env_index_store_reserve(index, index->store_len + token->name_len +
+                                               token->value_len);
+  if (err) {
+    goto error_out;
+  }
+
+  // Overridden values stay in the store, it is released as a whole.
+  struct cmc_EnvToken local_token = *token;
+  local_token.name_offset = index->store_len;
+  memcpy(index->store + index->store_len, buffer + token->name_offset,
+         token->name_len);
+  index->store_len += token->name_len;
+
+  local_token.value_offset = index->store_len;
+  memcpy(index->store + index->store_len, buffer + token->value_offset,
+         token->value_len);
+  index->store_len += token->value_len;
+
+  err = cmc_env_index_insert(index, &local_token);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+const struct cmc_EnvIndexEntry *
+cmc_env_index_find(const struct cmc_EnvIndex *index, const char *name,
+                   const uint32_t name_len, const uint64_t name_hash) {
+  if (!index || !name || !index->entries) {
+    return NULL;
+  }
+
+  // Hash compare rejects almost every other key, a single case-insensitive
+  //  compare confirms the match.
+  const uint32_t hash = cmc_hash_finalize(name_hash);
+
+  const uint32_t mask = index->entries_max - 1;
+  for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+    const struct cmc_EnvIndexEntry *entry = &index->entries[i];
+    if (!entry->name_len) {
+      return NULL;
+    }
+
+    if (entry->hash == hash && entry->name_len == name_len &&
+        strncasecmp(index->buffer + entry->name_offset, name, name_len) == 0) {
+      return entry;
+    }
+  }
+}
+
+const char *cmc_env_index_get(const struct cmc_EnvIndex *index,
+                              const char *name, const uint32_t name_len,
+                              const uint64_t name_hash, uint32_t *value_len) {
+  if (!value_len) {
+    return NULL;
+  }
+
+  const struct cmc_EnvIndexEntry *entry =
+      cmc_env_index_find(index, name, name_len, name_hash);
+  if (!entry || !entry->has_value) {
+    return NULL;
+  }
+
+  *value_len = entry->value_len;
+  return index->buffer + entry->value_offset;
+}
+
+static cme_error_t cmc_env_index_lex(struct cmc_EnvIndex *index,
+                                     const uint32_t buffer_len,
+                                     const uint32_t threads) {
+  const char *buffer = index->buffer;
+  struct cmc_EnvScanTable table;
+  struct cmc_EnvLexer lexer;
+  cme_error_t err;
+
+  cmc_env_lexer_init(&lexer);
+
+  uint32_t chunks_len = threads && !index->arena ? threads : 1;
+  if (chunks_len > buffer_len / CMC_ENV_INDEX_CHUNK_MIN) {
+    chunks_len = buffer_len / CMC_ENV_INDEX_CHUNK_MIN;
+  }
+
+  if (chunks_len <= 1) {
+    err = cmc_env_scan_create(index->arena, buffer, buffer_len, &table);
+    if (err) {
+      goto error_out;
+    }
+
+    err = cmc_env_index_feed(index, &lexer, 0, buffer_len, &table);
+    cmc_env_scan_destroy(&table);
+    if (err) {
+      goto error_out;
+    }
+  } else {
+    struct cmc_EnvIndexChunk *chunks =
+        cmc_calloc(NULL, chunks_len, sizeof(struct cmc_EnvIndexChunk));
+    if (!chunks) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `chunks`");
+      goto error_out;
+    }
+
+    err = cmc_env_index_lex_chunks(index, chunks, chunks_len, buffer_len,
+                                   &lexer);
+
+    for (uint32_t i = 0; i < chunks_len; i++) {
+      cmc_env_scan_destroy(&chunks[i].table);
+      cmc_heap_free(chunks[i].keys);
+      cmc_heap_free(chunks[i].segments);
+    }
+    cmc_heap_free(chunks);
+
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  struct cmc_EnvIndexEmitData emit_data = {.index = index, .err = NULL};
+  if (!cmc_env_lexer_end(&lexer, buffer, buffer_len, cmc_env_index_emit,
+                         &emit_data)) {
+    err = emit_data.err ? emit_data.err : cmc_env_lexer_error(&lexer, buffer);
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_env_index_lex_chunks(struct cmc_EnvIndex *index,
+                                            struct cmc_EnvIndexChunk *chunks,
+                                            const uint32_t chunks_len,
+                                            const uint32_t buffer_len,
+                                            struct cmc_EnvLexer *lexer) {
+  const char *buffer = index->buffer;
+  cme_error_t err;
+
+  // Chunks are of similar size, each boundary is moved right after the
+  //  next newline.
+  uint32_t begin = 0;
+  for (uint32_t i = 0; i < chunks_len; i++) {
+    uint32_t end = buffer_len;
+    if (i + 1 < chunks_len) {
+      end = (uint64_t)buffer_len * (i + 1) / chunks_len;
+      end = end < begin ? begin : end;
+      const char *newline = memchr(buffer + end, '\n', buffer_len - end);
+      end = newline ? newline - buffer + 1 : buffer_len;
+    }
+
+    chunks[i].buffer = buffer;
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    begin = end;
+  }
+
+  // Implementation is picked lazily, it has to happen before workers start.
+  cmc_env_scan_get_impl();
+
+  for (uint32_t i = 1; i < chunks_len; i++) {
+    chunks[i].is_threaded = pthread_create(&chunks[i].thread, NULL,
+                                           cmc_env_index_chunk_worker,
+                                           &chunks[i]) == 0;
+  }
+
+  // Calling thread takes the first chunk and any chunk which did not get a
+  //  thread of it's own.
+  for (uint32_t i = 0; i < chunks_len; i++) {
+    if (!chunks[i].is_threaded) {
+      cmc_env_index_chunk_worker(&chunks[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < chunks_len; i++) {
+    if (chunks[i].is_threaded) {
+      pthread_join(chunks[i].thread, NULL);
+    }
+  }
+
+  // Every worker lexed it's chunk as if it started on a fresh line. That
+  //  holds unless the previous chunk ended inside a multi-line quoted
+  //  value, such chunk is lexed again with the carried state. Failed chunk
+  //  is lexed again too, so errors are reported as in single thread.
+  for (uint32_t i = 0; i < chunks_len; i++) {
+    struct cmc_EnvIndexChunk *chunk = &chunks[i];
+
+    if (cmc_env_lexer_is_line_start(lexer) && !chunk->is_failed) {
+      const struct cmc_EnvIndexSegment *segments = chunk->segments;
+      for (uint32_t j = 0; j < chunk->keys_len; j++) {
+        err = cmc_env_index_insert_hashed(index, &chunk->keys[j], segments);
+        if (err) {
+          goto error_out;
+        }
+        segments += chunk->keys[j].segments_len;
+      }
+      *lexer = chunk->lexer;
+      continue;
+    }
+
+    if (chunk->is_failed) {
+      cmc_env_scan_destroy(&chunk->table);
+      if (!cmc_env_scan_range(buffer, chunk->begin, chunk->end,
+                              &chunk->table)) {
+        err = cme_error(ENOMEM,
+                        "Unable to allocate memory for `table->offsets`");
+        goto error_out;
+      }
+    }
+
+    err = cmc_env_index_feed(index, lexer, chunk->begin, chunk->end,
+                             &chunk->table);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static void *cmc_env_index_chunk_worker(void *data) {
+  struct cmc_EnvIndexChunk *chunk = data;
+
+  // Worker never creates errors, failure is only flagged and the chunk is
+  //  handled again by the calling thread.
+  cmc_env_lexer_init(&chunk->lexer);
+  chunk->is_failed =
+      !cmc_env_scan_range(chunk->buffer, chunk->begin, chunk->end,
+                          &chunk->table) ||
+      !cmc_env_lexer_feed(&chunk->lexer, chunk->buffer, chunk->begin,
+                          chunk->end, &chunk->table, cmc_env_index_chunk_emit,
+                          chunk);
+
+  return NULL;
+}
+
+static bool cmc_env_index_chunk_emit(const struct cmc_EnvToken *token,
+                                     void *data) {
+  struct cmc_EnvIndexChunk *chunk = data;
+  const char *name = chunk->buffer + token->name_offset;
+  const uint32_t name_len = token->name_len;
+
+  if (chunk->keys_len == chunk->keys_max) {
+    const uint32_t keys_max = chunk->keys_max ? chunk->keys_max * 2 : 256;
+    struct cmc_EnvIndexKey *local_keys = cmc_heap_realloc(
+        chunk->keys, keys_max * sizeof(struct cmc_EnvIndexKey));
+    if (!local_keys) {
+      return false;
+    }
+
+    chunk->keys = local_keys;
+    chunk->keys_max = keys_max;
+  }
+
+  // Every `_` may end a prefix, the key itself is one more segment.
+  uint32_t segments_len = 1;
+  const char *separator = name;
+  while ((separator =
+              memchr(separator, '_', name_len - (separator - name)))) {
+    segments_len++;
+    separator++;
+  }
+
+  if (segments_len > chunk->segments_max - chunk->segments_len) {
+    uint64_t segments_max = chunk->segments_max ? chunk->segments_max : 1024;
+    while (segments_max < (uint64_t)chunk->segments_len + segments_len) {
+      segments_max *= 2;
+    }
+    if (segments_max > UINT32_MAX) {
+      return false;
+    }
+
+    struct cmc_EnvIndexSegment *local_segments = cmc_heap_realloc(
+        chunk->segments, segments_max * sizeof(struct cmc_EnvIndexSegment));
+    if (!local_segments) {
+      return false;
+    }
+
+    chunk->segments = local_segments;
+    chunk->segments_max = segments_max;
+  }
+
+  // Same single case-folded pass as `cmc_env_index_insert` makes.
+  struct cmc_EnvIndexSegment *segments = chunk->segments + chunk->segments_len;
+  struct cmc_Hash hash = cmc_hash_init();
+  segments_len = 0;
+  for (uint32_t i = 0; i < name_len; i++) {
+    if (name[i] == '_' && i > 0) {
+      segments[segments_len].name_len = i;
+      segments[segments_len++].hash = cmc_hash_finalize(hash.hash);
+    }
+
+    hash.hash = hash.hash * CMC_HASH_BASE + cmc_hash_fold(name[i]);
+  }
+  segments[segments_len].name_len = name_len;
+  segments[segments_len++].hash = cmc_hash_finalize(hash.hash);
+
+  chunk->segments_len += segments_len;
+  chunk->keys[chunk->keys_len].token = *token;
+  chunk->keys[chunk->keys_len++].segments_len = segments_len;
+
+  return true;
+}
+
+static bool cmc_env_index_emit(const struct cmc_EnvToken *token, void *data) {
+  struct cmc_EnvIndexEmitData *emit_data = data;
+
+  emit_data->err = cmc_env_index_insert(emit_data->index, token);
+
+  return emit_data->err == NULL;
+}
+
+static cme_error_t cmc_env_index_feed(struct cmc_EnvIndex *index,
+                                      struct cmc_EnvLexer *lexer,
+                                      const uint32_t begin, const uint32_t end,
+                                      const struct cmc_EnvScanTable *table) {
+  struct cmc_EnvIndexEmitData emit_data = {.index = index, .err = NULL};
+  cme_error_t err;
+
+  if (!cmc_env_lexer_feed(lexer, index->buffer, begin, end, table,
+                          cmc_env_index_emit, &emit_data)) {
+    err = emit_data.err ? emit_data.err
+                        : cmc_env_lexer_error(lexer, index->buffer);
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_env_index_insert(struct cmc_EnvIndex *index,
+                                        const struct cmc_EnvToken *token) {
+  const uint32_t name_offset = token->name_offset;
+  const uint32_t name_len = token->name_len;
+  const char *name = index->buffer + name_offset;
+  struct cmc_EnvIndexEntry *parent = NULL;
+  struct cmc_EnvIndexEntry *entry;
+  cme_error_t err;
+
+  // Every `_` separated prefix of the key becomes a trie node, room for
+  //  all of them is reserved upfront so nodes do not move while linking.
+  uint32_t segments_len = 1;
+  const char *separator = name;
+  while ((separator =
+              memchr(separator, '_', name_len - (separator - name)))) {
+    segments_len++;
+    separator++;
+  }
+
+  err = cmc_env_index_reserve(index, index->entries_len + segments_len);
+  if (err) {
+    goto error_out;
+  }
+
+  // Key is hashed in a single case-folded pass, without lowercasing the
+  //  buffer. Hash of every prefix is a by-product of the same pass.
+  struct cmc_Hash hash = cmc_hash_init();
+  for (uint32_t i = 0; i < name_len; i++) {
+    if (name[i] == '_' && i > 0) {
+      parent = cmc_env_index_link(index, parent, name_offset, i,
+                                  cmc_hash_finalize(hash.hash));
+    }
+
+    hash.hash = hash.hash * CMC_HASH_BASE + cmc_hash_fold(name[i]);
+  }
+
+  entry = cmc_env_index_link(index, parent, name_offset, name_len,
+                             cmc_hash_finalize(hash.hash));
+  cmc_env_index_set_value(entry, token);
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t
+cmc_env_index_insert_hashed(struct cmc_EnvIndex *index,
+                            const struct cmc_EnvIndexKey *key,
+                            const struct cmc_EnvIndexSegment *segments) {
+  struct cmc_EnvIndexEntry *entry = NULL;
+  cme_error_t err;
+
+  err = cmc_env_index_reserve(index, index->entries_len + key->segments_len);
+  if (err) {
+    goto error_out;
+  }
+
+  // Last segment is the key, the ones before it are it's prefixes.
+  for (uint32_t i = 0; i < key->segments_len; i++) {
+    entry = cmc_env_index_link(index, entry, key->token.name_offset,
+                               segments[i].name_len, segments[i].hash);
+  }
+  cmc_env_index_set_value(entry, &key->token);
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// New node is counted as a child of `parent`, the previous prefix.
+static struct cmc_EnvIndexEntry *
+cmc_env_index_link(struct cmc_EnvIndex *index,
+                   struct cmc_EnvIndexEntry *parent,
+                   const uint32_t name_offset, const uint32_t name_len,
+                   const uint32_t hash) {
+  bool created;
+
+  struct cmc_EnvIndexEntry *entry =
+      cmc_env_index_upsert(index, name_offset, name_len, hash, &created);
+  if (created && parent) {
+    parent->children_len++;
+  }
+
+  return entry;
+}
+
+static void cmc_env_index_set_value(struct cmc_EnvIndexEntry *entry,
+                                    const struct cmc_EnvToken *token) {
+  // Later definition of the same key overrides the earlier one.
+  entry->has_value = true;
+  entry->is_escaped = token->is_escaped;
+  entry->value_offset = token->value_offset;
+  entry->value_len = token->value_len;
+}
+
+static struct cmc_EnvIndexEntry *
+cmc_env_index_upsert(struct cmc_EnvIndex *index, const uint32_t name_offset,
+                     const uint32_t name_len, const uint32_t hash,
+                     bool *created) {
+  const char *name = index->buffer + name_offset;
+  const uint32_t mask = index->entries_max - 1;
+
+  for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+    struct cmc_EnvIndexEntry *entry = &index->entries[i];
+    if (!entry->name_len) {
+      entry->name_offset = name_offset;
+      entry->name_len = name_len;
+      entry->hash = hash;
+      index->entries_len++;
+      *created = true;
+      return entry;
+    }
+
+    if (entry->hash == hash && entry->name_len == name_len &&
+        strncasecmp(index->buffer + entry->name_offset, name, name_len) ==
+            0) {
+      *created = false;
+      return entry;
+    }
+  }
+}
+
+static cme_error_t cmc_env_index_reserve(struct cmc_EnvIndex *index,
+                                         const uint32_t entries_len) {
+  cme_error_t err;
+
+  if (entries_len * 2 <= index->entries_max) {
+    return NULL;
+  }
+
+  uint32_t entries_max = index->entries_max;
+  while (entries_len * 2 > entries_max) {
+    entries_max *= 2;
+  }
+
+  struct cmc_EnvIndexEntry *local_entries = cmc_calloc(
+      index->arena, entries_max, sizeof(struct cmc_EnvIndexEntry));
+  if (!local_entries) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `index->entries`");
+    goto error_out;
+  }
+
+  // Entries keep their hash, so rehashing never touches the names.
+  const uint32_t mask = entries_max - 1;
+  for (uint32_t i = 0; i < index->entries_max; i++) {
+    struct cmc_EnvIndexEntry *entry = &index->entries[i];
+    if (!entry->name_len) {
+      continue;
+    }
+
+    uint32_t j = entry->hash & mask;
+    while (local_entries[j].name_len) {
+      j = (j + 1) & mask;
+    }
+    local_entries[j] = *entry;
+  }
+
+  cmc_free(index->arena, index->entries);
+  index->entries = local_entries;
+  index->entries_max = entries_max;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_env_index_store_reserve(struct cmc_EnvIndex *index,
+                                               const uint32_t store_len) {
+  cme_error_t err;
+
+  if (store_len <= index->store_max) {
+    return NULL;
+  }
+
+  uint64_t store_max = index->store_max ? index->store_max : 4096;
+  while (store_max < store_len) {
+    store_max *= 2;
+  }
+  store_max = store_max > UINT32_MAX ? UINT32_MAX : store_max;
+
+  char *local_store =
+      cmc_realloc(index->arena, index->store, index->store_max, store_max);
+  if (!local_store) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `index->store`");
+    goto error_out;
+  }
+
+  // Entries keep offsets, so moving the store does not invalidate them.
+  index->store = local_store;
+  index->store_max = store_max;
+  index->buffer = local_store;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
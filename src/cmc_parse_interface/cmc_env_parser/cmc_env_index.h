@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_ENV_INDEX_H
+#define C_MINILIB_CONFIG_CMC_ENV_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <c_minilib_config.h>
+
+#include "cmc_env_lexer.h"
+
+/*
+ * Key -> value index of a tokenized `.env` buffer. Names and values are
+ * (offset, length) views into the buffer, which is never modified, so the
+ * buffer can be a read-only mapping and has to outlive the index.
+ *
+ * Index is also a segment trie, every `_` separated prefix of a key is an
+ * entry without value which counts it's distinct children. For
+ * `ARR_0_NAME` and `ARR_1_NAME` there are nodes `ARR` (2 children),
+ * `ARR_0`, `ARR_1` and the two keys.
+ */
+struct cmc_EnvIndexEntry {
+  uint32_t name_offset;
+  uint32_t name_len;
+  uint32_t value_offset;
+  uint32_t value_len;
+  uint32_t hash;
+  uint32_t children_len;
+  bool has_value;
+  bool is_escaped;
+};
+
+struct cmc_EnvIndex {
+  // Arena the index memory comes from, NULL means the heap.
+  struct cmc_Arena *arena;
+  const char *buffer;
+  struct cmc_EnvIndexEntry *entries;
+  uint32_t entries_len;
+  uint32_t entries_max;
+  // Index filled by `cmc_env_index_add` owns copies of names and values,
+  //  `buffer` then points to this storage.
+  char *store;
+  uint32_t store_len;
+  uint32_t store_max;
+};
+
+/*
+ * With `threads` above 1 big buffers are split at newlines into chunks
+ * which are scanned, tokenized and have their keys hashed in parallel.
+ * Keys are inserted in buffer order, so the index is the same as with a
+ * single thread. Arena is not thread safe, index in an arena is always
+ * built by one thread.
+ */
+cme_error_t cmc_env_index_create(struct cmc_Arena *arena, const char *buffer,
+                                 const size_t buffer_len,
+                                 const uint32_t threads,
+                                 struct cmc_EnvIndex *index);
+void cmc_env_index_destroy(struct cmc_EnvIndex *index);
+
+/*
+ * Empty index filled token by token, for input which arrives in pieces and
+ * is not kept around. Use `cmc_env_index_destroy` to free it.
+ */
+cme_error_t cmc_env_index_init(struct cmc_Arena *arena,
+                               struct cmc_EnvIndex *index);
+
+/*
+ * Copy name and value of a token lexed from `buffer` into the index, the
+ * buffer may be released afterwards.
+ */
+cme_error_t cmc_env_index_add(struct cmc_EnvIndex *index, const char *buffer,
+                              const struct cmc_EnvToken *token);
+
+/*
+ * Look up a key or prefix node, returns NULL if no key starts with `name`.
+ */
+const struct cmc_EnvIndexEntry *
+cmc_env_index_find(const struct cmc_EnvIndex *index, const char *name,
+                   const uint32_t name_len, const uint64_t name_hash);
+
+/*
+ * `name_hash` is `cmc_hash_str` of the name, callers compose it from
+ * precomputed segment hashes instead of hashing the name again.
+ */
+const char *cmc_env_index_get(const struct cmc_EnvIndex *index,
+                              const char *name, const uint32_t name_len,
+                              const uint64_t name_hash, uint32_t *value_len);
+
+#endif // C_MINILIB_CONFIG_CMC_ENV_INDEX_H
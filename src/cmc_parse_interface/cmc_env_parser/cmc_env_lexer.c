@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_config.h"
+#include "cmc_env_lexer.h"
+#include "cmc_env_scan.h"
+
+enum cmc_EnvLexerClassEnum {
+  cmc_EnvLexerClassEnum_NEWLINE,
+  cmc_EnvLexerClassEnum_SPACE,
+  cmc_EnvLexerClassEnum_EQUAL,
+  cmc_EnvLexerClassEnum_HASH,
+  cmc_EnvLexerClassEnum_SQUOTE,
+  cmc_EnvLexerClassEnum_DQUOTE,
+  cmc_EnvLexerClassEnum_BACKSLASH,
+  cmc_EnvLexerClassEnum_KEY,
+  cmc_EnvLexerClassEnum_OTHER,
+  cmc_EnvLexerClassEnum_MAX,
+};
+
+enum cmc_EnvLexerStateEnum {
+  cmc_EnvLexerStateEnum_LINE,
+  cmc_EnvLexerStateEnum_COMMENT,
+  cmc_EnvLexerStateEnum_KEY,
+  cmc_EnvLexerStateEnum_KEY_END,
+  cmc_EnvLexerStateEnum_VALUE,
+  cmc_EnvLexerStateEnum_VALUE_SPACE,
+  cmc_EnvLexerStateEnum_UNQUOTED,
+  cmc_EnvLexerStateEnum_UNQUOTED_SPACE,
+  cmc_EnvLexerStateEnum_SQUOTE,
+  cmc_EnvLexerStateEnum_DQUOTE,
+  cmc_EnvLexerStateEnum_DQUOTE_ESCAPE,
+  cmc_EnvLexerStateEnum_QUOTE_END,
+  cmc_EnvLexerStateEnum_MAX,
+};
+
+enum cmc_EnvLexerActionEnum {
+  cmc_EnvLexerActionEnum_NONE,
+  cmc_EnvLexerActionEnum_KEY_BEGIN,
+  cmc_EnvLexerActionEnum_KEY_END,
+  cmc_EnvLexerActionEnum_KEY_RESTART,
+  cmc_EnvLexerActionEnum_VALUE_BEGIN,
+  cmc_EnvLexerActionEnum_QUOTE_BEGIN,
+  cmc_EnvLexerActionEnum_ESCAPE,
+  cmc_EnvLexerActionEnum_EMIT,
+  cmc_EnvLexerActionEnum_EMIT_QUOTED,
+  cmc_EnvLexerActionEnum_ERROR_NAME,
+  cmc_EnvLexerActionEnum_ERROR_KEY,
+  cmc_EnvLexerActionEnum_ERROR_DELIMETER,
+  cmc_EnvLexerActionEnum_ERROR_QUOTE,
+};
+
+struct cmc_EnvLexerTransition {
+  uint8_t state;
+  uint8_t action;
+};
+
+#define S(name) cmc_EnvLexerStateEnum_##name
+#define A(name) cmc_EnvLexerActionEnum_##name
+#define T(state, action) {S(state), A(action)}
+
+// Columns: NEWLINE, SPACE, EQUAL, HASH, SQUOTE, DQUOTE, BACKSLASH, KEY,
+//  OTHER.
+static const struct cmc_EnvLexerTransition
+    cmc_env_lexer_transitions[cmc_EnvLexerStateEnum_MAX]
+                             [cmc_EnvLexerClassEnum_MAX] = {
+        [S(LINE)] = {T(LINE, NONE), T(LINE, NONE), T(LINE, ERROR_NAME),
+                     T(COMMENT, NONE), T(LINE, ERROR_KEY), T(LINE, ERROR_KEY),
+                     T(LINE, ERROR_KEY), T(KEY, KEY_BEGIN),
+                     T(LINE, ERROR_KEY)},
+        [S(COMMENT)] = {T(LINE, NONE), T(COMMENT, NONE), T(COMMENT, NONE),
+                        T(COMMENT, NONE), T(COMMENT, NONE), T(COMMENT, NONE),
+                        T(COMMENT, NONE), T(COMMENT, NONE),
+                        T(COMMENT, NONE)},
+        [S(KEY)] = {T(LINE, ERROR_DELIMETER), T(KEY_END, KEY_END),
+                    T(VALUE, KEY_END), T(LINE, ERROR_KEY), T(LINE, ERROR_KEY),
+                    T(LINE, ERROR_KEY), T(LINE, ERROR_KEY), T(KEY, NONE),
+                    T(LINE, ERROR_KEY)},
+        [S(KEY_END)] = {T(LINE, ERROR_DELIMETER), T(KEY_END, NONE),
+                        T(VALUE, NONE), T(LINE, ERROR_DELIMETER),
+                        T(LINE, ERROR_DELIMETER), T(LINE, ERROR_DELIMETER),
+                        T(LINE, ERROR_DELIMETER), T(KEY, KEY_RESTART),
+                        T(LINE, ERROR_DELIMETER)},
+        [S(VALUE)] = {T(LINE, NONE), T(VALUE_SPACE, NONE),
+                      T(UNQUOTED, VALUE_BEGIN), T(UNQUOTED, VALUE_BEGIN),
+                      T(SQUOTE, QUOTE_BEGIN), T(DQUOTE, QUOTE_BEGIN),
+                      T(UNQUOTED, VALUE_BEGIN), T(UNQUOTED, VALUE_BEGIN),
+                      T(UNQUOTED, VALUE_BEGIN)},
+        [S(VALUE_SPACE)] = {T(LINE, NONE), T(VALUE_SPACE, NONE),
+                            T(UNQUOTED, VALUE_BEGIN), T(COMMENT, NONE),
+                            T(SQUOTE, QUOTE_BEGIN), T(DQUOTE, QUOTE_BEGIN),
+                            T(UNQUOTED, VALUE_BEGIN), T(UNQUOTED, VALUE_BEGIN),
+                            T(UNQUOTED, VALUE_BEGIN)},
+        [S(UNQUOTED)] = {T(LINE, EMIT), T(UNQUOTED_SPACE, NONE),
+                         T(UNQUOTED, NONE), T(UNQUOTED, NONE),
+                         T(UNQUOTED, NONE), T(UNQUOTED, NONE),
+                         T(UNQUOTED, NONE), T(UNQUOTED, NONE),
+                         T(UNQUOTED, NONE)},
+        [S(UNQUOTED_SPACE)] = {T(LINE, EMIT), T(UNQUOTED_SPACE, NONE),
+                               T(UNQUOTED, NONE), T(COMMENT, EMIT),
+                               T(UNQUOTED, NONE), T(UNQUOTED, NONE),
+                               T(UNQUOTED, NONE), T(UNQUOTED, NONE),
+                               T(UNQUOTED, NONE)},
+        [S(SQUOTE)] = {T(SQUOTE, NONE), T(SQUOTE, NONE), T(SQUOTE, NONE),
+                       T(SQUOTE, NONE), T(QUOTE_END, EMIT_QUOTED),
+                       T(SQUOTE, NONE), T(SQUOTE, NONE), T(SQUOTE, NONE),
+                       T(SQUOTE, NONE)},
+        [S(DQUOTE)] = {T(DQUOTE, NONE), T(DQUOTE, NONE), T(DQUOTE, NONE),
+                       T(DQUOTE, NONE), T(DQUOTE, NONE),
+                       T(QUOTE_END, EMIT_QUOTED), T(DQUOTE_ESCAPE, ESCAPE),
+                       T(DQUOTE, NONE), T(DQUOTE, NONE)},
+        [S(DQUOTE_ESCAPE)] = {T(DQUOTE, NONE), T(DQUOTE, NONE),
+                              T(DQUOTE, NONE), T(DQUOTE, NONE),
+                              T(DQUOTE, NONE), T(DQUOTE, NONE),
+                              T(DQUOTE, NONE), T(DQUOTE, NONE),
+                              T(DQUOTE, NONE)},
+        [S(QUOTE_END)] = {T(LINE, NONE), T(QUOTE_END, NONE),
+                          T(LINE, ERROR_QUOTE), T(COMMENT, NONE),
+                          T(LINE, ERROR_QUOTE), T(LINE, ERROR_QUOTE),
+                          T(LINE, ERROR_QUOTE), T(LINE, ERROR_QUOTE),
+                          T(LINE, ERROR_QUOTE)},
+};
+
+// In these states every byte which is not structural loops back to the same
+//  state, so lexer jumps straight to the next offset from the scan table.
+static const bool cmc_env_lexer_is_bulk[cmc_EnvLexerStateEnum_MAX] = {
+    [S(COMMENT)] = true,
+    [S(UNQUOTED)] = true,
+    [S(SQUOTE)] = true,
+    [S(DQUOTE)] = true,
+};
+
+#undef T
+#undef A
+#undef S
+
+static inline enum cmc_EnvLexerClassEnum cmc_env_lexer_class(const char c);
+static bool cmc_env_lexer_fail(struct cmc_EnvLexer *lexer, const uint32_t pos,
+                               const char *msg);
+static bool cmc_env_lexer_emit(const char *buffer, struct cmc_EnvToken *token,
+                               const uint32_t value_end, const bool is_quoted,
+                               cmc_env_lexer_emit_func_t emit, void *data);
+
+void cmc_env_lexer_init(struct cmc_EnvLexer *lexer) {
+  memset(lexer, 0, sizeof(struct cmc_EnvLexer));
+  lexer->state = cmc_EnvLexerStateEnum_LINE;
+}
+
+bool cmc_env_lexer_feed(struct cmc_EnvLexer *lexer, const char *buffer,
+                        const uint32_t begin, const uint32_t end,
+                        const struct cmc_EnvScanTable *table,
+                        cmc_env_lexer_emit_func_t emit, void *data) {
+  enum cmc_EnvLexerStateEnum state = lexer->state;
+  struct cmc_EnvToken *token = &lexer->token;
+
+  // Table may cover more than the fed range, lexing starts at the first
+  //  offset not before `begin`.
+  uint32_t offset = 0;
+  uint32_t offsets_end = table->offsets_len;
+  while (offset < offsets_end) {
+    const uint32_t middle = offset + (offsets_end - offset) / 2;
+    if (table->offsets[middle] < begin) {
+      offset = middle + 1;
+    } else {
+      offsets_end = middle;
+    }
+  }
+
+  for (uint32_t pos = begin; pos < end; pos++) {
+    if (cmc_env_lexer_is_bulk[state]) {
+      while (offset < table->offsets_len && table->offsets[offset] < pos) {
+        offset++;
+      }
+
+      uint32_t next = end;
+      if (offset < table->offsets_len && table->offsets[offset] < end) {
+        next = table->offsets[offset];
+      }
+      // Whitespace right before the next structural byte decides whether
+      //  `#` starts a comment, so unquoted value stops one byte earlier.
+      if (state == cmc_EnvLexerStateEnum_UNQUOTED && next > pos) {
+        next--;
+      }
+      if (next > pos) {
+        pos = next;
+      }
+      if (pos >= end) {
+        break;
+      }
+    }
+
+    const struct cmc_EnvLexerTransition transition =
+        cmc_env_lexer_transitions[state][cmc_env_lexer_class(buffer[pos])];
+
+    switch (transition.action) {
+    case cmc_EnvLexerActionEnum_NONE:
+      break;
+    case cmc_EnvLexerActionEnum_KEY_BEGIN:
+      token->name_offset = pos;
+      break;
+    case cmc_EnvLexerActionEnum_KEY_END:
+      token->name_len = pos - token->name_offset;
+      break;
+    case cmc_EnvLexerActionEnum_KEY_RESTART:
+      // Second word on the line is only allowed after `export`.
+      if (token->name_len != 6 ||
+          strncmp(buffer + token->name_offset, "export", 6) != 0) {
+        return cmc_env_lexer_fail(lexer, pos, "Missing `=` after key");
+      }
+      token->name_offset = pos;
+      break;
+    case cmc_EnvLexerActionEnum_VALUE_BEGIN:
+      token->value_offset = pos;
+      token->is_escaped = false;
+      break;
+    case cmc_EnvLexerActionEnum_QUOTE_BEGIN:
+      token->value_offset = pos + 1;
+      token->is_escaped = false;
+      break;
+    case cmc_EnvLexerActionEnum_ESCAPE:
+      token->is_escaped = true;
+      break;
+    case cmc_EnvLexerActionEnum_EMIT:
+    case cmc_EnvLexerActionEnum_EMIT_QUOTED:
+      if (!cmc_env_lexer_emit(
+              buffer, token, pos,
+              transition.action == cmc_EnvLexerActionEnum_EMIT_QUOTED, emit,
+              data)) {
+        return false;
+      }
+      break;
+    case cmc_EnvLexerActionEnum_ERROR_NAME:
+      return cmc_env_lexer_fail(lexer, pos, "Missing key before `=`");
+    case cmc_EnvLexerActionEnum_ERROR_KEY:
+      return cmc_env_lexer_fail(lexer, pos, "Invalid character in key");
+    case cmc_EnvLexerActionEnum_ERROR_DELIMETER:
+      return cmc_env_lexer_fail(lexer, pos, "Missing `=` after key");
+    case cmc_EnvLexerActionEnum_ERROR_QUOTE:
+      return cmc_env_lexer_fail(lexer, pos,
+                                "Unexpected character after closing quote");
+    }
+
+    state = transition.state;
+  }
+
+  lexer->state = state;
+
+  return true;
+}
+
+bool cmc_env_lexer_end(struct cmc_EnvLexer *lexer, const char *buffer,
+                       const uint32_t buffer_len,
+                       cmc_env_lexer_emit_func_t emit, void *data) {
+  const enum cmc_EnvLexerStateEnum state = lexer->state;
+
+  lexer->state = cmc_EnvLexerStateEnum_LINE;
+
+  switch (state) {
+  case cmc_EnvLexerStateEnum_KEY:
+  case cmc_EnvLexerStateEnum_KEY_END:
+    return cmc_env_lexer_fail(lexer, buffer_len, "Missing `=` after key");
+  case cmc_EnvLexerStateEnum_UNQUOTED:
+  case cmc_EnvLexerStateEnum_UNQUOTED_SPACE:
+    return cmc_env_lexer_emit(buffer, &lexer->token, buffer_len, false, emit,
+                              data);
+  case cmc_EnvLexerStateEnum_SQUOTE:
+  case cmc_EnvLexerStateEnum_DQUOTE:
+  case cmc_EnvLexerStateEnum_DQUOTE_ESCAPE:
+    return cmc_env_lexer_fail(lexer, lexer->token.value_offset - 1,
+                              "Unterminated quoted value");
+  default:
+    return true;
+  }
+}
+
+bool cmc_env_lexer_is_line_start(const struct cmc_EnvLexer *lexer) {
+  return lexer->state == cmc_EnvLexerStateEnum_LINE;
+}
+
+cme_error_t cmc_env_lexer_error(const struct cmc_EnvLexer *lexer,
+                                const char *buffer) {
+  if (!lexer->error_msg) {
+    return NULL;
+  }
+
+  // Position is turned into line and column only once there is an error.
+  uint32_t line = lexer->line_base + 1;
+  uint32_t line_offset = 0;
+  for (uint32_t i = 0; i < lexer->error_pos; i++) {
+    if (buffer[i] == '\n') {
+      line++;
+      line_offset = i + 1;
+    }
+  }
+
+  return cme_errorf(EINVAL, "Syntax error at line %u, column %u: %s", line,
+                    lexer->error_pos - line_offset + 1, lexer->error_msg);
+}
+
+uint32_t cmc_env_lexer_unescape(char *value, const uint32_t value_len) {
+  uint32_t j = 0;
+
+  for (uint32_t i = 0; i < value_len; i++, j++) {
+    if (value[i] != '\\' || i + 1 == value_len) {
+      value[j] = value[i];
+      continue;
+    }
+
+    switch (value[i + 1]) {
+    case 'n':
+      value[j] = '\n';
+      break;
+    case 't':
+      value[j] = '\t';
+      break;
+    case 'r':
+      value[j] = '\r';
+      break;
+    case '"':
+    case '\\':
+      value[j] = value[i + 1];
+      break;
+    default:
+      // Unknown escape is kept as is.
+      value[j] = value[i];
+      continue;
+    }
+    i++;
+  }
+
+  return j;
+}
+
+static inline enum cmc_EnvLexerClassEnum cmc_env_lexer_class(const char c) {
+  switch (c) {
+  case '\n':
+    return cmc_EnvLexerClassEnum_NEWLINE;
+  case ' ':
+  case '\t':
+  case '\r':
+    return cmc_EnvLexerClassEnum_SPACE;
+  case '=':
+    return cmc_EnvLexerClassEnum_EQUAL;
+  case '#':
+    return cmc_EnvLexerClassEnum_HASH;
+  case '\'':
+    return cmc_EnvLexerClassEnum_SQUOTE;
+  case '"':
+    return cmc_EnvLexerClassEnum_DQUOTE;
+  case '\\':
+    return cmc_EnvLexerClassEnum_BACKSLASH;
+  case '_':
+  case '.':
+  case '-':
+    return cmc_EnvLexerClassEnum_KEY;
+  default:
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9')) {
+      return cmc_EnvLexerClassEnum_KEY;
+    }
+    return cmc_EnvLexerClassEnum_OTHER;
+  }
+}
+
+static bool cmc_env_lexer_fail(struct cmc_EnvLexer *lexer, const uint32_t pos,
+                               const char *msg) {
+  lexer->error_msg = msg;
+  lexer->error_pos = pos;
+  return false;
+}
+
+static bool cmc_env_lexer_emit(const char *buffer, struct cmc_EnvToken *token,
+                               const uint32_t value_end, const bool is_quoted,
+                               cmc_env_lexer_emit_func_t emit, void *data) {
+  uint32_t local_value_end = value_end;
+
+  // Unquoted value ends before trailing whitespace.
+  if (!is_quoted) {
+    while (local_value_end > token->value_offset &&
+           cmc_env_lexer_class(buffer[local_value_end - 1]) ==
+               cmc_EnvLexerClassEnum_SPACE) {
+      local_value_end--;
+    }
+  }
+
+  token->value_len = local_value_end - token->value_offset;
+
+  return emit(token, data);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_ENV_LEXER_H
+#define C_MINILIB_CONFIG_CMC_ENV_LEXER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <c_minilib_config.h>
+
+#include "cmc_env_scan.h"
+
+/*
+ * Table-driven lexer of the dotenv grammar:
+ *   - `KEY=value`, whitespace around key, `=` and unquoted value is ignored.
+ *   - `export KEY=value`, the `export` prefix is dropped.
+ *   - `# comment` lines and ` # comment` after a value.
+ *   - `'single quoted'` values are taken literally.
+ *   - `"double quoted"` values support `\n`, `\t`, `\r`, `\"` and `\\`.
+ *   - Quoted values may span multiple lines.
+ *   - `KEY=` without value means that key is absent, `KEY=""` is empty.
+ * Tokens are (offset, length) views into the buffer, nothing is allocated
+ * per token. Syntax errors are reported with line and column.
+ */
+struct cmc_EnvToken {
+  uint32_t name_offset;
+  uint32_t name_len;
+  uint32_t value_offset;
+  uint32_t value_len;
+  // Value holds escape sequences, see `cmc_env_lexer_unescape`.
+  bool is_escaped;
+};
+
+/*
+ * Lexer is resumable, buffer may be fed in consecutive ranges and state is
+ * carried between them. It never creates errors by itself so it can run in
+ * worker threads, syntax error is recorded in the lexer and turned into
+ * `cme_error_t` by `cmc_env_lexer_error`.
+ */
+struct cmc_EnvLexer {
+  uint8_t state;
+  struct cmc_EnvToken token;
+  const char *error_msg;
+  uint32_t error_pos;
+  // Lines dropped from the front of the buffer, so errors report lines of
+  //  the whole input.
+  uint32_t line_base;
+};
+
+// Returns false to stop lexing, callback keeps it's own error.
+typedef bool (*cmc_env_lexer_emit_func_t)(const struct cmc_EnvToken *token,
+                                          void *data);
+
+void cmc_env_lexer_init(struct cmc_EnvLexer *lexer);
+
+/*
+ * Lex `buffer[begin, end)`, table has to hold absolute offsets of at least
+ * that range. Returns false on syntax error or when `emit` failed.
+ */
+bool cmc_env_lexer_feed(struct cmc_EnvLexer *lexer, const char *buffer,
+                        const uint32_t begin, const uint32_t end,
+                        const struct cmc_EnvScanTable *table,
+                        cmc_env_lexer_emit_func_t emit, void *data);
+
+/*
+ * Finish lexing at `buffer_len`, buffer does not have to end with a newline.
+ */
+bool cmc_env_lexer_end(struct cmc_EnvLexer *lexer, const char *buffer,
+                       const uint32_t buffer_len,
+                       cmc_env_lexer_emit_func_t emit, void *data);
+
+/*
+ * Lexer is between lines, what follows can be lexed independently.
+ */
+bool cmc_env_lexer_is_line_start(const struct cmc_EnvLexer *lexer);
+
+/*
+ * Syntax error with line and column, NULL if lexer did not fail on syntax.
+ */
+cme_error_t cmc_env_lexer_error(const struct cmc_EnvLexer *lexer,
+                                const char *buffer);
+
+/*
+ * Decode escape sequences of a double quoted value in place, returns new
+ * length of the value.
+ */
+uint32_t cmc_env_lexer_unescape(char *value, const uint32_t value_len);
+
+#endif // C_MINILIB_CONFIG_CMC_ENV_LEXER_H
@@ -6,22 +6,71 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "c_minilib_config.h"
+#include "cmc_env_index.h"
+#include "cmc_env_lexer.h"
 #include "cmc_env_parser.h"
 #include "cmc_parse_interface/cmc_parse_interface.h"
+#include "utils/cmc_arena.h"
 #include "utils/cmc_common.h"
 #include "utils/cmc_field.h"
 #include "utils/cmc_file.h"
+#include "utils/cmc_hash.h"
 #include "utils/cmc_string.h"
 #include "utils/cmc_tree.h"
 
+struct cmc_EnvFile {
+  // Arena a read buffer comes from, NULL means the heap.
+  struct cmc_Arena *arena;
+  char *buffer;
+  size_t buffer_len;
+  bool is_mapped;
+};
+
+// Binding state, `name` holds flattened name of the field being parsed
+//  and `name_hash` it's hash, composed segment by segment.
+struct cmc_EnvParser {
+  const struct cmc_EnvIndex *index;
+  struct cmc_ConfigSettings *settings;
+  struct cmc_Arena *arena;
+  char *name;
+  uint32_t name_len;
+  uint32_t name_max;
+  struct cmc_Hash name_hash;
+  // No key in the file starts with `name`, lookups below it are skipped.
+  bool is_missing;
+  // Arrays whose elements are being parsed. Elements of nested arrays are
+  //  instantiated anew or reset with the outermost array's ones.
+  uint32_t arrays_depth;
+};
+
+// Push parsing state. Bytes of an unfinished line, or of a quoted value
+//  spanning lines, are kept in `pending` until the rest arrives. Complete
+//  tokens are copied into the index and their bytes dropped.
+struct cmc_EnvPushParser {
+  struct cmc_Arena *arena;
+  struct cmc_EnvIndex index;
+  struct cmc_EnvLexer lexer;
+  struct cmc_EnvScanTable table;
+  char *pending;
+  uint32_t pending_len;
+  uint32_t pending_max;
+  // Bytes of `pending` already seen by the lexer.
+  uint32_t lexed;
+  cme_error_t err;
+};
+
 static const char *cmc_env_parser_extension = ".env";
 static cme_error_t cmc_env_parser_create(cmc_ConfigParserData *data);
 static cme_error_t cmc_env_parser_is_format(const size_t n, const char path[n],
@@ -30,31 +79,70 @@ static cme_error_t cmc_env_parser_parse(const size_t n, const char path[n],
                                         const cmc_ConfigParserData data,
                                         struct cmc_Config *config);
 static void cmc_env_parser_destroy(cmc_ConfigParserData *data);
+static cme_error_t cmc_env_parser_parse_begin(struct cmc_Config *config,
+                                              cmc_ConfigParserData *state);
+static cme_error_t cmc_env_parser_parse_feed(const size_t n,
+                                             const char buffer[n],
+                                             const cmc_ConfigParserData state);
+static cme_error_t cmc_env_parser_parse_end(cmc_ConfigParserData *state,
+                                            struct cmc_Config *config);
+static void cmc_env_parser_parse_abort(cmc_ConfigParserData *state);
+static cme_error_t cmc_env_parser_push_lex(struct cmc_EnvPushParser *push,
+                                           const uint32_t end);
+static bool cmc_env_parser_push_emit(const struct cmc_EnvToken *token,
+                                     void *data);
+static cme_error_t cmc_env_parser_bind(const struct cmc_EnvIndex *index,
+                                       struct cmc_Config *config);
+static cme_error_t
+cmc_env_parser_load_file(struct cmc_Arena *arena, const char *file_path,
+                         const enum cmc_InputModeEnum input_mode,
+                         struct cmc_EnvFile *file);
+static cme_error_t cmc_env_parser_read_fd(const int fd,
+                                          struct cmc_EnvFile *file);
+static void cmc_env_parser_unload_file(struct cmc_EnvFile *file);
+static cme_error_t
+cmc_env_parser_name_push(struct cmc_EnvParser *parser, const char *segment,
+                         const uint32_t segment_len,
+                         const struct cmc_Hash segment_hash);
+static void cmc_env_parser_name_pop(struct cmc_EnvParser *parser,
+                                    const uint32_t name_len,
+                                    const struct cmc_Hash name_hash);
+static struct cmc_Hash
+cmc_env_parser_field_hash(const struct cmc_ConfigField *field);
+static cme_error_t cmc_env_parser_parse_field(struct cmc_EnvParser *parser,
+                                              struct cmc_ConfigField *field,
+                                              bool *found_value);
+static cme_error_t
+cmc_env_parser_parse_str_and_int_field(struct cmc_EnvParser *parser,
+                                       struct cmc_ConfigField *field,
+                                       bool *found_value);
+static cme_error_t
+cmc_env_parser_parse_array_field(struct cmc_EnvParser *parser,
+                                 struct cmc_ConfigField *field,
+                                 bool *found_value);
+static cme_error_t
+cmc_env_parser_parse_scalar_array(struct cmc_EnvParser *parser,
+                                  struct cmc_ConfigField *field,
+                                  bool *found_value);
+static cme_error_t
+cmc_env_parser_count_array_elements(struct cmc_EnvParser *parser,
+                                    uint32_t *elements_len);
+static cme_error_t
+cmc_env_parser_find_element(struct cmc_EnvParser *parser,
+                            const uint32_t index,
+                            const struct cmc_EnvIndexEntry **entry);
+static cme_error_t cmc_env_parser_reset_array(struct cmc_ConfigField *field);
 static cme_error_t
-cmc_env_parser_parse_field(FILE *config_file, struct cmc_ConfigField *field,
-                           bool *found_value,
-                           struct cmc_ConfigSettings *settings);
-static cme_error_t cmc_env_parser_parse_str_and_int_field(
-    FILE *config_file, struct cmc_ConfigField *field, bool *found_value,
-    struct cmc_ConfigSettings *settings);
+cmc_env_parser_instantiate_array(struct cmc_ConfigField *field,
+                                 const uint32_t elements_len);
+static cme_error_t cmc_env_parser_truncate_array(struct cmc_ConfigField *field,
+                                                 const uint32_t elements_len);
+static cme_error_t cmc_field_deep_clone(const struct cmc_ConfigField *src,
+                                        struct cmc_ConfigField *dst);
 static cme_error_t
-cmc_env_parser_parse_single_line(char *buffer,        // NOLINT
-                                 uint32_t buffer_max, // NOLINT
-                                 char **name,         // NOLINT
-                                 char **value);       // NOLINT
-static cme_error_t cmc_env_parser_parse_array_field(
-    FILE *config_file, struct cmc_ConfigField *field, bool *found_value,
-    struct cmc_ConfigSettings *settings);
-static char *cmc_env_parser_create_array_name(const char *base_name,
-                                              int32_t index);
-static cme_error_t cmc_field_deep_clone(struct cmc_ConfigField *src,
-                                        struct cmc_ConfigField **dst);
-static void cmc_field_last_destroy(struct cmc_ConfigField *field);
-static cme_error_t cmc_env_parser_parse_dict_field(
-    FILE *config_file, struct cmc_ConfigField *field, bool *found_value,
-    struct cmc_ConfigSettings *settings);
-static char *cmc_env_parser_create_dict_name(const char *dict_name,
-                                             const char *key);
+cmc_env_parser_parse_dict_field(struct cmc_EnvParser *parser,
+                                struct cmc_ConfigField *field,
+                                bool *found_value);
 
 cme_error_t cmc_env_parser_init(struct cmc_ConfigParseInterface *parser) {
   struct cmc_ConfigParseInterface env_parser = {
@@ -63,6 +151,10 @@ cme_error_t cmc_env_parser_init(struct cmc_ConfigParseInterface *parser) {
       .is_format = cmc_env_parser_is_format,
       .parse = cmc_env_parser_parse,
       .destroy = cmc_env_parser_destroy,
+      .parse_begin = cmc_env_parser_parse_begin,
+      .parse_feed = cmc_env_parser_parse_feed,
+      .parse_end = cmc_env_parser_parse_end,
+      .parse_abort = cmc_env_parser_parse_abort,
   };
 
   *parser = env_parser;
@@ -90,76 +182,487 @@ static cme_error_t cmc_env_parser_parse(const size_t n, const char path[n],
                                         const cmc_ConfigParserData data,
                                         struct cmc_Config *config) {
 
-  cme_error_t err;
+  struct cmc_EnvIndex env_index;
+  struct cmc_EnvFile env_file;
   char file_path[PATH_MAX];
+  cme_error_t err;
 
   cmc_join_str_stack(file_path, sizeof(file_path), path,
                      cmc_env_parser_extension);
 
-  FILE *config_file = fopen(file_path, "r");
-  if (!config_file) {
-    err = cme_errorf(EINVAL, "Unable to open %s", file_path);
+  // Temporaries live in the scratch arena, if the config has one.
+  err = cmc_env_parser_load_file(config->_scratch, file_path,
+                                 config->settings->input_mode, &env_file);
+  if (err) {
+    goto error_out;
+  }
+
+  // File is read and tokenized exactly once into a key -> value index,
+  //  which is also a trie of `_` separated key prefixes. Afterwards every
+  //  field is looked up in the index.
+  //  If field is int or str we look up it's name.
+  //  If field is array we walk children `name_0`, `name_1` etc. of it's
+  //    trie node, first missing child ends the array. Nested arrays
+  //    walk children of `name_N` the same way.
+  //  If field is dict without trie node none of it's children is looked up.
+  err = cmc_env_index_create(config->_scratch, env_file.buffer,
+                             env_file.buffer_len, config->settings->threads,
+                             &env_index);
+  if (err) {
+    goto error_file_cleanup;
+  }
+
+  err = cmc_env_parser_bind(&env_index, config);
+  if (err) {
+    CMC_LOG(config->settings, cmc_LogLevelEnum_DEBUG,               // NOLINT
+            "Unable to parse config `file_path=%s`: %s", file_path, // NOLINT
+            err->msg);                                              // NOLINT
+    goto error_index_cleanup;
+  }
+
+  cmc_env_index_destroy(&env_index);
+  cmc_env_parser_unload_file(&env_file);
+
+  return NULL;
+
+error_index_cleanup:
+  cmc_env_index_destroy(&env_index);
+error_file_cleanup:
+  cmc_env_parser_unload_file(&env_file);
+error_out:
+  return cme_return(err);
+}
+
+static void cmc_env_parser_destroy(cmc_ConfigParserData *data){
+
+};
+
+static cme_error_t cmc_env_parser_parse_begin(struct cmc_Config *config,
+                                              cmc_ConfigParserData *state) {
+  cme_error_t err;
+
+  struct cmc_EnvPushParser *push =
+      cmc_calloc(config->_scratch, 1, sizeof(struct cmc_EnvPushParser));
+  if (!push) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `push`");
     goto error_out;
   }
-  // We need for each field to iterate over a config file.
-  //  If field is int or str we try to match it's name.
-  //  If field is array we try to match it's `name_N` once,
-  //    N is matched it proceeds to `name_N+1` etc. Once
-  //    match occurs appropriate value is populated. If we
-  //    have nested array than try to match for `name_0_0`
-  //    and after that `name_N_P` etc. Once there is no
-  //     match we stop looking further.
+
+  push->arena = config->_scratch;
+  push->table.arena = config->_scratch;
+
+  err = cmc_env_index_init(push->arena, &push->index);
+  if (err) {
+    goto error_push_cleanup;
+  }
+
+  cmc_env_lexer_init(&push->lexer);
+
+  *state = push;
+
+  return NULL;
+
+error_push_cleanup:
+  cmc_free(push->arena, push);
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_env_parser_parse_feed(const size_t n,
+                                             const char buffer[n],
+                                             const cmc_ConfigParserData state) {
+  struct cmc_EnvPushParser *push = state;
+  cme_error_t err;
+
+  if (n > UINT32_MAX - push->pending_len) {
+    err = cme_errorf(EFBIG, "Pending input is too big `pending_len=%u`",
+                     push->pending_len);
+    goto error_out;
+  }
+
+  if (push->pending_len + n > push->pending_max) {
+    uint64_t pending_max = push->pending_max ? push->pending_max : 4096;
+    while (pending_max < push->pending_len + n) {
+      pending_max *= 2;
+    }
+    pending_max = pending_max > UINT32_MAX ? UINT32_MAX : pending_max;
+
+    char *local_pending = cmc_realloc(push->arena, push->pending,
+                                      push->pending_max, pending_max);
+    if (!local_pending) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `push->pending`");
+      goto error_out;
+    }
+    push->pending = local_pending;
+    push->pending_max = pending_max;
+  }
+
+  const uint32_t scanned = push->pending_len;
+  memcpy(push->pending + push->pending_len, buffer, n);
+  push->pending_len += n;
+
+  // Only complete lines are lexed, partial one waits for the next chunk.
+  //  Pending bytes past `lexed` hold no newline, so only the new chunk
+  //  is searched.
+  uint32_t end = push->pending_len;
+  while (end > scanned && push->pending[end - 1] != '\n') {
+    end--;
+  }
+  if (end == scanned) {
+    return NULL;
+  }
+
+  err = cmc_env_parser_push_lex(push, end);
+  if (err) {
+    goto error_out;
+  }
+
+  // Outside of a quoted value no token refers to lexed bytes anymore.
+  if (cmc_env_lexer_is_line_start(&push->lexer)) {
+    for (uint32_t i = 0; i < push->lexed; i++) {
+      push->lexer.line_base += push->pending[i] == '\n';
+    }
+
+    push->pending_len -= push->lexed;
+    memmove(push->pending, push->pending + push->lexed, push->pending_len);
+    push->lexed = 0;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_env_parser_parse_end(cmc_ConfigParserData *state,
+                                            struct cmc_Config *config) {
+  struct cmc_EnvPushParser *push = *state;
+  cme_error_t err;
+
+  err = cmc_env_parser_push_lex(push, push->pending_len);
+  if (err) {
+    goto error_push_cleanup;
+  }
+
+  // Input does not have to end with a newline.
+  if (!cmc_env_lexer_end(&push->lexer, push->pending, push->pending_len,
+                         cmc_env_parser_push_emit, push)) {
+    err = push->err ? push->err
+                    : cmc_env_lexer_error(&push->lexer, push->pending);
+    goto error_push_cleanup;
+  }
+
+  err = cmc_env_parser_bind(&push->index, config);
+  if (err) {
+    goto error_push_cleanup;
+  }
+
+  cmc_env_parser_parse_abort(state);
+
+  return NULL;
+
+error_push_cleanup:
+  cmc_env_parser_parse_abort(state);
+  return cme_return(err);
+}
+
+static void cmc_env_parser_parse_abort(cmc_ConfigParserData *state) {
+  struct cmc_EnvPushParser *push = *state;
+
+  if (!push) {
+    return;
+  }
+
+  cmc_env_index_destroy(&push->index);
+  cmc_env_scan_destroy(&push->table);
+  cmc_free(push->arena, push->pending);
+  cmc_free(push->arena, push);
+
+  *state = NULL;
+}
+
+static cme_error_t cmc_env_parser_push_lex(struct cmc_EnvPushParser *push,
+                                           const uint32_t end) {
+  cme_error_t err;
+
+  if (end == push->lexed) {
+    return NULL;
+  }
+
+  push->table.offsets_len = 0;
+  if (!cmc_env_scan_range(push->pending, push->lexed, end, &push->table)) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `table->offsets`");
+    goto error_out;
+  }
+
+  if (!cmc_env_lexer_feed(&push->lexer, push->pending, push->lexed, end,
+                          &push->table, cmc_env_parser_push_emit, push)) {
+    err = push->err ? push->err
+                    : cmc_env_lexer_error(&push->lexer, push->pending);
+    goto error_out;
+  }
+
+  push->lexed = end;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static bool cmc_env_parser_push_emit(const struct cmc_EnvToken *token,
+                                     void *data) {
+  struct cmc_EnvPushParser *push = data;
+
+  push->err = cmc_env_index_add(&push->index, push->pending, token);
+
+  return push->err == NULL;
+}
+
+static cme_error_t cmc_env_parser_bind(const struct cmc_EnvIndex *index,
+                                       struct cmc_Config *config) {
+  cme_error_t err;
+
+  struct cmc_EnvParser env_parser = {
+      .index = index,
+      .settings = config->settings,
+      .arena = config->_scratch,
+      .name_hash = cmc_hash_init(),
+  };
+
   CMC_TREE_SUBNODES_FOREACH(node, config->_fields) {
     struct cmc_ConfigField *field = cmc_field_of_node(node);
     bool found_value = false;
-    err = cmc_env_parser_parse_field(config_file, field, &found_value,
-                                     config->settings);
+
+    err = cmc_env_parser_name_push(&env_parser, field->name,
+                                   strlen(field->name),
+                                   cmc_env_parser_field_hash(field));
     if (err) {
-      CMC_LOG(config->settings, cmc_LogLevelEnum_DEBUG,               // NOLINT
-              "Unable to parse config `file_path=%s`: %s", file_path, // NOLINT
-              err->msg);                                              // NOLINT
-      goto error_file_cleanup;
+      goto error_parser_cleanup;
+    }
+
+    err = cmc_env_parser_parse_field(&env_parser, field, &found_value);
+    cmc_env_parser_name_pop(&env_parser, 0, cmc_hash_init());
+    if (err) {
+      goto error_parser_cleanup;
     }
   }
 
-  fclose(config_file);
+  cmc_free(env_parser.arena, env_parser.name);
 
   return NULL;
 
-error_file_cleanup:
-  fclose(config_file);
+error_parser_cleanup:
+  cmc_free(env_parser.arena, env_parser.name);
+  return cme_return(err);
+}
+
+static cme_error_t
+cmc_env_parser_load_file(struct cmc_Arena *arena, const char *file_path,
+                         const enum cmc_InputModeEnum input_mode,
+                         struct cmc_EnvFile *file) {
+  struct stat file_stat;
+  cme_error_t err;
+
+  int fd = open(file_path, O_RDONLY);
+  if (fd < 0) {
+    err = cme_errorf(EINVAL, "Unable to open %s", file_path);
+    goto error_out;
+  }
+
+  if (fstat(fd, &file_stat) != 0) {
+    err = cme_errorf(errno, "Unable to stat %s", file_path);
+    goto error_fd_cleanup;
+  }
+
+  file->arena = arena;
+  file->buffer = NULL;
+  file->buffer_len = file_stat.st_size;
+  file->is_mapped = false;
+
+  switch (input_mode) {
+  case cmc_InputModeEnum_MMAP:
+    // Empty file cannot be mapped, neither can pipes or procfs files that
+    //  report zero size, these are streamed instead.
+    if (file->buffer_len == 0) {
+      err = cmc_env_parser_read_fd(fd, file);
+      if (err) {
+        goto error_fd_cleanup;
+      }
+      break;
+    }
+
+    file->buffer =
+        mmap(NULL, file->buffer_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file->buffer == MAP_FAILED) {
+      file->buffer = NULL;
+      err = cme_errorf(errno, "Unable to map %s", file_path);
+      goto error_fd_cleanup;
+    }
+    file->is_mapped = true;
+    break;
+
+  case cmc_InputModeEnum_READ:
+    err = cmc_env_parser_read_fd(fd, file);
+    if (err) {
+      goto error_fd_cleanup;
+    }
+    break;
+
+  default:
+    err = cme_errorf(EINVAL, "Unrecognized `input_mode=%d`", input_mode);
+    goto error_fd_cleanup;
+  }
+
+  close(fd);
+
+  return NULL;
+
+error_fd_cleanup:
+  close(fd);
 error_out:
   return cme_return(err);
 }
 
-static void cmc_env_parser_destroy(cmc_ConfigParserData *data){
+static cme_error_t cmc_env_parser_read_fd(const int fd,
+                                          struct cmc_EnvFile *file) {
+  size_t buffer_max = file->buffer_len ? file->buffer_len : 4096;
+  size_t buffer_size = 0;
+  cme_error_t err;
 
-};
+  // Read until EOF into a geometrically growing buffer, size reported by
+  //  stat is only a hint so lines and files of any length are handled.
+  file->buffer = NULL;
+  file->buffer_len = 0;
+  while (true) {
+    if (!file->buffer || file->buffer_len == buffer_max) {
+      if (file->buffer) {
+        buffer_max *= 2;
+      }
+
+      char *local_buffer =
+          cmc_realloc(file->arena, file->buffer, buffer_size, buffer_max);
+      if (!local_buffer) {
+        err = cme_error(ENOMEM, "Unable to allocate memory for `file->buffer`");
+        goto error_buffer_cleanup;
+      }
+      file->buffer = local_buffer;
+      buffer_size = buffer_max;
+    }
+
+    ssize_t ret = read(fd, file->buffer + file->buffer_len,
+                       buffer_max - file->buffer_len);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      err = cme_errorf(errno, "Unable to read config `fd=%d`", fd);
+      goto error_buffer_cleanup;
+    }
+
+    if (ret == 0) {
+      break;
+    }
+
+    file->buffer_len += ret;
+  }
+
+  return NULL;
+
+error_buffer_cleanup:
+  cmc_free(file->arena, file->buffer);
+  file->buffer = NULL;
+  file->buffer_len = 0;
+  return cme_return(err);
+}
+
+static void cmc_env_parser_unload_file(struct cmc_EnvFile *file) {
+  if (!file || !file->buffer) {
+    return;
+  }
+
+  if (file->is_mapped) {
+    munmap(file->buffer, file->buffer_len);
+  } else {
+    cmc_free(file->arena, file->buffer);
+  }
+
+  file->buffer = NULL;
+  file->buffer_len = 0;
+}
 
 static cme_error_t
-cmc_env_parser_parse_field(FILE *config_file, struct cmc_ConfigField *field,
-                           bool *found_value,
-                           struct cmc_ConfigSettings *settings) {
+cmc_env_parser_name_push(struct cmc_EnvParser *parser, const char *segment,
+                         const uint32_t segment_len,
+                         const struct cmc_Hash segment_hash) {
   cme_error_t err;
 
-  CMC_LOG(settings, cmc_LogLevelEnum_DEBUG,                      // NOLINT
+  // Separator, segment and NUL have to fit, buffer grows geometrically so
+  //  names of any length cost amortized O(1) per byte.
+  uint32_t name_len = parser->name_len + (parser->name_len ? 1 : 0);
+  if (name_len + segment_len + 1 > parser->name_max) {
+    uint32_t name_max = parser->name_max ? parser->name_max : 64;
+    while (name_len + segment_len + 1 > name_max) {
+      name_max *= 2;
+    }
+
+    char *local_name =
+        cmc_realloc(parser->arena, parser->name, parser->name_max, name_max);
+    if (!local_name) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `parser->name`");
+      goto error_out;
+    }
+
+    parser->name = local_name;
+    parser->name_max = name_max;
+  }
+
+  if (parser->name_len) {
+    parser->name[parser->name_len] = '_';
+    parser->name_hash =
+        cmc_hash_concat(parser->name_hash, cmc_hash_str("_", 1));
+  }
+  memcpy(parser->name + name_len, segment, segment_len);
+  parser->name_len = name_len + segment_len;
+  parser->name[parser->name_len] = 0;
+  parser->name_hash = cmc_hash_concat(parser->name_hash, segment_hash);
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static void cmc_env_parser_name_pop(struct cmc_EnvParser *parser,
+                                    const uint32_t name_len,
+                                    const struct cmc_Hash name_hash) {
+  parser->name_len = name_len;
+  parser->name_hash = name_hash;
+  if (parser->name) {
+    parser->name[name_len] = 0;
+  }
+}
+
+static cme_error_t cmc_env_parser_parse_field(struct cmc_EnvParser *parser,
+                                              struct cmc_ConfigField *field,
+                                              bool *found_value) {
+  cme_error_t err;
+
+  CMC_LOG(parser->settings, cmc_LogLevelEnum_DEBUG,              // NOLINT
           "Parsing name=%s, type=%d, children=%d, found=%d",     // NOLINT
-          field->name,                                           // NOLINT
+          parser->name,                                          // NOLINT
           field->type, field->_self.subnodes_len, *found_value); // NOLINT
 
   switch (field->type) {
   case cmc_ConfigFieldTypeEnum_INT:
   case cmc_ConfigFieldTypeEnum_STRING:
-    err = cmc_env_parser_parse_str_and_int_field(config_file, field,
-                                                 found_value, settings);
+    err = cmc_env_parser_parse_str_and_int_field(parser, field, found_value);
     break;
   case cmc_ConfigFieldTypeEnum_ARRAY:
-    err = cmc_env_parser_parse_array_field(config_file, field, found_value,
-                                           settings);
+    err = cmc_env_parser_parse_array_field(parser, field, found_value);
     break;
   case cmc_ConfigFieldTypeEnum_DICT:
-    err = cmc_env_parser_parse_dict_field(config_file, field, found_value,
-                                          settings);
+    err = cmc_env_parser_parse_dict_field(parser, field, found_value);
     break;
 
   default:
@@ -169,14 +672,14 @@ cmc_env_parser_parse_field(FILE *config_file, struct cmc_ConfigField *field,
     goto error_out;
   }
 
-  CMC_LOG(settings, cmc_LogLevelEnum_DEBUG,                      // NOLINT
+  CMC_LOG(parser->settings, cmc_LogLevelEnum_DEBUG,              // NOLINT
           "Parsed name=%s, type=%d, children=%d, found=%d",      // NOLINT
-          field->name,                                           // NOLINT
+          parser->name,                                          // NOLINT
           field->type, field->_self.subnodes_len, *found_value); // NOLINT
 
   if (!*found_value && !field->optional) {
     err = cme_errorf(ENODATA, "Required field is missing `field->name=%s`",
-                     field->name);
+                     parser->name);
     goto error_out;
   }
 
@@ -186,83 +689,82 @@ error_out:
   return cme_return(err);
 }
 
-static cme_error_t cmc_env_parser_parse_str_and_int_field( // NOLINT
-    FILE *config_file, struct cmc_ConfigField *field,      // NOLINT
-    bool *found_value,                                     // NOLINT
-    struct cmc_ConfigSettings *settings) {                 // NOLINT
-  const uint32_t single_line_max = 255;
-  char single_line_buffer[single_line_max];
+static cme_error_t
+cmc_env_parser_parse_str_and_int_field(struct cmc_EnvParser *parser,
+                                       struct cmc_ConfigField *field,
+                                       bool *found_value) {
   cme_error_t err;
 
-  fseek(config_file, 0, SEEK_SET);
-
   *found_value = false;
-  while (
-      fgets(single_line_buffer, (int)single_line_max, config_file) != // NOLINT
-      NULL) {                                                         // NOLINT
-    if (strlen(single_line_buffer) <= 1) {
-      continue;
-    }
 
-    char *env_field_name = NULL;
-    char *env_field_value = NULL;
-    err = cmc_env_parser_parse_single_line(single_line_buffer, single_line_max,
-                                           &env_field_name, &env_field_value);
-    if (err) {
-      free(env_field_name);
-      free(env_field_value);
-      if (err->code == ENODATA) {
-        continue;
-      }
-      goto error_out;
-    }
+  if (parser->is_missing) {
+    return NULL;
+  }
 
-    if (!env_field_name || !env_field_value) {
-      continue;
-    }
+  const struct cmc_EnvIndexEntry *entry =
+      cmc_env_index_find(parser->index, parser->name, parser->name_len,
+                         parser->name_hash.hash);
+  if (!entry || !entry->has_value) {
+    return NULL;
+  }
 
-    if (strcmp(field->name, env_field_name) == 0) {
-      if (field->value) {
-        free(field->value);
-      }
+  const char *env_field_value = parser->index->buffer + entry->value_offset;
+  const uint32_t env_field_value_len = entry->value_len;
 
-      int value = -1;
-      field->value = NULL;
-      switch (field->type) {
-      case cmc_ConfigFieldTypeEnum_STRING:
-        err = cmc_field_add_value_str(field, env_field_value);
-        break;
-      case cmc_ConfigFieldTypeEnum_INT:
-        err = cmc_convert_str_to_int(env_field_value, strlen(env_field_value),
-                                     &value);
-        if (err) {
-          free(env_field_name);
-          free(env_field_value);
-          goto error_out;
-        }
-
-        err = cmc_field_add_value_int(field, value);
-        break;
-      default:;
-        err = cme_errorf(ENOMEM, "Unrecognized value for `field->type=%d`",
-                         field->type);
+  // Value is a view into the config buffer, this is the only copy of it.
+  //  Escape sequences are decoded in the copy.
+  const bool is_shared =
+      parser->settings->value_mode == cmc_ValueModeEnum_SHARED;
+  int value = -1;
+  switch (field->type) {
+  case cmc_ConfigFieldTypeEnum_STRING:
+    if (entry->is_escaped || !is_shared) {
+      err = cmc_field_add_value_strn(field, env_field_value,
+                                     env_field_value_len);
+      if (err) {
+        goto error_out;
       }
+    }
 
-      free(env_field_name);
-      free(env_field_value);
+    if (entry->is_escaped) {
+      char *field_value = field->value;
+      field_value[cmc_env_lexer_unescape(field_value, env_field_value_len)] =
+          0;
+    }
 
+    // Shared values are read-only, escaped one is taken from the decoded
+    //  copy.
+    if (is_shared) {
+      const char *shared_value =
+          entry->is_escaped ? field->value : env_field_value;
+      const size_t shared_value_len =
+          entry->is_escaped ? strlen(field->value) : env_field_value_len;
+      err = cmc_field_add_value_strn_shared(field, shared_value,
+                                            shared_value_len);
       if (err) {
         goto error_out;
       }
-
-      *found_value = true;
-      break;
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_INT:
+    err = cmc_convert_str_to_int(env_field_value, env_field_value_len,
+                                 &value);
+    if (err) {
+      goto error_out;
     }
 
-    free(env_field_name);
-    free(env_field_value);
+    err = cmc_field_add_value_int(field, value);
+    break;
+  default:;
+    err = cme_errorf(ENOMEM, "Unrecognized value for `field->type=%d`",
+                     field->type);
+  }
+  if (err) {
+    goto error_out;
   }
 
+  *found_value = true;
+
   return NULL;
 
 error_out:
@@ -270,121 +772,302 @@ error_out:
 }
 
 static cme_error_t
-cmc_env_parser_parse_single_line(char *buffer,                // NOLINT
-                                 uint32_t buffer_max,         // NOLINT
-                                 char **name, char **value) { // NOLINT
-  const char delimeter = '=';
-  char *delimeter_ptr;
+cmc_env_parser_parse_array_field(struct cmc_EnvParser *parser,
+                                 struct cmc_ConfigField *field,
+                                 bool *found_value) {
+  const struct cmc_Hash name_hash = parser->name_hash;
+  const uint32_t name_len = parser->name_len;
   cme_error_t err;
 
-  delimeter_ptr = strchr(buffer, delimeter);
-  if (!delimeter_ptr) {
-    err = cme_errorf(EINVAL, "No `delimeter=%c` found in `line=%s`", delimeter,
-                     buffer);
-    return cme_return(err);
+  *found_value = false;
+
+  if (!field || field->_self.subnodes_len == 0) {
+    return NULL;
   }
 
-  uint32_t env_field_name_len = delimeter_ptr - buffer;
-  char env_field_name[env_field_name_len + 1];
-  memset(env_field_name, 0, env_field_name_len + 1);
-  strncpy(env_field_name, buffer, env_field_name_len);
+  // Prototype of an array which gets no values is not an element.
+  field->_array_len = 0;
+
+  const struct cmc_ConfigField *prototype =
+      cmc_field_of_node(field->_self.subnodes[0]);
+  if (prototype->type == cmc_ConfigFieldTypeEnum_INT ||
+      prototype->type == cmc_ConfigFieldTypeEnum_STRING) {
+    err = cmc_env_parser_parse_scalar_array(parser, field, found_value);
+    if (err) {
+      goto error_out;
+    }
 
-  char *name_char;
-  CMC_FOREACH_PTR(name_char, env_field_name, strlen(env_field_name)) {
-    *name_char = (char)tolower((int)*name_char);
+    return NULL;
   }
 
-  uint32_t env_field_value_len = strlen(delimeter_ptr + 1);
-  char env_field_value[env_field_value_len + 1];
-  strncpy(env_field_value, delimeter_ptr + 1, env_field_value_len);
-  env_field_value[env_field_value_len] = 0;
+  if (!parser->arrays_depth) {
+    err = cmc_env_parser_reset_array(field);
+    if (err) {
+      goto error_out;
+    }
+  }
 
-  if (strlen(env_field_value) <= 1 || strlen(env_field_name) <= 1) {
-    err = cme_errorf(ENODATA, "Unable to find value for `env_field_name=%s`",
-                     env_field_name);
+  uint32_t elements_len;
+  err = cmc_env_parser_count_array_elements(parser, &elements_len);
+  if (err) {
     goto error_out;
   }
 
-  if (env_field_value[env_field_value_len - 1] == '\n') {
-    env_field_value[env_field_value_len - 1] = 0;
+  // Elements left by a previous parse are dropped, prototype is kept.
+  if (elements_len == 0) {
+    err = cmc_env_parser_truncate_array(field, 1);
+    if (err) {
+      goto error_out;
+    }
+
+    return NULL;
   }
 
-  *name = strdup(env_field_name);
-  if (!*name) {
-    err = cme_error(EINVAL, "Unable to allocate memory for `env_field_name`");
+  // All elements are instantiated upfront from the prototype, which is
+  //  parsed as the first element, so nothing is cloned speculatively or
+  //  popped later.
+  err = cmc_env_parser_instantiate_array(field, elements_len);
+  if (err) {
     goto error_out;
   }
 
-  *value = strdup(env_field_value);
-  if (!*value) {
-    err = cme_error(EINVAL, "Unable to allocate memory for `env_field_value`");
+  for (uint32_t i = 0; i < elements_len; i++) {
+    struct cmc_ConfigField *subfield =
+        cmc_field_of_node(field->_self.subnodes[i]);
+
+    char index_str[16];
+    int index_str_len = snprintf(index_str, sizeof(index_str), "%u", i);
+    err = cmc_env_parser_name_push(parser, index_str, index_str_len,
+                                   cmc_hash_str(index_str, index_str_len));
+    if (err) {
+      goto error_out;
+    }
+
+    // Array elements are named after their flattened name, which is
+    //  shared by all configs of the same schema.
+    err = cmc_field_set_name(subfield, parser->name, parser->name_len,
+                             parser->name_hash);
+    if (err) {
+      goto error_name_cleanup;
+    }
+
+    bool local_found_value = true;
+    parser->arrays_depth++;
+    err = cmc_env_parser_parse_field(parser, subfield, &local_found_value);
+    parser->arrays_depth--;
+    cmc_env_parser_name_pop(parser, name_len, name_hash);
+    if (err) {
+      goto error_out;
+    }
+
+    // Element has keys but none of them belongs to the schema, array ends
+    //  here. Prototype is always kept.
+    if (!local_found_value) {
+      err = cmc_env_parser_truncate_array(field, i > 0 ? i : 1);
+      if (err) {
+        goto error_out;
+      }
+      break;
+    }
+
+    *found_value = true;
+  }
+
+  if (*found_value) {
+    field->_array_len = field->_self.subnodes_len;
+  }
+
+  err = cmc_field_array_index_build(field);
+  if (err) {
     goto error_out;
   }
 
   return NULL;
 
+error_name_cleanup:
+  cmc_env_parser_name_pop(parser, name_len, name_hash);
 error_out:
   return cme_return(err);
 }
 
-static cme_error_t cmc_env_parser_parse_array_field(
-    FILE *config_file, struct cmc_ConfigField *field, bool *found_value,
-    struct cmc_ConfigSettings *settings) {
+// Values of an array of integers or strings are copied straight into one
+//  buffer owned by the array, no element field is instantiated. Array
+//  ends at the first element without a value.
+static cme_error_t
+cmc_env_parser_parse_scalar_array(struct cmc_EnvParser *parser,
+                                  struct cmc_ConfigField *field,
+                                  bool *found_value) {
+  const struct cmc_ConfigField *prototype =
+      cmc_field_of_node(field->_self.subnodes[0]);
+  const struct cmc_EnvIndexEntry *entry;
+  uint32_t elements_len = 0;
+  uint64_t strs_size = 0;
   cme_error_t err;
 
-  if (!field) {
-    *found_value = false;
-    return NULL;
+  while (!parser->is_missing) {
+    err = cmc_env_parser_find_element(parser, elements_len, &entry);
+    if (err) {
+      goto error_out;
+    }
+
+    if (!entry || !entry->has_value) {
+      break;
+    }
+
+    strs_size += sizeof(uint32_t) + entry->value_len + 1;
+    elements_len++;
   }
 
-  int32_t index = 0;
+  if (strs_size > UINT32_MAX) {
+    err = cme_errorf(EFBIG, "Array is too big `name=%s`", parser->name);
+    goto error_out;
+  }
 
-  while (true) {
-    struct cmc_ConfigField *subfield =
-        cmc_field_of_node(field->_self.subnodes[index]);
-    /* char **subfield_old_name = subfield->name; */
-    char *subfield_new_name =
-        cmc_env_parser_create_array_name(field->name, index);
-    if (!subfield_new_name) {
-      err =
-          cme_error(EINVAL, "Unable to allocate memory for `array_elem_name`");
+  const bool is_int = prototype->type == cmc_ConfigFieldTypeEnum_INT;
+  void *values = NULL;
+  if (elements_len) {
+    values = cmc_alloc(field->_arena, is_int ? elements_len * sizeof(int32_t)
+                                             : strs_size);
+    if (!values) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `values`");
       goto error_out;
     }
-    free(subfield->name);
-    subfield->name = subfield_new_name;
+  }
 
-    bool local_found_value = true;
-    err = cmc_env_parser_parse_field(config_file, subfield, &local_found_value,
-                                     settings);
+  // Strings start after their offsets, escape sequences are decoded in
+  //  the copy.
+  uint32_t offset = elements_len * sizeof(uint32_t);
+  for (uint32_t i = 0; i < elements_len; i++) {
+    err = cmc_env_parser_find_element(parser, i, &entry);
     if (err) {
-      goto error_out;
+      goto error_values_cleanup;
     }
 
-    if (!local_found_value) {
-      break;
+    const char *env_value = parser->index->buffer + entry->value_offset;
+    if (is_int) {
+      int value = 0;
+      err = cmc_convert_str_to_int(env_value, entry->value_len, &value);
+      if (err) {
+        goto error_values_cleanup;
+      }
+      ((int32_t *)values)[i] = value;
+      continue;
     }
 
-    struct cmc_ConfigField *new_node_field = NULL;
-    err = cmc_field_deep_clone(subfield, &new_node_field);
+    char *value = (char *)values + offset;
+    memcpy(value, env_value, entry->value_len);
+    value[entry->is_escaped ? cmc_env_lexer_unescape(value, entry->value_len)
+                            : entry->value_len] = 0;
+    ((uint32_t *)values)[i] = offset;
+    offset += entry->value_len + 1;
+  }
+
+  err = is_int ? cmc_field_array_pack_ints(field, values, elements_len)
+               : cmc_field_array_pack_strs(field, values, elements_len);
+  if (err) {
+    goto error_values_cleanup;
+  }
+
+  *found_value = elements_len > 0;
+
+  return NULL;
+
+error_values_cleanup:
+  cmc_free(field->_arena, values);
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t
+cmc_env_parser_count_array_elements(struct cmc_EnvParser *parser,
+                                    uint32_t *elements_len) {
+  const struct cmc_EnvIndexEntry *entry;
+  cme_error_t err;
+
+  *elements_len = 0;
+
+  if (parser->is_missing) {
+    return NULL;
+  }
+
+  while (true) {
+    err = cmc_env_parser_find_element(parser, *elements_len, &entry);
     if (err) {
       goto error_out;
     }
 
-    err = cmc_field_add_subfield(field, new_node_field);
+    if (!entry) {
+      break;
+    }
+
+    (*elements_len)++;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// Elements are children `name_N` of the array's trie node, first index
+//  without a node ends the array. `entry` is NULL for missing element.
+static cme_error_t
+cmc_env_parser_find_element(struct cmc_EnvParser *parser,
+                            const uint32_t index,
+                            const struct cmc_EnvIndexEntry **entry) {
+  const struct cmc_Hash name_hash = parser->name_hash;
+  const uint32_t name_len = parser->name_len;
+  cme_error_t err;
+
+  char index_str[16];
+  int index_str_len = snprintf(index_str, sizeof(index_str), "%u", index);
+  err = cmc_env_parser_name_push(parser, index_str, index_str_len,
+                                 cmc_hash_str(index_str, index_str_len));
+  if (err) {
+    goto error_out;
+  }
+
+  *entry = cmc_env_index_find(parser->index, parser->name, parser->name_len,
+                              parser->name_hash.hash);
+  cmc_env_parser_name_pop(parser, name_len, name_hash);
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// First element of an array outside of other arrays outlives parses, it
+//  is reset from a copy of the prototype taken before it's first parse.
+//  Nested arrays of it are reset together with it.
+static cme_error_t cmc_env_parser_reset_array(struct cmc_ConfigField *field) {
+  struct cmc_ConfigField *prototype =
+      cmc_field_of_node(field->_self.subnodes[0]);
+  cme_error_t err;
+
+  if (field->_prototype) {
+    err = cmc_field_reset(prototype, field->_prototype);
     if (err) {
       goto error_out;
     }
 
-    index++;
+    return NULL;
   }
 
-  if (index > 0) {
-    cmc_field_last_destroy(field);
-    *found_value = true;
+  struct cmc_ConfigField *copy =
+      cmc_alloc(field->_arena, sizeof(struct cmc_ConfigField));
+  if (!copy) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `copy`");
+    goto error_out;
+  }
 
-  } else {
-    *found_value = false;
+  err = cmc_field_deep_clone(prototype, copy);
+  if (err) {
+    cmc_free(field->_arena, copy);
+    goto error_out;
   }
+  copy->_is_borrowed = false;
+  field->_prototype = copy;
 
   return NULL;
 
@@ -392,85 +1075,183 @@ error_out:
   return cme_return(err);
 }
 
-static char *cmc_env_parser_create_array_name(const char *base_name,
-                                              int32_t index) {
-  const size_t buffer_max = 255;
-  char buffer[buffer_max];
+static cme_error_t
+cmc_env_parser_instantiate_array(struct cmc_ConfigField *field,
+                                 const uint32_t elements_len) {
+  cme_error_t err;
+
+  // Elements left by a previous parse are dropped, prototype is reused.
+  err = cmc_env_parser_truncate_array(field, 1);
+  if (err) {
+    goto error_out;
+  }
+  cmc_free(field->_arena, field->_elements);
+  field->_elements = NULL;
 
-  int written = snprintf(buffer, buffer_max, "%s_%d", base_name, index);
-  if (written < 0 || (size_t)written >= buffer_max) {
-    // Truncation or error occurred
+  if (elements_len == 1) {
     return NULL;
   }
 
-  return strdup(buffer); // Caller must free
+  // Prototypes of nested arrays were not parsed yet, they have no copy.
+  const struct cmc_ConfigField *prototype =
+      field->_prototype ? field->_prototype
+                        : cmc_field_of_node(field->_self.subnodes[0]);
+
+  // Clones share one block owned by the array, see `_is_borrowed`.
+  const size_t elements_size =
+      (elements_len - 1) * sizeof(struct cmc_ConfigField);
+  struct cmc_ConfigField *elements = cmc_alloc(field->_arena, elements_size);
+  if (!elements) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `elements`");
+    goto error_out;
+  }
+  memset(elements, 0, elements_size);
+
+  uint32_t cloned_len = 0;
+  for (; cloned_len < elements_len - 1; cloned_len++) {
+    err = cmc_field_deep_clone(prototype, &elements[cloned_len]);
+    if (err) {
+      goto error_elements_cleanup;
+    }
+  }
+
+  err = cmc_field_array_add_elements(field, elements, elements_len - 1);
+  if (err) {
+    goto error_elements_cleanup;
+  }
+  field->_elements = elements;
+
+  return NULL;
+
+error_elements_cleanup:
+  for (uint32_t i = 0; i < cloned_len; i++) {
+    struct cmc_ConfigField *element = &elements[i];
+    cmc_field_destroy(&element);
+  }
+  cmc_free(field->_arena, elements);
+error_out:
+  return cme_return(err);
 }
 
-static cme_error_t cmc_field_deep_clone(struct cmc_ConfigField *src,
-                                        struct cmc_ConfigField **dst) {
+static cme_error_t cmc_env_parser_truncate_array(struct cmc_ConfigField *field,
+                                                 const uint32_t elements_len) {
   cme_error_t err;
 
-  struct cmc_ConfigField *copy = NULL;
+  if (field->_self.subnodes_len <= elements_len) {
+    return NULL;
+  }
+
+  for (uint32_t i = elements_len; i < field->_self.subnodes_len; i++) {
+    struct cmc_ConfigField *element =
+        cmc_field_of_node(field->_self.subnodes[i]);
+    cmc_field_destroy(&element);
+  }
+
+  err = cmc_tree_node_resize_subnodes(field->_arena, &field->_self,
+                                      elements_len);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// Clones `src` into storage provided by the caller, which is marked as
+//  borrowed. Arrays are cloned with their prototype only.
+static cme_error_t cmc_field_deep_clone(const struct cmc_ConfigField *src,
+                                        struct cmc_ConfigField *dst) {
+  cme_error_t err;
 
-  err =
-      cmc_field_create(src->name, src->type, src->value, src->optional, &copy);
+  err = cmc_field_init(src->name, src->type, src->value, src->optional,
+                       src->_arena, dst);
   if (err) {
     goto error_out;
   }
+  dst->_is_borrowed = true;
+
+  // Arrays are cloned with their prototype only.
+  err = cmc_tree_node_reserve_subnodes(
+      src->_arena, &dst->_self,
+      src->type == cmc_ConfigFieldTypeEnum_ARRAY ? 1 : src->_self.subnodes_len);
+  if (err) {
+    goto error_dst_cleanup;
+  }
 
   CMC_FOREACH_FIELD(subfield, src, {
-    struct cmc_ConfigField *subfield_cp;
-    err = cmc_field_deep_clone(subfield, &subfield_cp);
+    struct cmc_ConfigField *subfield_cp =
+        cmc_alloc(src->_arena, sizeof(struct cmc_ConfigField));
+    if (!subfield_cp) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `subfield_cp`");
+      goto error_dst_cleanup;
+    }
+
+    err = cmc_field_deep_clone(subfield, subfield_cp);
     if (err) {
-      goto error_out;
+      cmc_free(src->_arena, subfield_cp);
+      goto error_dst_cleanup;
     }
+    subfield_cp->_is_borrowed = false;
 
-    cmc_field_add_subfield(copy, subfield_cp);
+    err = cmc_field_add_subfield(dst, subfield_cp);
+    if (err) {
+      cmc_field_destroy(&subfield_cp);
+      goto error_dst_cleanup;
+    }
 
-    // For array we need to copy only first element, other elements
-    //  will be filled by parse array func.
     if (src->type == cmc_ConfigFieldTypeEnum_ARRAY) {
       break;
     }
   })
 
-  *dst = copy;
+  // Arrays nested in elements are indexed like the prototype's ones.
+  if (src->_index_key) {
+    err = cmc_field_array_index(dst, src->_index_key);
+    if (err) {
+      goto error_dst_cleanup;
+    }
+  }
 
   return NULL;
+
+error_dst_cleanup:
+  cmc_field_destroy(&dst);
 error_out:
   return cme_return(err);
 }
 
-static void cmc_field_last_destroy(struct cmc_ConfigField *field) {
-  cme_error_t err;
-
-  struct cmc_ConfigField *last_subfield =
-      cmc_field_of_node(field->_self.subnodes[field->_self.subnodes_len - 1]);
-  cmc_field_destroy(&last_subfield);
-
-  err = cmc_tree_node_pop_subnode(&field->_self);
-  if (err) {
-    return;
-  }
-}
-
-static cme_error_t cmc_env_parser_parse_dict_field(
-    FILE *config_file, struct cmc_ConfigField *field, bool *found_value,
-    struct cmc_ConfigSettings *settings) {
+static cme_error_t
+cmc_env_parser_parse_dict_field(struct cmc_EnvParser *parser,
+                                struct cmc_ConfigField *field,
+                                bool *found_value) {
+  const struct cmc_Hash name_hash = parser->name_hash;
+  const uint32_t name_len = parser->name_len;
+  const bool is_missing = parser->is_missing;
   int32_t found_i = 0;
   cme_error_t err;
 
+  // Children are still walked when dict's trie node is missing, so required
+  //  fields are reported, but none of them is looked up.
+  parser->is_missing =
+      is_missing || !cmc_env_index_find(parser->index, parser->name,
+                                        parser->name_len,
+                                        parser->name_hash.hash);
+
   CMC_FOREACH_FIELD(subfield, field, {
-    char *old_subfield_name = subfield->name;
-    char *new_subfield_name =
-        cmc_env_parser_create_dict_name(field->name, subfield->name);
-    subfield->name = new_subfield_name;
+    err = cmc_env_parser_name_push(parser, subfield->name,
+                                   strlen(subfield->name),
+                                   cmc_env_parser_field_hash(subfield));
+    if (err) {
+      goto error_out;
+    }
 
     bool local_found_value = true;
-    err = cmc_env_parser_parse_field(config_file, subfield, &local_found_value,
-                                     settings);
-    subfield->name = old_subfield_name;
-    free(new_subfield_name);
+    parser->arrays_depth++;
+    err = cmc_env_parser_parse_field(parser, subfield, &local_found_value);
+    parser->arrays_depth--;
+    cmc_env_parser_name_pop(parser, name_len, name_hash);
     if (err) {
       goto error_out;
     }
@@ -480,6 +1261,8 @@ static cme_error_t cmc_env_parser_parse_dict_field(
     }
   })
 
+  parser->is_missing = is_missing;
+
   if (found_i > 0) {
     *found_value = true;
   } else {
@@ -489,18 +1272,12 @@ static cme_error_t cmc_env_parser_parse_dict_field(
   return NULL;
 
 error_out:
+  parser->is_missing = is_missing;
   return cme_return(err);
 }
 
-static char *cmc_env_parser_create_dict_name(const char *dict_name,
-                                             const char *key) {
-  const size_t buffer_max = 255;
-  char buffer[buffer_max];
-
-  int written = snprintf(buffer, buffer_max, "%s_%s", dict_name, key);
-  if (written < 0 || (size_t)written >= buffer_max) {
-    return NULL;
-  }
-
-  return strdup(buffer);
+static struct cmc_Hash
+cmc_env_parser_field_hash(const struct cmc_ConfigField *field) {
+  return (struct cmc_Hash){.hash = field->_name_hash,
+                           .pow = field->_name_hash_pow};
 }
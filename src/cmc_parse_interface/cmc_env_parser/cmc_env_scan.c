@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CMC_ENV_SCAN_X86 1
+#endif
+
+#include "c_minilib_config.h"
+#include "cmc_env_scan.h"
+#include "utils/cmc_arena.h"
+
+// Each implementation scans `buffer[offset, offset + len)` in whole blocks
+//  and returns how many bytes it scanned, the tail is left for the scalar
+//  loop. Table has to have room for one offset per scanned byte.
+typedef uint32_t (*cmc_env_scan_func_t)(const char *buffer,
+                                        const uint32_t offset,
+                                        const uint32_t len,
+                                        struct cmc_EnvScanTable *table);
+
+static uint32_t cmc_env_scan_scalar(const char *buffer, const uint32_t offset,
+                                    const uint32_t len,
+                                    struct cmc_EnvScanTable *table);
+#ifdef CMC_ENV_SCAN_X86
+static uint32_t cmc_env_scan_sse2(const char *buffer, const uint32_t offset,
+                                  const uint32_t len,
+                                  struct cmc_EnvScanTable *table);
+static uint32_t cmc_env_scan_avx2(const char *buffer, const uint32_t offset,
+                                  const uint32_t len,
+                                  struct cmc_EnvScanTable *table);
+static uint32_t cmc_env_scan_avx512(const char *buffer, const uint32_t offset,
+                                    const uint32_t len,
+                                    struct cmc_EnvScanTable *table);
+#endif
+static bool cmc_env_scan_reserve(struct cmc_EnvScanTable *table,
+                                 const uint32_t offsets_len);
+
+static const char *cmc_env_scan_names[cmc_EnvScanImplEnum_MAX] = {
+    [cmc_EnvScanImplEnum_SCALAR] = "scalar",
+    [cmc_EnvScanImplEnum_SSE2] = "sse2",
+    [cmc_EnvScanImplEnum_AVX2] = "avx2",
+    [cmc_EnvScanImplEnum_AVX512] = "avx512",
+};
+
+static const cmc_env_scan_func_t cmc_env_scan_funcs[cmc_EnvScanImplEnum_MAX] = {
+    [cmc_EnvScanImplEnum_SCALAR] = cmc_env_scan_scalar,
+#ifdef CMC_ENV_SCAN_X86
+    [cmc_EnvScanImplEnum_SSE2] = cmc_env_scan_sse2,
+    [cmc_EnvScanImplEnum_AVX2] = cmc_env_scan_avx2,
+    [cmc_EnvScanImplEnum_AVX512] = cmc_env_scan_avx512,
+#endif
+};
+
+static enum cmc_EnvScanImplEnum cmc_env_scan_impl = cmc_EnvScanImplEnum_MAX;
+
+void cmc_env_scan_init(void) {
+  enum cmc_EnvScanImplEnum impl = cmc_EnvScanImplEnum_SCALAR;
+
+  for (int32_t i = cmc_EnvScanImplEnum_MAX - 1; i >= 0; i--) {
+    if (cmc_env_scan_is_supported(i)) {
+      impl = i;
+      break;
+    }
+  }
+
+  const char *forced_impl = getenv("CMC_ENV_SCAN");
+  if (forced_impl) {
+    for (int32_t i = 0; i < cmc_EnvScanImplEnum_MAX; i++) {
+      if (strcmp(forced_impl, cmc_env_scan_names[i]) == 0 &&
+          cmc_env_scan_is_supported(i)) {
+        impl = i;
+        break;
+      }
+    }
+  }
+
+  cmc_env_scan_impl = impl;
+}
+
+bool cmc_env_scan_is_supported(const enum cmc_EnvScanImplEnum impl) {
+  switch (impl) {
+  case cmc_EnvScanImplEnum_SCALAR:
+    return true;
+#ifdef CMC_ENV_SCAN_X86
+  case cmc_EnvScanImplEnum_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case cmc_EnvScanImplEnum_AVX2:
+    return __builtin_cpu_supports("avx2");
+  case cmc_EnvScanImplEnum_AVX512:
+    return __builtin_cpu_supports("avx512bw");
+#endif
+  default:
+    return false;
+  }
+}
+
+cme_error_t cmc_env_scan_set_impl(const enum cmc_EnvScanImplEnum impl) {
+  cme_error_t err;
+
+  if (impl < 0 || impl >= cmc_EnvScanImplEnum_MAX) {
+    err = cme_errorf(EINVAL, "Unrecognized `impl=%d`", impl);
+    goto error_out;
+  }
+
+  if (!cmc_env_scan_is_supported(impl)) {
+    err = cme_errorf(ENOTSUP, "Scan `impl=%s` is not supported by CPU",
+                     cmc_env_scan_names[impl]);
+    goto error_out;
+  }
+
+  cmc_env_scan_impl = impl;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+enum cmc_EnvScanImplEnum cmc_env_scan_get_impl(void) {
+  if (cmc_env_scan_impl == cmc_EnvScanImplEnum_MAX) {
+    cmc_env_scan_init();
+  }
+
+  return cmc_env_scan_impl;
+}
+
+cme_error_t cmc_env_scan_create(struct cmc_Arena *arena, const char *buffer,
+                                const size_t buffer_len,
+                                struct cmc_EnvScanTable *table) {
+  cme_error_t err;
+
+  if (!buffer || !table) {
+    err = cme_error(EINVAL, "`buffer` and `table` cannot be NULL");
+    goto error_out;
+  }
+
+  if (buffer_len > UINT32_MAX) {
+    err = cme_errorf(EFBIG, "Config is too big `buffer_len=%zu`", buffer_len);
+    goto error_out;
+  }
+
+  table->arena = arena;
+  table->offsets = NULL;
+  table->offsets_len = 0;
+  table->offsets_max = 0;
+
+  if (!cmc_env_scan_range(buffer, 0, buffer_len, table)) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `table->offsets`");
+    goto error_table_cleanup;
+  }
+
+  return NULL;
+
+error_table_cleanup:
+  cmc_env_scan_destroy(table);
+error_out:
+  return cme_return(err);
+}
+
+bool cmc_env_scan_range(const char *buffer, const uint32_t begin,
+                        const uint32_t end, struct cmc_EnvScanTable *table) {
+  const cmc_env_scan_func_t scan_func =
+      cmc_env_scan_funcs[cmc_env_scan_get_impl()];
+  const uint32_t step = 4096;
+
+  // Buffer is scanned in page sized steps, so the table is reserved for the
+  //  worst case of one step only and grows with the real amount of structure.
+  for (uint32_t offset = begin; offset < end;) {
+    const uint32_t len = end - offset < step ? end - offset : step;
+
+    if (len > UINT32_MAX - table->offsets_len ||
+        !cmc_env_scan_reserve(table, table->offsets_len + len)) {
+      return false;
+    }
+
+    const uint32_t scanned = scan_func(buffer, offset, len, table);
+    cmc_env_scan_scalar(buffer, offset + scanned, len - scanned, table);
+    offset += len;
+  }
+
+  return true;
+}
+
+void cmc_env_scan_destroy(struct cmc_EnvScanTable *table) {
+  if (!table) {
+    return;
+  }
+
+  cmc_free(table->arena, table->offsets);
+  table->offsets = NULL;
+  table->offsets_len = 0;
+  table->offsets_max = 0;
+}
+
+static bool cmc_env_scan_reserve(struct cmc_EnvScanTable *table,
+                                 const uint32_t offsets_len) {
+  if (offsets_len <= table->offsets_max) {
+    return true;
+  }
+
+  // Doubling is done in 64 bits and capped, so it cannot wrap.
+  uint64_t offsets_max = table->offsets_max ? table->offsets_max : 1024;
+  while (offsets_max < offsets_len) {
+    offsets_max *= 2;
+  }
+  offsets_max = offsets_max > UINT32_MAX ? UINT32_MAX : offsets_max;
+  if (offsets_max > SIZE_MAX / sizeof(uint32_t)) {
+    return false;
+  }
+
+  uint32_t *local_offsets =
+      cmc_realloc(table->arena, table->offsets,
+                  table->offsets_max * sizeof(uint32_t),
+                  (size_t)offsets_max * sizeof(uint32_t));
+  if (!local_offsets) {
+    return false;
+  }
+
+  table->offsets = local_offsets;
+  table->offsets_max = (uint32_t)offsets_max;
+
+  return true;
+}
+
+static inline bool cmc_env_scan_is_structural(const char c) {
+  return c == '\n' || c == '=' || c == '#' || c == '"' || c == '\'' ||
+         c == '\\';
+}
+
+static uint32_t cmc_env_scan_scalar(const char *buffer, const uint32_t offset,
+                                    const uint32_t len,
+                                    struct cmc_EnvScanTable *table) {
+  uint32_t offsets_len = table->offsets_len;
+
+  for (uint32_t i = offset; i < offset + len; i++) {
+    // Offset is always written and kept only if the byte is structural,
+    //  which avoids a branch per byte.
+    table->offsets[offsets_len] = i;
+    offsets_len += cmc_env_scan_is_structural(buffer[i]);
+  }
+
+  table->offsets_len = offsets_len;
+
+  return len;
+}
+
+static inline void cmc_env_scan_append_mask(struct cmc_EnvScanTable *table,
+                                            uint64_t mask,
+                                            const uint32_t offset) {
+  while (mask) {
+    table->offsets[table->offsets_len++] = offset + __builtin_ctzll(mask);
+    mask &= mask - 1;
+  }
+}
+
+#ifdef CMC_ENV_SCAN_X86
+__attribute__((target("sse2"))) static uint32_t
+cmc_env_scan_sse2(const char *buffer, const uint32_t offset,
+                  const uint32_t len, struct cmc_EnvScanTable *table) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i equal = _mm_set1_epi8('=');
+  const __m128i hash = _mm_set1_epi8('#');
+  const __m128i double_quote = _mm_set1_epi8('"');
+  const __m128i single_quote = _mm_set1_epi8('\'');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  uint32_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(buffer + offset + i));
+    __m128i match = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, newline),
+                     _mm_cmpeq_epi8(block, equal)),
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, hash),
+                         _mm_cmpeq_epi8(block, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, double_quote),
+                         _mm_cmpeq_epi8(block, single_quote))));
+    cmc_env_scan_append_mask(table, (uint32_t)_mm_movemask_epi8(match),
+                             offset + i);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2"))) static uint32_t
+cmc_env_scan_avx2(const char *buffer, const uint32_t offset,
+                  const uint32_t len, struct cmc_EnvScanTable *table) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i equal = _mm256_set1_epi8('=');
+  const __m256i hash = _mm256_set1_epi8('#');
+  const __m256i double_quote = _mm256_set1_epi8('"');
+  const __m256i single_quote = _mm256_set1_epi8('\'');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  uint32_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    __m256i block =
+        _mm256_loadu_si256((const __m256i *)(buffer + offset + i));
+    __m256i quotes = _mm256_or_si256(_mm256_cmpeq_epi8(block, double_quote),
+                                     _mm256_cmpeq_epi8(block, single_quote));
+    __m256i match = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, newline),
+                        _mm256_cmpeq_epi8(block, equal)),
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, hash),
+                                        _mm256_cmpeq_epi8(block, backslash)),
+                        quotes));
+    cmc_env_scan_append_mask(table, (uint32_t)_mm256_movemask_epi8(match),
+                             offset + i);
+  }
+
+  return i;
+}
+
+__attribute__((target("avx512f,avx512bw"))) static uint32_t
+cmc_env_scan_avx512(const char *buffer, const uint32_t offset,
+                    const uint32_t len, struct cmc_EnvScanTable *table) {
+  const __m512i newline = _mm512_set1_epi8('\n');
+  const __m512i equal = _mm512_set1_epi8('=');
+  const __m512i hash = _mm512_set1_epi8('#');
+  const __m512i double_quote = _mm512_set1_epi8('"');
+  const __m512i single_quote = _mm512_set1_epi8('\'');
+  const __m512i backslash = _mm512_set1_epi8('\\');
+  uint32_t i = 0;
+
+  for (; i + 64 <= len; i += 64) {
+    __m512i block = _mm512_loadu_si512((const void *)(buffer + offset + i));
+    __mmask64 match = _mm512_cmpeq_epi8_mask(block, newline) |
+                      _mm512_cmpeq_epi8_mask(block, equal) |
+                      _mm512_cmpeq_epi8_mask(block, hash) |
+                      _mm512_cmpeq_epi8_mask(block, double_quote) |
+                      _mm512_cmpeq_epi8_mask(block, single_quote) |
+                      _mm512_cmpeq_epi8_mask(block, backslash);
+    cmc_env_scan_append_mask(table, match, offset + i);
+  }
+
+  return i;
+}
+#endif
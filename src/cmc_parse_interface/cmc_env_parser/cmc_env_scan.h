@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_ENV_SCAN_H
+#define C_MINILIB_CONFIG_CMC_ENV_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <c_minilib_config.h>
+
+/*
+ * Structural scan of a `.env` buffer. Offsets of every newline, `=`, `#`,
+ * quote and backslash are collected into a table, so tokenizer can jump
+ * between them instead of inspecting every byte. Implementation is picked
+ * at runtime based on CPU features, `CMC_ENV_SCAN` environment variable
+ * (scalar, sse2, avx2, avx512) overrides the choice.
+ */
+enum cmc_EnvScanImplEnum {
+  cmc_EnvScanImplEnum_SCALAR,
+  cmc_EnvScanImplEnum_SSE2,
+  cmc_EnvScanImplEnum_AVX2,
+  cmc_EnvScanImplEnum_AVX512,
+  cmc_EnvScanImplEnum_MAX,
+};
+
+struct cmc_EnvScanTable {
+  // Arena the offsets come from, NULL means the heap.
+  struct cmc_Arena *arena;
+  uint32_t *offsets;
+  uint32_t offsets_len;
+  uint32_t offsets_max;
+};
+
+void cmc_env_scan_init(void);
+bool cmc_env_scan_is_supported(const enum cmc_EnvScanImplEnum impl);
+cme_error_t cmc_env_scan_set_impl(const enum cmc_EnvScanImplEnum impl);
+enum cmc_EnvScanImplEnum cmc_env_scan_get_impl(void);
+
+cme_error_t cmc_env_scan_create(struct cmc_Arena *arena, const char *buffer,
+                                const size_t buffer_len,
+                                struct cmc_EnvScanTable *table);
+void cmc_env_scan_destroy(struct cmc_EnvScanTable *table);
+
+/*
+ * Append offsets of `buffer[begin, end)` to an initialized table, offsets
+ * stay absolute. Does not create errors so it can run in worker threads,
+ * returns false if the table cannot grow. Implementation has to be picked
+ * before, see `cmc_env_scan_get_impl`.
+ */
+bool cmc_env_scan_range(const char *buffer, const uint32_t begin,
+                        const uint32_t end, struct cmc_EnvScanTable *table);
+
+#endif // C_MINILIB_CONFIG_CMC_ENV_SCAN_H
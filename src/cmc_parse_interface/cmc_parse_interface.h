@@ -33,6 +33,16 @@ struct cmc_ConfigParseInterface {
                        struct cmc_Config *config);
   // Destroy parser instance
   void (*destroy)(cmc_ConfigParserData *);
+  // Start push parsing, input arrives in chunks of any size. Parser keeps
+  //  it's state in `state` until `parse_end` or `parse_abort`.
+  cme_error_t (*parse_begin)(struct cmc_Config *config,
+                             cmc_ConfigParserData *state);
+  cme_error_t (*parse_feed)(const size_t n, const char buffer[n],
+                            const cmc_ConfigParserData state);
+  // Finish push parsing and bind values to fields, releases the state.
+  cme_error_t (*parse_end)(cmc_ConfigParserData *state,
+                           struct cmc_Config *config);
+  void (*parse_abort)(cmc_ConfigParserData *state);
 };
 
 #endif // C_MINILIB_CONFIG_PARSE_INTERFACE_H
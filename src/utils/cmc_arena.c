@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
+
+#define CMC_ARENA_ALIGN _Alignof(max_align_t)
+
+static inline size_t cmc_arena_align(const size_t size);
+static struct cmc_ArenaBlock *cmc_arena_block_create(const size_t size);
+
+cme_error_t cmc_arena_create(const size_t block_size,
+                             struct cmc_Arena **arena) {
+  struct cmc_Arena *local_arena;
+  cme_error_t err;
+
+  if (!arena) {
+    err = cme_error(EINVAL, "`arena` cannot be NULL");
+    goto error_out;
+  }
+
+  local_arena = cmc_heap_alloc(sizeof(struct cmc_Arena));
+  if (!local_arena) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `local_arena`");
+    goto error_out;
+  }
+
+  // Blocks are allocated lazily, on first allocation.
+  local_arena->blocks = NULL;
+  local_arena->blocks_tail = NULL;
+  local_arena->current = NULL;
+  local_arena->block_size = block_size ? block_size : 64 * 1024;
+  local_arena->last = NULL;
+  local_arena->last_size = 0;
+  local_arena->kept = 0;
+  local_arena->is_static = false;
+
+  *arena = local_arena;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_arena_create_static(void *memory, const size_t memory_size,
+                                    struct cmc_Arena **arena) {
+  cme_error_t err;
+
+  if (!memory || !arena) {
+    err = cme_error(EINVAL, "`memory` and `arena` cannot be NULL");
+    goto error_out;
+  }
+
+  const uintptr_t begin = (uintptr_t)memory;
+  const uintptr_t aligned = begin + (-begin & (CMC_ARENA_ALIGN - 1));
+  const size_t headers_size =
+      cmc_arena_align(sizeof(struct cmc_Arena)) + sizeof(struct cmc_ArenaBlock);
+  if (memory_size < aligned - begin ||
+      memory_size - (aligned - begin) < headers_size) {
+    err = cme_errorf(ENOMEM, "Static memory is too small `memory_size=%zu`",
+                     memory_size);
+    goto error_out;
+  }
+
+  struct cmc_Arena *local_arena = (struct cmc_Arena *)aligned;
+  struct cmc_ArenaBlock *block =
+      (struct cmc_ArenaBlock *)(aligned +
+                                cmc_arena_align(sizeof(struct cmc_Arena)));
+
+  block->next = NULL;
+  // Block size is kept aligned, so the end of block is never overrun.
+  block->size = (memory_size - (aligned - begin) - headers_size) &
+                ~(CMC_ARENA_ALIGN - 1);
+  block->used = 0;
+
+  local_arena->blocks = block;
+  local_arena->blocks_tail = block;
+  local_arena->current = block;
+  local_arena->block_size = block->size;
+  local_arena->last = NULL;
+  local_arena->last_size = 0;
+  local_arena->kept = 0;
+  local_arena->is_static = true;
+
+  *arena = local_arena;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+void cmc_arena_destroy(struct cmc_Arena **arena) {
+  if (!arena || !*arena) {
+    return;
+  }
+
+  if ((*arena)->is_static) {
+    *arena = NULL;
+    return;
+  }
+
+  struct cmc_ArenaBlock *block = (*arena)->blocks;
+  while (block) {
+    struct cmc_ArenaBlock *next = block->next;
+    cmc_heap_free(block);
+    block = next;
+  }
+
+  cmc_heap_free(*arena);
+  *arena = NULL;
+}
+
+void cmc_arena_reset(struct cmc_Arena *arena) {
+  if (!arena) {
+    return;
+  }
+
+  for (struct cmc_ArenaBlock *block = arena->blocks; block;
+       block = block->next) {
+    block->used = 0;
+  }
+
+  if (arena->blocks) {
+    arena->blocks->used = arena->kept;
+  }
+
+  arena->current = arena->blocks;
+  arena->last = NULL;
+  arena->last_size = 0;
+}
+
+void cmc_arena_keep(struct cmc_Arena *arena) {
+  if (!arena || !arena->blocks || arena->current != arena->blocks) {
+    return;
+  }
+
+  arena->kept = arena->blocks->used;
+  // Kept allocation cannot be grown in place anymore.
+  arena->last = NULL;
+  arena->last_size = 0;
+}
+
+void *cmc_arena_alloc(struct cmc_Arena *arena, const size_t size) {
+  const size_t local_size = cmc_arena_align(size ? size : 1);
+
+  if (local_size < size) {
+    return NULL;
+  }
+
+  // Blocks kept by reset are reused in order, block too small for this
+  //  allocation is skipped.
+  while (arena->current &&
+         arena->current->size - arena->current->used < local_size) {
+    if (arena->is_static) {
+      return NULL;
+    }
+    arena->current = arena->current->next;
+  }
+
+  if (!arena->current) {
+    const size_t block_size =
+        local_size > arena->block_size ? local_size : arena->block_size;
+    struct cmc_ArenaBlock *block = cmc_arena_block_create(block_size);
+    if (!block) {
+      return NULL;
+    }
+
+    if (arena->blocks_tail) {
+      arena->blocks_tail->next = block;
+    } else {
+      arena->blocks = block;
+    }
+    arena->blocks_tail = block;
+    arena->current = block;
+  }
+
+  void *ptr = (char *)arena->current->data + arena->current->used;
+  arena->current->used += local_size;
+  arena->last = ptr;
+  arena->last_size = local_size;
+
+  return ptr;
+}
+
+void *cmc_arena_realloc(struct cmc_Arena *arena, void *ptr,
+                        const size_t old_size, const size_t size) {
+  if (!ptr) {
+    return cmc_arena_alloc(arena, size);
+  }
+
+  // Vectors grown one by one are usually the last allocation, so they
+  //  grow in place without a copy.
+  const size_t local_size = cmc_arena_align(size ? size : 1);
+  if (ptr == arena->last && local_size >= size) {
+    struct cmc_ArenaBlock *block = arena->current;
+    const size_t used = block->used - arena->last_size;
+    if (block->size - used >= local_size) {
+      block->used = used + local_size;
+      arena->last_size = local_size;
+      return ptr;
+    }
+  }
+
+  if (size <= old_size) {
+    return ptr;
+  }
+
+  void *local_ptr = cmc_arena_alloc(arena, size);
+  if (!local_ptr) {
+    return NULL;
+  }
+
+  memcpy(local_ptr, ptr, old_size);
+
+  return local_ptr;
+}
+
+static inline size_t cmc_arena_align(const size_t size) {
+  return (size + CMC_ARENA_ALIGN - 1) & ~(CMC_ARENA_ALIGN - 1);
+}
+
+static struct cmc_ArenaBlock *cmc_arena_block_create(const size_t size) {
+  if (size > SIZE_MAX - sizeof(struct cmc_ArenaBlock)) {
+    return NULL;
+  }
+
+  struct cmc_ArenaBlock *block =
+      cmc_heap_alloc(sizeof(struct cmc_ArenaBlock) + size);
+  if (!block) {
+    return NULL;
+  }
+
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+
+  return block;
+}
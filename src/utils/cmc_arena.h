@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_ARENA_H
+#define C_MINILIB_CONFIG_CMC_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_heap.h"
+
+/*
+ * Bump allocator over a list of big blocks. Memory is never freed one
+ * allocation at a time, the whole arena is either reset, which keeps the
+ * blocks for reuse, or destroyed.
+ */
+struct cmc_ArenaBlock {
+  struct cmc_ArenaBlock *next;
+  size_t size;
+  size_t used;
+  max_align_t data[];
+};
+
+struct cmc_Arena {
+  struct cmc_ArenaBlock *blocks;
+  struct cmc_ArenaBlock *blocks_tail;
+  struct cmc_ArenaBlock *current;
+  size_t block_size;
+  // Last allocation, it can be grown in place.
+  void *last;
+  size_t last_size;
+  // Bytes of the first block which survive reset, see `cmc_arena_keep`.
+  size_t kept;
+  // Arena lives in caller's memory and never grows, see
+  //  `cmc_arena_create_static`.
+  bool is_static;
+};
+
+cme_error_t cmc_arena_create(const size_t block_size,
+                             struct cmc_Arena **arena);
+void cmc_arena_destroy(struct cmc_Arena **arena);
+void cmc_arena_reset(struct cmc_Arena *arena);
+
+/*
+ * Arena over caller's memory, the arena itself and it's only block are
+ * placed at the start of it. Allocations fail once the memory is used up
+ * and destroy does not free anything.
+ */
+cme_error_t cmc_arena_create_static(void *memory, const size_t memory_size,
+                                    struct cmc_Arena **arena);
+
+// Allocations made so far survive reset, they have to fit in the first
+//  block, which is always the case for static arena.
+void cmc_arena_keep(struct cmc_Arena *arena);
+
+// Allocators return NULL once memory is exhausted, like libc ones.
+void *cmc_arena_alloc(struct cmc_Arena *arena, const size_t size);
+void *cmc_arena_realloc(struct cmc_Arena *arena, void *ptr,
+                        const size_t old_size, const size_t size);
+
+/*
+ * Allocation helpers shared by fields and tree nodes, NULL arena means the
+ * memory comes from the heap, see `cmc_heap_alloc`. Memory of an arena is
+ * released only as a whole, so free is a no-op for it.
+ */
+static inline void *cmc_alloc(struct cmc_Arena *arena, const size_t size) {
+  return arena ? cmc_arena_alloc(arena, size) : cmc_heap_alloc(size);
+}
+
+static inline void *cmc_calloc(struct cmc_Arena *arena, const size_t n,
+                               const size_t size) {
+  if (size && n > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  void *ptr = cmc_alloc(arena, n * size);
+  if (ptr) {
+    memset(ptr, 0, n * size);
+  }
+  return ptr;
+}
+
+static inline void *cmc_realloc(struct cmc_Arena *arena, void *ptr,
+                                const size_t old_size, const size_t size) {
+  return arena ? cmc_arena_realloc(arena, ptr, old_size, size)
+               : cmc_heap_realloc(ptr, size);
+}
+
+static inline void cmc_free(struct cmc_Arena *arena, void *ptr) {
+  if (!arena) {
+    cmc_heap_free(ptr);
+  }
+}
+
+static inline char *cmc_strndup(struct cmc_Arena *arena, const char *str,
+                                const size_t str_len) {
+  char *local_str = cmc_alloc(arena, str_len + 1);
+  if (local_str) {
+    memcpy(local_str, str, str_len);
+    local_str[str_len] = 0;
+  }
+  return local_str;
+}
+
+#endif // C_MINILIB_CONFIG_CMC_ARENA_H
@@ -12,19 +12,63 @@
 
 #include "c_minilib_config.h"
 #include "c_minilib_error.h"
+#include "utils/cmc_arena.h"
 #include "utils/cmc_field.h"
+#include "utils/cmc_hash.h"
+#include "utils/cmc_intern.h"
 #include "utils/cmc_tree.h"
 
-static inline cme_error_t cmc_alloc_field_value_str(const char *value,
-                                                    void **field_value);
-static inline cme_error_t cmc_alloc_field_value_int(const int32_t value,
-                                                    void **field_value);
-static void cmc_field_value_destroy(struct cmc_ConfigField **field);
+// Dicts up to this many children are scanned, bigger ones get a table.
+#define CMC_FIELD_DICT_SCAN_MAX 8
+// Elements appended to an array per bulk append of subnodes.
+#define CMC_FIELD_ELEMENTS_CHUNK 64
+
+static void cmc_field_value_destroy(struct cmc_ConfigField *field);
+static cme_error_t cmc_field_dict_index(struct cmc_ConfigField *field);
+static struct cmc_ConfigField *
+cmc_field_dict_find(const struct cmc_ConfigField *field, const char *key,
+                    const uint32_t key_len, const uint64_t key_hash);
+static cme_error_t
+cmc_field_array_lookup(const struct cmc_ConfigField *field, const char *key,
+                       const enum cmc_ConfigFieldTypeEnum type,
+                       const void *value, struct cmc_ConfigField **element);
+static uint32_t cmc_field_value_hash(const enum cmc_ConfigFieldTypeEnum type,
+                                     const void *value);
+static bool cmc_field_value_equal(const struct cmc_ConfigField *member,
+                                  const enum cmc_ConfigFieldTypeEnum type,
+                                  const void *value);
+static bool cmc_field_key_equal(const char *a, const char *b);
+static void cmc_field_dict_place(struct cmc_ConfigField *field,
+                                 const uint32_t index);
+static char *cmc_field_name_create(struct cmc_Arena *arena, const char *name,
+                                   const uint32_t name_len,
+                                   const uint64_t name_hash);
+static void cmc_field_name_destroy(struct cmc_ConfigField *field);
+static cme_error_t cmc_field_array_unpack(struct cmc_ConfigField *field);
+static cme_error_t cmc_field_array_drop(struct cmc_ConfigField *field);
 
 cme_error_t cmc_field_create(const char *name,
                              const enum cmc_ConfigFieldTypeEnum type,
                              const void *default_value, const bool optional,
                              struct cmc_ConfigField **field) {
+  cme_error_t err;
+
+  err = cmc_field_create_in(name, type, default_value, optional, NULL, field);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+};
+
+cme_error_t cmc_field_create_in(const char *name,
+                                const enum cmc_ConfigFieldTypeEnum type,
+                                const void *default_value, const bool optional,
+                                struct cmc_Arena *arena,
+                                struct cmc_ConfigField **field) {
   struct cmc_ConfigField *local_field;
   cme_error_t err;
 
@@ -33,64 +77,182 @@ cme_error_t cmc_field_create(const char *name,
     goto error_out;
   }
 
-  local_field = malloc(sizeof(struct cmc_ConfigField));
+  local_field = cmc_alloc(arena, sizeof(struct cmc_ConfigField));
   if (!local_field) {
     err = cme_error(ENOMEM, "Unable to allocate memory for `local_field`");
     goto error_out;
   }
 
-  local_field->name = strdup(name);
-  if (!local_field->name) {
-    err =
-        cme_error(ENOMEM, "Unable to allocate memory for `local_field->name`");
+  err = cmc_field_init(name, type, default_value, optional, arena,
+                       local_field);
+  if (err) {
     goto error_field_cleanup;
   }
 
-  err = cmc_tree_node_create(&local_field->_self);
+  *field = local_field;
+
+  return NULL;
+
+error_field_cleanup:
+  cmc_free(arena, local_field);
+error_out:
+  return cme_return(err);
+};
+
+cme_error_t cmc_field_init(const char *name,
+                           const enum cmc_ConfigFieldTypeEnum type,
+                           const void *default_value, const bool optional,
+                           struct cmc_Arena *arena,
+                           struct cmc_ConfigField *field) {
+  cme_error_t err;
+
+  if (!name || !field) {
+    err = cme_error(EINVAL, "`name` and `field` cannot be NULL");
+    goto error_out;
+  }
+
+  const uint32_t name_len = strlen(name);
+  const struct cmc_Hash name_hash = cmc_hash_str(name, name_len);
+  field->name = cmc_field_name_create(arena, name, name_len, name_hash.hash);
+  if (!field->name) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `field->name`");
+    goto error_out;
+  }
+
+  field->_name_hash = name_hash.hash;
+  field->_name_hash_pow = name_hash.pow;
+  field->_elements = NULL;
+  field->_is_borrowed = false;
+  field->_arena = arena;
+  field->_is_value_shared = false;
+  field->_is_name_borrowed = false;
+  field->_is_value_borrowed = false;
+  field->_id = 0;
+  field->_dict_slots = NULL;
+  field->_dict_slots_max = 0;
+  field->_array_len = 0;
+  field->_ints = NULL;
+  field->_strs = NULL;
+  field->_prototype = NULL;
+  field->_index_key = NULL;
+  field->_index_slots = NULL;
+  field->_index_slots_max = 0;
+
+  err = cmc_tree_node_create(&field->_self);
   if (err) {
-    goto error_field_cleanup;
+    goto error_field_name_cleanup;
   }
 
   if (!optional) {
     default_value = NULL;
   }
 
-  local_field->value = NULL;
+  field->value = NULL;
   if (default_value) {
     switch (type) {
     case cmc_ConfigFieldTypeEnum_INT:
-      err = cmc_field_add_value_int(local_field, *(int32_t *)default_value);
+      err = cmc_field_add_value_int(field, *(int32_t *)default_value);
       break;
     case cmc_ConfigFieldTypeEnum_STRING:
-      err = cmc_field_add_value_str(local_field, (char *)default_value);
+      err = cmc_field_add_value_str(field, (char *)default_value);
       break;
     case cmc_ConfigFieldTypeEnum_DICT:
     case cmc_ConfigFieldTypeEnum_ARRAY:
-      local_field->value = NULL;
+      field->value = NULL;
       break;
     default:
       err = cme_errorf(EINVAL, "`type=%d` unrecognized", type);
-      goto error_field_name_cleanup;
     }
   }
   if (err) {
-    goto error_field_cleanup;
+    goto error_field_name_cleanup;
   }
 
-  local_field->optional = optional;
-  local_field->type = type;
-  *field = local_field;
+  field->optional = optional;
+  field->type = type;
 
   return NULL;
 
 error_field_name_cleanup:
-  free(local_field->name);
-error_field_cleanup:
-  free(local_field);
+  cmc_field_name_destroy(field);
+  field->name = NULL;
 error_out:
   return cme_return(err);
 };
 
+cme_error_t
+cmc_field_init_borrowed(const struct cmc_ConfigFieldDescriptor *descriptor,
+                        struct cmc_Arena *arena,
+                        struct cmc_ConfigField *field) {
+  cme_error_t err;
+
+  if (!descriptor || !descriptor->name || !field) {
+    err = cme_error(EINVAL, "`descriptor`, `descriptor->name` and `field` "
+                            "cannot be NULL");
+    goto error_out;
+  }
+
+  const struct cmc_Hash name_hash =
+      cmc_hash_str(descriptor->name, strlen(descriptor->name));
+
+  field->name = (char *)descriptor->name;
+  field->value = NULL;
+  field->optional = descriptor->optional;
+  field->type = descriptor->type;
+  field->_name_hash = name_hash.hash;
+  field->_name_hash_pow = name_hash.pow;
+  field->_elements = NULL;
+  field->_is_borrowed = false;
+  field->_arena = arena;
+  field->_is_value_shared = false;
+  field->_is_name_borrowed = true;
+  field->_is_value_borrowed = false;
+  field->_id = 0;
+  field->_dict_slots = NULL;
+  field->_dict_slots_max = 0;
+  field->_array_len = 0;
+  field->_ints = NULL;
+  field->_strs = NULL;
+  field->_prototype = NULL;
+  field->_index_key = NULL;
+  field->_index_slots = NULL;
+  field->_index_slots_max = 0;
+
+  err = cmc_tree_node_create(&field->_self);
+  if (err) {
+    goto error_out;
+  }
+
+  const void *default_value =
+      descriptor->optional ? descriptor->default_value : NULL;
+
+  switch (descriptor->type) {
+  case cmc_ConfigFieldTypeEnum_INT:
+    if (default_value) {
+      field->_value.int_value = *(const int32_t *)default_value;
+      field->value = &field->_value.int_value;
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_STRING:
+    if (default_value) {
+      field->value = (void *)default_value;
+      field->_is_value_borrowed = true;
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_DICT:
+  case cmc_ConfigFieldTypeEnum_ARRAY:
+    break;
+  default:
+    err = cme_errorf(EINVAL, "`type=%d` unrecognized", descriptor->type);
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
 cme_error_t cmc_field_add_subfield(struct cmc_ConfigField *field,
                                    struct cmc_ConfigField *child_field) {
   cme_error_t err;
@@ -111,12 +273,43 @@ cme_error_t cmc_field_add_subfield(struct cmc_ConfigField *field,
     goto error_out;
   }
 
-  err = cmc_tree_node_add_subnode(&child_field->_self, &field->_self);
+  if (child_field->_arena != field->_arena) {
+    err = cme_error(EINVAL, "`child_field` has to be allocated from the same "
+                            "memory as `field`");
+    goto error_out;
+  }
+
+  if (cmc_field_array_is_packed(field)) {
+    err = cmc_field_array_unpack(field);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  err = cmc_tree_node_add_subnode(field->_arena, &child_field->_self,
+                                  &field->_self);
   if (err) {
     goto error_out;
   }
 
+  if (field->type == cmc_ConfigFieldTypeEnum_DICT) {
+    err = cmc_field_dict_index(field);
+    if (err) {
+      goto error_subnode_cleanup;
+    }
+  } else {
+    field->_array_len = field->_self.subnodes_len;
+    // Members of the child may still change, elements are scanned until
+    //  the next parse builds the index again.
+    cmc_free(field->_arena, field->_index_slots);
+    field->_index_slots = NULL;
+    field->_index_slots_max = 0;
+  }
+
   return NULL;
+
+error_subnode_cleanup:
+  cmc_tree_node_pop_subnode(&field->_self);
 error_out:
   return cme_return(err);
 }
@@ -140,7 +333,7 @@ cme_error_t cmc_field_get_str(const struct cmc_ConfigField *field,
 cme_error_t cmc_field_get_int(const struct cmc_ConfigField *field,
                               int32_t *output) {
   if (field->value) {
-    *output = *(int32_t *)field->value;
+    *output = field->_value.int_value;
   } else if (field->optional) {
     *output = 0;
   } else {
@@ -158,12 +351,30 @@ void cmc_field_destroy(struct cmc_ConfigField **field) {
     return;
   }
 
+  // Arena is released as a whole by the config, together with every
+  //  field in it.
+  if ((*field)->_arena) {
+    *field = NULL;
+    return;
+  }
+
   CMC_FOREACH_FIELD(subfield, *field, { cmc_field_destroy(&subfield); });
 
-  cmc_tree_node_destroy(&(*field)->_self);
-  cmc_field_value_destroy(field);
-  free((*field)->name);
-  free((*field));
+  cmc_tree_node_destroy(NULL, &(*field)->_self);
+  cmc_field_destroy(&(*field)->_prototype);
+  cmc_field_value_destroy(*field);
+  cmc_field_name_destroy(*field);
+  cmc_heap_free((*field)->_elements);
+  cmc_heap_free((*field)->_dict_slots);
+  cmc_heap_free((*field)->_ints);
+  cmc_heap_free((*field)->_strs);
+  cmc_heap_free((*field)->_index_key);
+  cmc_heap_free((*field)->_index_slots);
+  // Array elements instantiated in bulk share the array's `_elements`
+  //  block, which is freed together with the array.
+  if (!(*field)->_is_borrowed) {
+    cmc_heap_free(*field);
+  }
   *field = NULL;
 }
 
@@ -175,16 +386,81 @@ cme_error_t cmc_field_add_value_str(struct cmc_ConfigField *field,
     goto error_out;
   }
 
-  if (field->value) {
-    free(field->value);
-    field->value = NULL;
+  err = cmc_field_add_value_strn(field, value, strlen(value));
+  if (err) {
+    goto error_out;
   }
 
-  err = cmc_alloc_field_value_str(value, &field->value);
-  if (err) {
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_add_value_strn(struct cmc_ConfigField *field,
+                                     const char *value,
+                                     const size_t value_len) {
+  cme_error_t err;
+  if (!field || !value) {
+    err = cme_error(EINVAL, "`field` and `value` cannot be NULL");
+    goto error_out;
+  }
+
+  // Short strings are kept inline, only long ones cost an allocation.
+  //  New value is in place before the old one is released, as both may
+  //  overlap.
+  char *local_value = field->_value.str_value;
+  if (value_len > CMC_FIELD_INLINE_STR_MAX) {
+    local_value = cmc_strndup(field->_arena, value, value_len);
+    if (!local_value) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `field->value`");
+      goto error_out;
+    }
+  } else {
+    memmove(local_value, value, value_len);
+    local_value[value_len] = 0;
+  }
+
+  cmc_field_value_destroy(field);
+  field->value = local_value;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_add_value_strn_shared(struct cmc_ConfigField *field,
+                                            const char *value,
+                                            const size_t value_len) {
+  cme_error_t err;
+  if (!field || !value) {
+    err = cme_error(EINVAL, "`field` and `value` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->_arena) {
+    err = cme_error(EINVAL, "Field in arena cannot share it's value");
+    goto error_out;
+  }
+
+  if (value_len > UINT32_MAX) {
+    err = cme_errorf(EFBIG, "Value is too long to share `value_len=%lu`",
+                     (unsigned long)value_len);
+    goto error_out;
+  }
+
+  char *local_value =
+      cmc_intern(value, value_len, cmc_hash_str(value, value_len).hash);
+  if (!local_value) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `field->value`");
     goto error_out;
   }
 
+  cmc_field_value_destroy(field);
+  field->value = local_value;
+  field->_is_value_shared = true;
+
   return NULL;
 
 error_out:
@@ -199,12 +475,130 @@ cme_error_t cmc_field_add_value_int(struct cmc_ConfigField *field,
     goto error_out;
   }
 
-  if (field->value) {
-    free(field->value);
-    field->value = NULL;
+  cmc_field_value_destroy(field);
+  field->_value.int_value = value;
+  field->value = &field->_value.int_value;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_set_name(struct cmc_ConfigField *field,
+                               const char *name, const uint32_t name_len,
+                               const struct cmc_Hash name_hash) {
+  cme_error_t err;
+  if (!field || !name) {
+    err = cme_error(EINVAL, "`field` and `name` cannot be NULL");
+    goto error_out;
+  }
+
+  char *local_name =
+      cmc_field_name_create(field->_arena, name, name_len, name_hash.hash);
+  if (!local_name) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `field->name`");
+    goto error_out;
+  }
+
+  cmc_field_name_destroy(field);
+  field->name = local_name;
+  field->_is_name_borrowed = false;
+  field->_name_hash = name_hash.hash;
+  field->_name_hash_pow = name_hash.pow;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_dict_get(const struct cmc_ConfigField *field,
+                               const char *key,
+                               struct cmc_ConfigField **child) {
+  cme_error_t err;
+
+  if (!field || !key || !child) {
+    err = cme_error(EINVAL, "`field`, `key` and `child` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_DICT) {
+    err = cme_errorf(EINVAL, "`field->type=%d` is not a dict", field->type);
+    goto error_out;
+  }
+
+  const uint32_t key_len = strlen(key);
+  *child = cmc_field_dict_find(field, key, key_len,
+                               cmc_hash_str(key, key_len).hash);
+  if (!*child) {
+    err = cme_errorf(ENOENT, "Missing `key=%s` in `field->name=%s`", key,
+                     field->name);
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_len(const struct cmc_ConfigField *field,
+                                uint32_t *len) {
+  cme_error_t err;
+
+  if (!field || !len) {
+    err = cme_error(EINVAL, "`field` and `len` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY) {
+    err = cme_errorf(EINVAL, "`field->type=%d` is not an array", field->type);
+    goto error_out;
+  }
+
+  *len = field->_array_len;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_get_int(const struct cmc_ConfigField *field,
+                                    const uint32_t index, int *output) {
+  cme_error_t err;
+
+  if (!field || !output) {
+    err = cme_error(EINVAL, "`field` and `output` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY) {
+    err = cme_errorf(EINVAL, "`field->type=%d` is not an array", field->type);
+    goto error_out;
+  }
+
+  if (index >= field->_array_len) {
+    err = cme_errorf(ENOENT, "Missing element `index=%u` of `field->name=%s`",
+                     index, field->name);
+    goto error_out;
+  }
+
+  if (field->_ints) {
+    *output = field->_ints[index];
+    return NULL;
+  }
+
+  const struct cmc_ConfigField *element =
+      cmc_field_of_node(field->_self.subnodes[field->_strs ? 0 : index]);
+  if (element->type != cmc_ConfigFieldTypeEnum_INT) {
+    err = cme_errorf(EINVAL, "Elements of `field->name=%s` are not integers",
+                     field->name);
+    goto error_out;
   }
 
-  err = cmc_alloc_field_value_int(value, &field->value);
+  err = cmc_field_get_int(element, output);
   if (err) {
     goto error_out;
   }
@@ -214,23 +608,451 @@ cme_error_t cmc_field_add_value_int(struct cmc_ConfigField *field,
 error_out:
   return cme_return(err);
 }
+
+cme_error_t cmc_field_array_get_str(const struct cmc_ConfigField *field,
+                                    const uint32_t index, char **output) {
+  cme_error_t err;
+
+  if (!field || !output) {
+    err = cme_error(EINVAL, "`field` and `output` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY) {
+    err = cme_errorf(EINVAL, "`field->type=%d` is not an array", field->type);
+    goto error_out;
+  }
+
+  if (index >= field->_array_len) {
+    err = cme_errorf(ENOENT, "Missing element `index=%u` of `field->name=%s`",
+                     index, field->name);
+    goto error_out;
+  }
+
+  if (field->_strs) {
+    *output = (char *)field->_strs + field->_strs[index];
+    return NULL;
+  }
+
+  const struct cmc_ConfigField *element =
+      cmc_field_of_node(field->_self.subnodes[field->_ints ? 0 : index]);
+  if (element->type != cmc_ConfigFieldTypeEnum_STRING) {
+    err = cme_errorf(EINVAL, "Elements of `field->name=%s` are not strings",
+                     field->name);
+    goto error_out;
+  }
+
+  err = cmc_field_get_str(element, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+void *cmc_field_array_value(const struct cmc_ConfigField *field,
+                            const uint32_t index) {
+  if (field->_ints) {
+    return &field->_ints[index];
+  }
+
+  if (field->_strs) {
+    return (char *)field->_strs + field->_strs[index];
+  }
+
+  return cmc_field_of_node(field->_self.subnodes[index])->value;
+}
+
+cme_error_t cmc_field_array_ints(const struct cmc_ConfigField *field,
+                                 const int32_t **ints, uint32_t *len) {
+  cme_error_t err;
+
+  if (!field || !ints || !len) {
+    err = cme_error(EINVAL, "`field`, `ints` and `len` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY ||
+      !field->_self.subnodes_len ||
+      cmc_field_of_node(field->_self.subnodes[0])->type !=
+          cmc_ConfigFieldTypeEnum_INT) {
+    err = cme_errorf(EINVAL, "`field->name=%s` is not an array of integers",
+                     field->name);
+    goto error_out;
+  }
+
+  if (field->_array_len && !field->_ints) {
+    err = cme_errorf(ENODATA, "Array `field->name=%s` was not parsed",
+                     field->name);
+    goto error_out;
+  }
+
+  *ints = field->_ints;
+  *len = field->_array_len;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_pack_ints(struct cmc_ConfigField *field,
+                                     int32_t *ints, const uint32_t len) {
+  cme_error_t err;
+
+  err = cmc_field_array_drop(field);
+  if (err) {
+    goto error_out;
+  }
+
+  field->_ints = ints;
+  field->_array_len = len;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_pack_strs(struct cmc_ConfigField *field,
+                                     uint32_t *strs, const uint32_t len) {
+  cme_error_t err;
+
+  err = cmc_field_array_drop(field);
+  if (err) {
+    goto error_out;
+  }
+
+  field->_strs = strs;
+  field->_array_len = len;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_add_elements(struct cmc_ConfigField *field,
+                                         struct cmc_ConfigField *elements,
+                                         const uint32_t elements_len) {
+  struct cmc_TreeNode *subnodes[CMC_FIELD_ELEMENTS_CHUNK];
+  const uint32_t subnodes_len = field->_self.subnodes_len;
+  cme_error_t err;
+
+  if (elements_len > UINT32_MAX - subnodes_len) {
+    err = cme_errorf(EFBIG, "Too many elements `elements_len=%u`",
+                     elements_len);
+    goto error_out;
+  }
+
+  err = cmc_tree_node_reserve_subnodes(field->_arena, &field->_self,
+                                       subnodes_len + elements_len);
+  if (err) {
+    goto error_out;
+  }
+
+  // Pointers are gathered on the stack, so no temporary list is allocated.
+  for (uint32_t i = 0; i < elements_len; i += CMC_FIELD_ELEMENTS_CHUNK) {
+    const uint32_t chunk_len = elements_len - i < CMC_FIELD_ELEMENTS_CHUNK
+                                   ? elements_len - i
+                                   : CMC_FIELD_ELEMENTS_CHUNK;
+    for (uint32_t j = 0; j < chunk_len; j++) {
+      subnodes[j] = &elements[i + j]._self;
+    }
+
+    err = cmc_tree_node_add_subnodes(field->_arena, subnodes, chunk_len,
+                                     &field->_self);
+    if (err) {
+      goto error_subnodes_cleanup;
+    }
+  }
+
+  return NULL;
+
+error_subnodes_cleanup:
+  field->_self.subnodes_len = subnodes_len;
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_reset(struct cmc_ConfigField *field,
+                            const struct cmc_ConfigField *prototype) {
+  cme_error_t err = NULL;
+
+  if (field->type != prototype->type) {
+    err = cme_errorf(EINVAL, "`field->name=%s` does not match it's prototype",
+                     field->name);
+    goto error_out;
+  }
+
+  switch (field->type) {
+  case cmc_ConfigFieldTypeEnum_INT:
+    if (prototype->value) {
+      err = cmc_field_add_value_int(field, *(int32_t *)prototype->value);
+    } else {
+      cmc_field_value_destroy(field);
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_STRING:
+    if (prototype->value) {
+      err = cmc_field_add_value_str(field, prototype->value);
+    } else {
+      cmc_field_value_destroy(field);
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_DICT:
+    for (uint32_t i = 0; i < field->_self.subnodes_len &&
+                         i < prototype->_self.subnodes_len;
+         i++) {
+      err = cmc_field_reset(cmc_field_of_node(field->_self.subnodes[i]),
+                            cmc_field_of_node(prototype->_self.subnodes[i]));
+      if (err) {
+        goto error_out;
+      }
+    }
+    break;
+  case cmc_ConfigFieldTypeEnum_ARRAY:
+    // Other elements are replaced by the next parse anyway.
+    if (field->_self.subnodes_len && prototype->_self.subnodes_len) {
+      err = cmc_field_reset(cmc_field_of_node(field->_self.subnodes[0]),
+                            cmc_field_of_node(prototype->_self.subnodes[0]));
+    }
+    break;
+  default:;
+  }
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_index(struct cmc_ConfigField *field,
+                                  const char *key) {
+  cme_error_t err;
+
+  if (!field || !key) {
+    err = cme_error(EINVAL, "`field` and `key` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY ||
+      !field->_self.subnodes_len ||
+      cmc_field_of_node(field->_self.subnodes[0])->type !=
+          cmc_ConfigFieldTypeEnum_DICT) {
+    err = cme_errorf(EINVAL, "`field->name=%s` is not an array of dicts",
+                     field->name);
+    goto error_out;
+  }
+
+  const uint32_t key_len = strlen(key);
+  const struct cmc_ConfigField *member =
+      cmc_field_dict_find(cmc_field_of_node(field->_self.subnodes[0]), key,
+                          key_len, cmc_hash_str(key, key_len).hash);
+  if (!member || (member->type != cmc_ConfigFieldTypeEnum_STRING &&
+                  member->type != cmc_ConfigFieldTypeEnum_INT)) {
+    err = cme_errorf(EINVAL, "Elements of `field->name=%s` have no string or "
+                             "integer `key=%s`",
+                     field->name, key);
+    goto error_out;
+  }
+
+  char *local_key = cmc_strndup(field->_arena, key, key_len);
+  if (!local_key) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `key`");
+    goto error_out;
+  }
+
+  // Index of the previous key is dropped, the new one is built by the
+  //  next parse.
+  cmc_free(field->_arena, field->_index_key);
+  cmc_free(field->_arena, field->_index_slots);
+  field->_index_key = local_key;
+  field->_index_slots = NULL;
+  field->_index_slots_max = 0;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_index_build(struct cmc_ConfigField *field) {
+  cme_error_t err;
+
+  if (!field->_index_key) {
+    return NULL;
+  }
+
+  cmc_free(field->_arena, field->_index_slots);
+  field->_index_slots = NULL;
+  field->_index_slots_max = 0;
+
+  if (!field->_array_len) {
+    return NULL;
+  }
+
+  if (field->_array_len > UINT32_MAX / 4) {
+    err = cme_errorf(EFBIG, "Too many elements to index `field->name=%s`",
+                     field->name);
+    goto error_out;
+  }
+
+  // At most half of slots is used, so probe sequences stay short.
+  uint32_t slots_max = 8;
+  while (slots_max < field->_array_len * 2) {
+    slots_max *= 2;
+  }
+
+  const size_t slots_size = slots_max * sizeof(struct cmc_FieldIndexSlot);
+  struct cmc_FieldIndexSlot *slots = cmc_alloc(field->_arena, slots_size);
+  if (!slots) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `slots`");
+    goto error_out;
+  }
+  memset(slots, 0, slots_size);
+
+  const uint32_t key_len = strlen(field->_index_key);
+  const uint64_t key_hash = cmc_hash_str(field->_index_key, key_len).hash;
+  const uint32_t slots_mask = slots_max - 1;
+
+  // Probing never passes an equal value, so the first of elements with
+  //  equal values is the one found.
+  for (uint32_t i = 0; i < field->_array_len; i++) {
+    struct cmc_ConfigField *element =
+        cmc_field_of_node(field->_self.subnodes[i]);
+    const struct cmc_ConfigField *member =
+        cmc_field_dict_find(element, field->_index_key, key_len, key_hash);
+    if (!member || !member->value) {
+      continue;
+    }
+
+    uint32_t j = cmc_field_value_hash(member->type, member->value) & slots_mask;
+    while (slots[j].element) {
+      j = (j + 1) & slots_mask;
+    }
+    slots[j] =
+        (struct cmc_FieldIndexSlot){.element = element, .member = member};
+  }
+
+  field->_index_slots = slots;
+  field->_index_slots_max = slots_max;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_find(const struct cmc_ConfigField *field,
+                                 const char *key, const char *value,
+                                 struct cmc_ConfigField **element) {
+  cme_error_t err;
+
+  if (!value) {
+    err = cme_error(EINVAL, "`value` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmc_field_array_lookup(field, key, cmc_ConfigFieldTypeEnum_STRING,
+                               value, element);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_field_array_find_int(const struct cmc_ConfigField *field,
+                                     const char *key, const int value,
+                                     struct cmc_ConfigField **element) {
+  const int32_t local_value = value;
+  cme_error_t err;
+
+  err = cmc_field_array_lookup(field, key, cmc_ConfigFieldTypeEnum_INT,
+                               &local_value, element);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
 struct cmc_ConfigField *cmc_field_of_node(struct cmc_TreeNode *node_ptr) {
   return cmc_container_of(node_ptr, struct cmc_ConfigField, _self);
 };
 
-static inline cme_error_t cmc_alloc_field_value_str(const char *value,
-                                                    void **field_value) {
+static void cmc_field_value_destroy(struct cmc_ConfigField *field) {
+  if (!field) {
+    return;
+  }
+
+  // Inline and borrowed values are not owned by the field, nothing to
+  //  release.
+  if (field->_is_value_shared) {
+    cmc_intern_release(field->value);
+  } else if (field->value != (void *)&field->_value &&
+             !field->_is_value_borrowed) {
+    cmc_free(field->_arena, field->value);
+  }
+
+  field->value = NULL;
+  field->_is_value_shared = false;
+  field->_is_value_borrowed = false;
+}
+
+// Called after a child is appended. Table is rebuilt twice as big once
+//  half of it is used, otherwise only the new child is placed.
+static cme_error_t cmc_field_dict_index(struct cmc_ConfigField *field) {
+  const uint32_t children_len = field->_self.subnodes_len;
   cme_error_t err;
-  if (!value || !field_value) {
-    err = cme_error(EINVAL, "`value` and `field_value` cannot be NULL");
+
+  if (children_len <= CMC_FIELD_DICT_SCAN_MAX) {
+    return NULL;
+  }
+
+  if ((uint64_t)children_len * 2 <= field->_dict_slots_max) {
+    cmc_field_dict_place(field, children_len - 1);
+    return NULL;
+  }
+
+  if (children_len > UINT32_MAX / 4) {
+    err = cme_errorf(EFBIG, "Too many children of `field->name=%s`",
+                     field->name);
     goto error_out;
   }
 
-  *field_value = strdup(value);
-  if (!*field_value) {
-    err = cme_error(ENOMEM, "Unable to allocate memory for `field->value`");
+  uint32_t slots_max = field->_dict_slots_max ? field->_dict_slots_max : 16;
+  while (slots_max < children_len * 2) {
+    slots_max *= 2;
+  }
+
+  uint32_t *slots = cmc_alloc(field->_arena, slots_max * sizeof(uint32_t));
+  if (!slots) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `slots`");
     goto error_out;
   }
+  memset(slots, 0, slots_max * sizeof(uint32_t));
+
+  cmc_free(field->_arena, field->_dict_slots);
+  field->_dict_slots = slots;
+  field->_dict_slots_max = slots_max;
+
+  for (uint32_t i = 0; i < children_len; i++) {
+    cmc_field_dict_place(field, i);
+  }
 
   return NULL;
 
@@ -238,36 +1060,252 @@ error_out:
   return cme_return(err);
 }
 
-static inline cme_error_t cmc_alloc_field_value_int(const int32_t value,
-                                                    void **field_value) {
+// Probing never passes an equal key, so the first of duplicated keys is
+//  the one found.
+static void cmc_field_dict_place(struct cmc_ConfigField *field,
+                                 const uint32_t index) {
+  const struct cmc_ConfigField *subfield =
+      cmc_field_of_node(field->_self.subnodes[index]);
+  const uint32_t slots_mask = field->_dict_slots_max - 1;
+
+  uint32_t i = cmc_hash_finalize(subfield->_name_hash) & slots_mask;
+  while (field->_dict_slots[i]) {
+    i = (i + 1) & slots_mask;
+  }
+  field->_dict_slots[i] = index + 1;
+}
+
+static struct cmc_ConfigField *
+cmc_field_dict_find(const struct cmc_ConfigField *field, const char *key,
+                    const uint32_t key_len, const uint64_t key_hash) {
+  if (field->_dict_slots) {
+    const uint32_t slots_mask = field->_dict_slots_max - 1;
+    for (uint32_t i = cmc_hash_finalize(key_hash) & slots_mask;
+         field->_dict_slots[i]; i = (i + 1) & slots_mask) {
+      struct cmc_ConfigField *subfield =
+          cmc_field_of_node(field->_self.subnodes[field->_dict_slots[i] - 1]);
+      if (subfield->_name_hash == key_hash &&
+          cmc_field_name_equal(subfield, key, key_len)) {
+        return subfield;
+      }
+    }
+  } else {
+    CMC_FOREACH_FIELD(subfield, field, {
+      if (subfield->_name_hash == key_hash &&
+          cmc_field_name_equal(subfield, key, key_len)) {
+        return subfield;
+      }
+    });
+  }
+
+  return NULL;
+}
+
+static cme_error_t
+cmc_field_array_lookup(const struct cmc_ConfigField *field, const char *key,
+                       const enum cmc_ConfigFieldTypeEnum type,
+                       const void *value, struct cmc_ConfigField **element) {
   cme_error_t err;
-  if (!field_value) {
-    err = cme_error(EINVAL, "`field_value` cannot be NULL");
+
+  if (!field || !key || !element) {
+    err = cme_error(EINVAL, "`field`, `key` and `element` cannot be NULL");
     goto error_out;
   }
 
-  int32_t *local_int = malloc(sizeof(int32_t));
-  if (!local_int) {
-    err = cme_error(ENOMEM, "Unable to allocate memory for `field->value`");
+  if (field->type != cmc_ConfigFieldTypeEnum_ARRAY) {
+    err = cme_errorf(EINVAL, "`field->type=%d` is not an array", field->type);
     goto error_out;
   }
 
-  *local_int = value;
-  *field_value = local_int;
+  // Failed parse leaves no elements, index of the previous ones is unused.
+  if (field->_array_len && field->_index_slots &&
+      cmc_field_key_equal(field->_index_key, key)) {
+    const uint32_t slots_mask = field->_index_slots_max - 1;
+    for (uint32_t i = cmc_field_value_hash(type, value) & slots_mask;
+         field->_index_slots[i].element; i = (i + 1) & slots_mask) {
+      const struct cmc_FieldIndexSlot *slot = &field->_index_slots[i];
+      if (cmc_field_value_equal(slot->member, type, value)) {
+        *element = slot->element;
+        return NULL;
+      }
+    }
+  } else {
+    const uint32_t key_len = strlen(key);
+    const uint64_t key_hash = cmc_hash_str(key, key_len).hash;
+    for (uint32_t i = 0; i < field->_array_len; i++) {
+      struct cmc_ConfigField *local_element =
+          cmc_field_of_node(field->_self.subnodes[i]);
+      if (local_element->type != cmc_ConfigFieldTypeEnum_DICT) {
+        continue;
+      }
+
+      const struct cmc_ConfigField *member =
+          cmc_field_dict_find(local_element, key, key_len, key_hash);
+      if (member && cmc_field_value_equal(member, type, value)) {
+        *element = local_element;
+        return NULL;
+      }
+    }
+  }
+
+  err = cme_errorf(ENOENT, "No element of `field->name=%s` matches `key=%s`",
+                   field->name, key);
+
+error_out:
+  return cme_return(err);
+}
+
+// Strings are hashed folded like names, equal values differing in case
+//  only share a bucket and are told apart by comparison.
+static uint32_t cmc_field_value_hash(const enum cmc_ConfigFieldTypeEnum type,
+                                     const void *value) {
+  if (type == cmc_ConfigFieldTypeEnum_INT) {
+    const uint32_t int_value = (uint32_t)*(const int32_t *)value;
+    return cmc_hash_finalize(int_value);
+  }
+
+  return cmc_hash_finalize(
+      cmc_hash_str((const char *)value, strlen((const char *)value)).hash);
+}
+
+static bool cmc_field_value_equal(const struct cmc_ConfigField *member,
+                                  const enum cmc_ConfigFieldTypeEnum type,
+                                  const void *value) {
+  if (member->type != type || !member->value) {
+    return false;
+  }
+
+  if (type == cmc_ConfigFieldTypeEnum_INT) {
+    return *(const int32_t *)member->value == *(const int32_t *)value;
+  }
+
+  return strcmp(member->value, value) == 0;
+}
+
+// Member names are matched like other names, ignoring case.
+static bool cmc_field_key_equal(const char *a, const char *b) {
+  while (*a && cmc_hash_fold(*a) == cmc_hash_fold(*b)) {
+    a++;
+    b++;
+  }
+
+  return cmc_hash_fold(*a) == cmc_hash_fold(*b);
+}
+
+// Arena is dropped without visiting its fields, so names of arena fields
+//  are plain copies and never hold a reference to the intern pool.
+static char *cmc_field_name_create(struct cmc_Arena *arena, const char *name,
+                                   const uint32_t name_len,
+                                   const uint64_t name_hash) {
+  return arena ? cmc_strndup(arena, name, name_len)
+               : cmc_intern(name, name_len, name_hash);
+}
+
+static void cmc_field_name_destroy(struct cmc_ConfigField *field) {
+  if (!field->_arena && !field->_is_name_borrowed) {
+    cmc_intern_release(field->name);
+  }
+}
+
+// Elements of a packed array get their fields back, so the array can be
+//  extended like an array which was never parsed. Prototype becomes the
+//  first element, the rest lives in one block like parsed elements do.
+//  Packed arrays have at least one element.
+static cme_error_t cmc_field_array_unpack(struct cmc_ConfigField *field) {
+  struct cmc_ConfigField *prototype =
+      cmc_field_of_node(field->_self.subnodes[0]);
+  struct cmc_ConfigField *elements = NULL;
+  uint32_t elements_len = 0;
+  cme_error_t err;
+
+  // Room for the subfield being added too, so adding it does not fail
+  //  once the buffer is gone.
+  err = cmc_tree_node_reserve_subnodes(field->_arena, &field->_self,
+                                       field->_array_len + 1);
+  if (err) {
+    goto error_out;
+  }
+
+  if (field->_array_len > 1) {
+    const size_t elements_size =
+        (field->_array_len - 1) * sizeof(struct cmc_ConfigField);
+    elements = cmc_alloc(field->_arena, elements_size);
+    if (!elements) {
+      err = cme_error(ENOMEM, "Unable to allocate memory for `elements`");
+      goto error_out;
+    }
+    memset(elements, 0, elements_size);
+  }
+
+  for (; elements_len + 1 < field->_array_len; elements_len++) {
+    err = cmc_field_init(prototype->name, prototype->type,
+                         cmc_field_array_value(field, elements_len + 1), true,
+                         field->_arena, &elements[elements_len]);
+    if (err) {
+      goto error_elements_cleanup;
+    }
+    elements[elements_len].optional = prototype->optional;
+    elements[elements_len]._is_borrowed = true;
+  }
+
+  err = cmc_field_array_add_elements(field, elements, elements_len);
+  if (err) {
+    goto error_elements_cleanup;
+  }
+
+  err = field->_ints ? cmc_field_add_value_int(prototype, field->_ints[0])
+                     : cmc_field_add_value_str(
+                           prototype, cmc_field_array_value(field, 0));
+  if (err) {
+    goto error_subnodes_cleanup;
+  }
+
+  cmc_free(field->_arena, field->_ints);
+  cmc_free(field->_arena, field->_strs);
+  field->_ints = NULL;
+  field->_strs = NULL;
+  field->_elements = elements;
 
   return NULL;
+
+error_subnodes_cleanup:
+  field->_self.subnodes_len = 1;
+error_elements_cleanup:
+  for (uint32_t i = 0; i < elements_len; i++) {
+    struct cmc_ConfigField *element = &elements[i];
+    cmc_field_destroy(&element);
+  }
+  cmc_free(field->_arena, elements);
 error_out:
   return cme_return(err);
 }
 
-static void cmc_field_value_destroy(struct cmc_ConfigField **field) {
-  if (!field || !*field) {
-    return;
+// Element fields and values of an array are released, only the prototype
+//  is kept.
+static cme_error_t cmc_field_array_drop(struct cmc_ConfigField *field) {
+  cme_error_t err;
+
+  for (uint32_t i = 1; i < field->_self.subnodes_len; i++) {
+    struct cmc_ConfigField *element =
+        cmc_field_of_node(field->_self.subnodes[i]);
+    cmc_field_destroy(&element);
   }
 
-  struct cmc_ConfigField *ptr = *field;
+  err = cmc_tree_node_resize_subnodes(field->_arena, &field->_self, 1);
+  if (err) {
+    goto error_out;
+  }
 
-  free(ptr->value); // Only free scalar value
+  cmc_free(field->_arena, field->_elements);
+  cmc_free(field->_arena, field->_ints);
+  cmc_free(field->_arena, field->_strs);
+  field->_elements = NULL;
+  field->_ints = NULL;
+  field->_strs = NULL;
+  field->_array_len = 0;
 
-  ptr->value = NULL;
+  return NULL;
+
+error_out:
+  return cme_return(err);
 }
@@ -8,14 +8,126 @@
 #define C_MINILIB_CONFIG_CMC_FIELD_H
 
 #include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
+#include "utils/cmc_hash.h"
 #include "utils/cmc_tree.h"
 
+/**
+ * Same as `cmc_field_create` but memory comes from `arena`, NULL arena
+ * means heap.
+ */
+cme_error_t cmc_field_create_in(const char *name,
+                                const enum cmc_ConfigFieldTypeEnum type,
+                                const void *default_value, const bool optional,
+                                struct cmc_Arena *arena,
+                                struct cmc_ConfigField **field);
+
+/**
+ * Same as `cmc_field_create_in` but for a field whose storage is provided
+ * by the caller.
+ */
+cme_error_t cmc_field_init(const char *name,
+                           const enum cmc_ConfigFieldTypeEnum type,
+                           const void *default_value, const bool optional,
+                           struct cmc_Arena *arena,
+                           struct cmc_ConfigField *field);
+
+/**
+ * Same as `cmc_field_init` but name and default value are borrowed from
+ * `descriptor`, nothing is allocated. Children are not initialized.
+ */
+cme_error_t
+cmc_field_init_borrowed(const struct cmc_ConfigFieldDescriptor *descriptor,
+                        struct cmc_Arena *arena,
+                        struct cmc_ConfigField *field);
+
 cme_error_t cmc_field_add_value_str(struct cmc_ConfigField *field,
                                     const char *value);
 
+cme_error_t cmc_field_add_value_strn(struct cmc_ConfigField *field,
+                                     const char *value,
+                                     const size_t value_len);
+
+/**
+ * Same as `cmc_field_add_value_strn` but the value is hash-consed in the
+ * shared value store, see `cmc_ValueModeEnum_SHARED`. Heap fields only.
+ */
+cme_error_t cmc_field_add_value_strn_shared(struct cmc_ConfigField *field,
+                                            const char *value,
+                                            const size_t value_len);
+
 cme_error_t cmc_field_add_value_int(struct cmc_ConfigField *field,
                                     const int32_t value);
 
+/**
+ * Rename the field, `name_hash` is `cmc_hash_str` of the new name. Heap
+ * fields share their names through the intern pool.
+ */
+cme_error_t cmc_field_set_name(struct cmc_ConfigField *field,
+                               const char *name, const uint32_t name_len,
+                               const struct cmc_Hash name_hash);
+
+/**
+ * Hand values of all `len` elements of an array of integers or strings
+ * to the array, which takes ownership of the buffer and drops it's
+ * element fields, only the prototype is kept. `ints` holds the values,
+ * `strs` starts with offsets of NUL terminated values relative to it,
+ * see `_strs`. Buffers come from the array's arena. Called by parsers.
+ */
+cme_error_t cmc_field_array_pack_ints(struct cmc_ConfigField *field,
+                                     int32_t *ints, const uint32_t len);
+cme_error_t cmc_field_array_pack_strs(struct cmc_ConfigField *field,
+                                     uint32_t *strs, const uint32_t len);
+
+/**
+ * Append fields of the `elements` block as elements of an array, in bulk
+ * appends of the subnodes. On error no element is added.
+ */
+cme_error_t cmc_field_array_add_elements(struct cmc_ConfigField *field,
+                                         struct cmc_ConfigField *elements,
+                                         const uint32_t elements_len);
+
+/**
+ * Give every value of `field` and it's subfields the value of the
+ * matching field of `prototype`, which has the same shape. Parsers reset
+ * elements which outlive a parse with it.
+ */
+cme_error_t cmc_field_reset(struct cmc_ConfigField *field,
+                            const struct cmc_ConfigField *prototype);
+
+// Slot of the open addressing table of an array index, keyed by value of
+//  `member`.
+struct cmc_FieldIndexSlot {
+  struct cmc_ConfigField *element; // NULL marks an empty slot
+  const struct cmc_ConfigField *member;
+};
+
+/**
+ * Rebuild the index declared by `cmc_field_array_index`, parsers call it
+ * once elements of the array are parsed.
+ */
+cme_error_t cmc_field_array_index_build(struct cmc_ConfigField *field);
+
 void cmc_field_destroy(struct cmc_ConfigField **field);
 
+// Values of the array's elements live in a buffer, see `_strs`.
+static inline bool
+cmc_field_array_is_packed(const struct cmc_ConfigField *field) {
+  return field->_ints || field->_strs;
+}
+
+// Names are compared the same way parsers match keys, ignoring case.
+static inline bool cmc_field_name_equal(const struct cmc_ConfigField *field,
+                                        const char *name,
+                                        const uint32_t name_len) {
+  for (uint32_t i = 0; i < name_len; i++) {
+    if (!field->name[i] ||
+        cmc_hash_fold(field->name[i]) != cmc_hash_fold(name[i])) {
+      return false;
+    }
+  }
+
+  return field->name[name_len] == '\0';
+}
+
 #endif // C_MINILIB_CONFIG_CMC_FIELD_H
@@ -0,0 +1,502 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_field.h"
+#include "utils/cmc_hash.h"
+#include "utils/cmc_heap.h"
+#include "utils/cmc_tree.h"
+
+// Compact name record, see `cmc_frozen_add_name`.
+#define CMC_FROZEN_RECORD_HEADER_LEN 3
+#define CMC_FROZEN_PREFIX_MAX UINT16_MAX
+
+static cme_error_t cmc_frozen_create(const struct cmc_Config *config,
+                                     const bool is_compact,
+                                     struct cmc_FrozenConfig **frozen);
+static void cmc_frozen_count(const struct cmc_TreeNode *node,
+                             uint64_t *fields_len, uint64_t *strings_len);
+static uint32_t cmc_frozen_add_string(struct cmc_FrozenConfig *frozen,
+                                      const char *str);
+static uint32_t cmc_frozen_add_name(struct cmc_FrozenConfig *frozen,
+                                    const char *name, const char *head_name,
+                                    const uint32_t head_distance);
+static const char *
+cmc_frozen_name_suffix(const struct cmc_FrozenConfig *frozen,
+                       const uint32_t field, uint32_t *prefix_len,
+                       uint32_t *head);
+static bool cmc_frozen_name_equal(const char *name, const char *other);
+static cme_error_t
+cmc_frozen_missing_value(const struct cmc_FrozenConfig *frozen,
+                         const uint32_t field);
+static void cmc_frozen_fill(struct cmc_FrozenConfig *frozen,
+                            const struct cmc_TreeNode *node,
+                            const uint32_t parent, uint32_t *fields_len);
+static void cmc_frozen_fill_packed(struct cmc_FrozenConfig *frozen,
+                                   const struct cmc_ConfigField *array,
+                                   const uint32_t parent,
+                                   uint32_t *fields_len);
+
+cme_error_t cmc_config_freeze(const struct cmc_Config *config,
+                              struct cmc_FrozenConfig **frozen) {
+  cme_error_t err;
+
+  err = cmc_frozen_create(config, false, frozen);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_freeze_compact(const struct cmc_Config *config,
+                                      struct cmc_FrozenConfig **frozen) {
+  cme_error_t err;
+
+  err = cmc_frozen_create(config, true, frozen);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+void cmc_frozen_destroy(struct cmc_FrozenConfig **frozen) {
+  if (!frozen || !*frozen) {
+    return;
+  }
+
+  cmc_heap_free(*frozen);
+  *frozen = NULL;
+}
+
+cme_error_t cmc_frozen_find(const struct cmc_FrozenConfig *frozen,
+                            const uint32_t parent, const char *name,
+                            uint32_t *field) {
+  cme_error_t err;
+
+  if (!frozen || !name || !field) {
+    err = cme_error(EINVAL, "`frozen`, `name` and `field` cannot be NULL");
+    goto error_out;
+  }
+
+  if (parent >= frozen->fields_len) {
+    err = cme_errorf(EINVAL, "Unrecognized `parent=%u`", parent);
+    goto error_out;
+  }
+
+  if (!frozen->is_compact) {
+    CMC_FROZEN_FOREACH(child, frozen, parent) {
+      if (cmc_frozen_name_equal(frozen->strings + frozen->fields[child].name,
+                                name)) {
+        *field = child;
+        return NULL;
+      }
+    }
+  } else {
+    // Run head holds it's whole name. Prefix `name` shares with the head
+    //  rules out every name of the run which keeps a longer prefix of it,
+    //  the rest is decided by comparing suffixes only.
+    uint32_t head_shared_len = 0;
+    CMC_FROZEN_FOREACH(child, frozen, parent) {
+      uint32_t prefix_len, head;
+      const char *suffix =
+          cmc_frozen_name_suffix(frozen, child, &prefix_len, &head);
+
+      if (head == child) {
+        head_shared_len = 0;
+        while (name[head_shared_len] &&
+               cmc_hash_fold(name[head_shared_len]) ==
+                   cmc_hash_fold(suffix[head_shared_len])) {
+          head_shared_len++;
+        }
+      }
+
+      if (prefix_len <= head_shared_len &&
+          cmc_frozen_name_equal(name + prefix_len, suffix)) {
+        *field = child;
+        return NULL;
+      }
+    }
+  }
+
+  err = cme_errorf(ENOENT, "Missing field `name=%s`", name);
+
+error_out:
+  return cme_return(err);
+}
+
+const char *cmc_frozen_get_name(const struct cmc_FrozenConfig *frozen,
+                                const uint32_t field) {
+  if (frozen->is_compact) {
+    return NULL;
+  }
+
+  return frozen->strings + frozen->fields[field].name;
+}
+
+cme_error_t cmc_frozen_read_name(const struct cmc_FrozenConfig *frozen,
+                                 const uint32_t field, char *buffer,
+                                 const size_t buffer_len) {
+  cme_error_t err;
+
+  if (!frozen || !buffer) {
+    err = cme_error(EINVAL, "`frozen` and `buffer` cannot be NULL");
+    goto error_out;
+  }
+
+  if (field >= frozen->fields_len) {
+    err = cme_errorf(EINVAL, "Unrecognized `field=%u`", field);
+    goto error_out;
+  }
+
+  uint32_t prefix_len = 0;
+  uint32_t head = field;
+  const char *suffix = frozen->strings + frozen->fields[field].name;
+  if (frozen->is_compact) {
+    suffix = cmc_frozen_name_suffix(frozen, field, &prefix_len, &head);
+  }
+
+  const size_t suffix_len = strlen(suffix);
+  if (prefix_len + suffix_len >= buffer_len) {
+    err = cme_errorf(ERANGE, "Name of `field=%u` needs %lu bytes", field,
+                     (unsigned long)(prefix_len + suffix_len + 1));
+    goto error_out;
+  }
+
+  if (prefix_len) {
+    uint32_t head_prefix_len;
+    memcpy(buffer,
+           cmc_frozen_name_suffix(frozen, head, &head_prefix_len, &head),
+           prefix_len);
+  }
+  memcpy(buffer + prefix_len, suffix, suffix_len + 1);
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+enum cmc_ConfigFieldTypeEnum
+cmc_frozen_get_type(const struct cmc_FrozenConfig *frozen,
+                    const uint32_t field) {
+  return frozen->fields[field].flags & CMC_FROZEN_TYPE_MASK;
+}
+
+cme_error_t cmc_frozen_get_str(const struct cmc_FrozenConfig *frozen,
+                               const uint32_t field, const char **output) {
+  const struct cmc_FrozenField *frozen_field = &frozen->fields[field];
+
+  if (frozen_field->flags & CMC_FROZEN_FLAG_HAS_VALUE) {
+    *output = frozen->strings + frozen_field->value;
+  } else if (frozen_field->flags & CMC_FROZEN_FLAG_OPTIONAL) {
+    *output = NULL;
+  } else {
+    return cmc_frozen_missing_value(frozen, field);
+  }
+
+  return NULL;
+}
+
+cme_error_t cmc_frozen_get_int(const struct cmc_FrozenConfig *frozen,
+                               const uint32_t field, int *output) {
+  const struct cmc_FrozenField *frozen_field = &frozen->fields[field];
+
+  if (frozen_field->flags & CMC_FROZEN_FLAG_HAS_VALUE) {
+    *output = (int)frozen_field->value;
+  } else if (frozen_field->flags & CMC_FROZEN_FLAG_OPTIONAL) {
+    *output = 0;
+  } else {
+    return cmc_frozen_missing_value(frozen, field);
+  }
+
+  return NULL;
+}
+
+static void cmc_frozen_count(const struct cmc_TreeNode *node,
+                             uint64_t *fields_len, uint64_t *strings_len) {
+  CMC_TREE_SUBNODES_FOREACH(subnode, *node) {
+    const struct cmc_ConfigField *field = cmc_field_of_node(subnode);
+
+    *fields_len += 1;
+    *strings_len += strlen(field->name) + 1;
+    if (field->type == cmc_ConfigFieldTypeEnum_STRING && field->value) {
+      *strings_len += strlen(field->value) + 1;
+    }
+
+    // Every element of a packed array takes the prototype's name.
+    if (cmc_field_array_is_packed(field)) {
+      const struct cmc_ConfigField *prototype =
+          cmc_field_of_node(field->_self.subnodes[0]);
+      *fields_len += field->_array_len;
+      *strings_len += (uint64_t)field->_array_len *
+                      (strlen(prototype->name) + 1);
+      if (field->_strs) {
+        for (uint32_t i = 0; i < field->_array_len; i++) {
+          *strings_len += strlen(cmc_field_array_value(field, i)) + 1;
+        }
+      }
+      continue;
+    }
+
+    cmc_frozen_count(&field->_self, fields_len, strings_len);
+  }
+}
+
+static uint32_t cmc_frozen_add_string(struct cmc_FrozenConfig *frozen,
+                                      const char *str) {
+  const uint32_t offset = frozen->strings_len;
+  const size_t str_len = strlen(str) + 1;
+
+  memcpy(frozen->strings + offset, str, str_len);
+  frozen->strings_len += str_len;
+
+  return offset;
+}
+
+/*
+ * Compact name record is the distance back to the run head in one byte,
+ * length of the prefix shared with head's name in two bytes, little
+ * endian, and NULL terminated rest of the name. Head itself shares
+ * nothing, so it's record holds the whole name.
+ */
+static uint32_t cmc_frozen_add_name(struct cmc_FrozenConfig *frozen,
+                                    const char *name, const char *head_name,
+                                    const uint32_t head_distance) {
+  if (!frozen->is_compact) {
+    return cmc_frozen_add_string(frozen, name);
+  }
+
+  uint32_t prefix_len = 0;
+  if (head_distance) {
+    while (prefix_len < CMC_FROZEN_PREFIX_MAX && name[prefix_len] &&
+           name[prefix_len] == head_name[prefix_len]) {
+      prefix_len++;
+    }
+  }
+
+  const uint32_t offset = frozen->strings_len;
+  uint8_t *record = (uint8_t *)frozen->strings + offset;
+  record[0] = (uint8_t)head_distance;
+  record[1] = (uint8_t)prefix_len;
+  record[2] = (uint8_t)(prefix_len >> 8);
+  frozen->strings_len += CMC_FROZEN_RECORD_HEADER_LEN;
+
+  cmc_frozen_add_string(frozen, name + prefix_len);
+
+  return offset;
+}
+
+static const char *
+cmc_frozen_name_suffix(const struct cmc_FrozenConfig *frozen,
+                       const uint32_t field, uint32_t *prefix_len,
+                       uint32_t *head) {
+  const uint8_t *record =
+      (const uint8_t *)frozen->strings + frozen->fields[field].name;
+
+  *head = field - record[0];
+  *prefix_len = record[1] | (uint32_t)record[2] << 8;
+
+  return (const char *)record + CMC_FROZEN_RECORD_HEADER_LEN;
+}
+
+// Names are matched ignoring case, like in the live config.
+static bool cmc_frozen_name_equal(const char *name, const char *other) {
+  while (*name && cmc_hash_fold(*name) == cmc_hash_fold(*other)) {
+    name++;
+    other++;
+  }
+
+  return *name == *other;
+}
+
+static cme_error_t
+cmc_frozen_missing_value(const struct cmc_FrozenConfig *frozen,
+                         const uint32_t field) {
+  char name[128];
+
+  cme_error_t err = cmc_frozen_read_name(frozen, field, name, sizeof(name));
+  if (err) {
+    cme_error_destroy(err);
+    return cme_errorf(ENOENT, "Missing value in field `field=%u`", field);
+  }
+
+  return cme_errorf(ENOENT, "Missing value in field `field->name=%s`", name);
+}
+
+static void cmc_frozen_fill(struct cmc_FrozenConfig *frozen,
+                            const struct cmc_TreeNode *node,
+                            const uint32_t parent, uint32_t *fields_len) {
+  if (!node->subnodes_len) {
+    return;
+  }
+
+  // Children are placed next to each other before any grandchild, so
+  //  iterating over them walks the array forward.
+  const uint32_t first_child = *fields_len;
+  *fields_len += node->subnodes_len;
+  frozen->fields[parent].first_child = first_child;
+
+  for (uint32_t i = 0; i < node->subnodes_len; i++) {
+    const struct cmc_ConfigField *field = cmc_field_of_node(node->subnodes[i]);
+    struct cmc_FrozenField *frozen_field = &frozen->fields[first_child + i];
+
+    const uint32_t head_distance = i % CMC_FROZEN_RUN_LEN;
+    const struct cmc_ConfigField *head_field =
+        cmc_field_of_node(node->subnodes[i - head_distance]);
+    frozen_field->name = cmc_frozen_add_name(frozen, field->name,
+                                             head_field->name, head_distance);
+    frozen_field->value = 0;
+    frozen_field->first_child = CMC_FROZEN_NONE;
+    frozen_field->next_sibling =
+        i + 1 < node->subnodes_len ? first_child + i + 1 : CMC_FROZEN_NONE;
+    frozen_field->flags = field->type & CMC_FROZEN_TYPE_MASK;
+    if (field->optional) {
+      frozen_field->flags |= CMC_FROZEN_FLAG_OPTIONAL;
+    }
+
+    if (field->value) {
+      switch (field->type) {
+      case cmc_ConfigFieldTypeEnum_STRING:
+        frozen_field->value = cmc_frozen_add_string(frozen, field->value);
+        frozen_field->flags |= CMC_FROZEN_FLAG_HAS_VALUE;
+        break;
+      case cmc_ConfigFieldTypeEnum_INT:
+        frozen_field->value = (uint32_t)field->_value.int_value;
+        frozen_field->flags |= CMC_FROZEN_FLAG_HAS_VALUE;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < node->subnodes_len; i++) {
+    const struct cmc_ConfigField *field = cmc_field_of_node(node->subnodes[i]);
+    if (cmc_field_array_is_packed(field)) {
+      cmc_frozen_fill_packed(frozen, field, first_child + i, fields_len);
+    } else {
+      cmc_frozen_fill(frozen, &field->_self, first_child + i, fields_len);
+    }
+  }
+}
+
+// Elements of packed arrays have no fields, they are frozen from the
+//  array's buffer under the prototype's name.
+static void cmc_frozen_fill_packed(struct cmc_FrozenConfig *frozen,
+                                   const struct cmc_ConfigField *array,
+                                   const uint32_t parent,
+                                   uint32_t *fields_len) {
+  const struct cmc_ConfigField *prototype =
+      cmc_field_of_node(array->_self.subnodes[0]);
+
+  const uint32_t first_child = *fields_len;
+  *fields_len += array->_array_len;
+  frozen->fields[parent].first_child = first_child;
+
+  for (uint32_t i = 0; i < array->_array_len; i++) {
+    struct cmc_FrozenField *frozen_field = &frozen->fields[first_child + i];
+
+    frozen_field->name = cmc_frozen_add_name(
+        frozen, prototype->name, prototype->name, i % CMC_FROZEN_RUN_LEN);
+    frozen_field->value =
+        array->_ints ? (uint32_t)array->_ints[i]
+                     : cmc_frozen_add_string(
+                           frozen, cmc_field_array_value(array, i));
+    frozen_field->first_child = CMC_FROZEN_NONE;
+    frozen_field->next_sibling =
+        i + 1 < array->_array_len ? first_child + i + 1 : CMC_FROZEN_NONE;
+    frozen_field->flags = (prototype->type & CMC_FROZEN_TYPE_MASK) |
+                          CMC_FROZEN_FLAG_HAS_VALUE;
+    if (prototype->optional) {
+      frozen_field->flags |= CMC_FROZEN_FLAG_OPTIONAL;
+    }
+  }
+}
+
+static cme_error_t cmc_frozen_create(const struct cmc_Config *config,
+                                     const bool is_compact,
+                                     struct cmc_FrozenConfig **frozen) {
+  struct cmc_FrozenConfig *local_frozen;
+  cme_error_t err;
+
+  if (!config || !frozen) {
+    err = cme_error(EINVAL, "`config` and `frozen` cannot be NULL");
+    goto error_out;
+  }
+
+  // Sizes are counted upfront, so fields and strings share one allocation
+  //  and never move while the snapshot is built. Root has an empty name.
+  uint64_t fields_len = 1;
+  uint64_t strings_len = 1;
+  cmc_frozen_count(&config->_fields, &fields_len, &strings_len);
+  if (is_compact) {
+    strings_len += fields_len * CMC_FROZEN_RECORD_HEADER_LEN;
+  }
+
+  if (fields_len > UINT32_MAX || strings_len > UINT32_MAX) {
+    err = cme_errorf(EFBIG, "Config is too big to freeze `fields_len=%lu`",
+                     (unsigned long)fields_len);
+    goto error_out;
+  }
+
+  // Snapshot is allocated by config's allocator and freed through it.
+  struct cmc_Allocator *allocator = cmc_heap_use(config->settings->allocator);
+  const size_t fields_size = fields_len * sizeof(struct cmc_FrozenField);
+  local_frozen = cmc_heap_alloc(sizeof(struct cmc_FrozenConfig) +
+                                fields_size + strings_len);
+  cmc_heap_use(allocator);
+  if (!local_frozen) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `local_frozen`");
+    goto error_out;
+  }
+
+  local_frozen->fields = (struct cmc_FrozenField *)(local_frozen + 1);
+  local_frozen->fields_len = fields_len;
+  local_frozen->strings = (char *)local_frozen->fields + fields_size;
+  local_frozen->strings_len = 0;
+  local_frozen->is_compact = is_compact;
+
+  struct cmc_FrozenField *root = &local_frozen->fields[0];
+  memset(root, 0, sizeof(struct cmc_FrozenField));
+  root->name = cmc_frozen_add_name(local_frozen, "", "", 0);
+  root->flags = cmc_ConfigFieldTypeEnum_DICT;
+
+  uint32_t filled_len = 1;
+  cmc_frozen_fill(local_frozen, &config->_fields, 0, &filled_len);
+
+  // Space was reserved for full names, the unused tail is given back.
+  if (is_compact) {
+    struct cmc_FrozenConfig *shrunk_frozen =
+        cmc_heap_realloc(local_frozen, sizeof(struct cmc_FrozenConfig) +
+                                           fields_size +
+                                           local_frozen->strings_len);
+    if (shrunk_frozen) {
+      local_frozen = shrunk_frozen;
+      local_frozen->fields = (struct cmc_FrozenField *)(local_frozen + 1);
+      local_frozen->strings = (char *)local_frozen->fields + fields_size;
+    }
+  }
+
+  *frozen = local_frozen;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
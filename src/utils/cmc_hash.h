@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_HASH_H
+#define C_MINILIB_CONFIG_CMC_HASH_H
+
+#include <stdint.h>
+
+/*
+ * Case-folded polynomial hash of a name, H(s) = sum(fold(s[i]) * B^(n-1-i))
+ * mod 2^64. Hash of a concatenation is composed from hashes of its parts,
+ * H(a || b) = H(a) * B^|b| + H(b), so a flattened name like `ARR_0_KEY`
+ * is hashed in O(1) per segment from precomputed segment hashes.
+ */
+#define CMC_HASH_BASE 0x100000001b3ULL
+
+struct cmc_Hash {
+  uint64_t hash;
+  uint64_t pow; // B^len
+};
+
+static inline uint8_t cmc_hash_fold(const char c) {
+  return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : (uint8_t)c;
+}
+
+static inline struct cmc_Hash cmc_hash_init(void) {
+  return (struct cmc_Hash){.hash = 0, .pow = 1};
+}
+
+static inline struct cmc_Hash cmc_hash_str(const char *str,
+                                           const uint32_t str_len) {
+  struct cmc_Hash hash = cmc_hash_init();
+
+  for (uint32_t i = 0; i < str_len; i++) {
+    hash.hash = hash.hash * CMC_HASH_BASE + cmc_hash_fold(str[i]);
+    hash.pow *= CMC_HASH_BASE;
+  }
+
+  return hash;
+}
+
+static inline struct cmc_Hash cmc_hash_concat(const struct cmc_Hash prefix,
+                                              const struct cmc_Hash suffix) {
+  return (struct cmc_Hash){.hash = prefix.hash * suffix.pow + suffix.hash,
+                           .pow = prefix.pow * suffix.pow};
+}
+
+// Low bits of polynomial hash are weak, they are mixed before the hash is
+//  used to pick a bucket.
+static inline uint32_t cmc_hash_finalize(const uint64_t hash) {
+  uint64_t h = hash;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (uint32_t)h;
+}
+
+#endif // C_MINILIB_CONFIG_CMC_HASH_H
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_heap.h"
+
+// Header in front of every allocation, padded so memory after it keeps
+//  the alignment of malloc.
+union cmc_HeapHeader {
+  struct {
+    struct cmc_Allocator *allocator;
+    size_t size;
+  };
+  max_align_t align;
+};
+
+static _Thread_local struct cmc_Allocator *cmc_heap_current = NULL;
+
+static void *cmc_heap_raw_alloc(struct cmc_Allocator *allocator,
+                                const size_t size);
+static void *cmc_heap_raw_realloc(struct cmc_Allocator *allocator, void *ptr,
+                                  const size_t size);
+static void cmc_heap_raw_free(struct cmc_Allocator *allocator, void *ptr);
+static void cmc_heap_count(struct cmc_Allocator *allocator,
+                           const size_t old_size, const size_t size);
+
+void *cmc_heap_alloc(const size_t size) {
+  struct cmc_Allocator *allocator = cmc_heap_current;
+
+  if (size > SIZE_MAX - sizeof(union cmc_HeapHeader)) {
+    return NULL;
+  }
+
+  union cmc_HeapHeader *header =
+      cmc_heap_raw_alloc(allocator, sizeof(union cmc_HeapHeader) + size);
+  if (!header) {
+    return NULL;
+  }
+
+  header->allocator = allocator;
+  header->size = size;
+  cmc_heap_count(allocator, 0, size);
+
+  return header + 1;
+}
+
+void *cmc_heap_realloc(void *ptr, const size_t size) {
+  if (!ptr) {
+    return cmc_heap_alloc(size);
+  }
+
+  if (size > SIZE_MAX - sizeof(union cmc_HeapHeader)) {
+    return NULL;
+  }
+
+  // Memory stays with the allocator it came from.
+  union cmc_HeapHeader *header = (union cmc_HeapHeader *)ptr - 1;
+  struct cmc_Allocator *allocator = header->allocator;
+  const size_t old_size = header->size;
+
+  header = cmc_heap_raw_realloc(allocator, header,
+                                sizeof(union cmc_HeapHeader) + size);
+  if (!header) {
+    return NULL;
+  }
+
+  header->size = size;
+  cmc_heap_count(allocator, old_size, size);
+
+  return header + 1;
+}
+
+void cmc_heap_free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  union cmc_HeapHeader *header = (union cmc_HeapHeader *)ptr - 1;
+  struct cmc_Allocator *allocator = header->allocator;
+
+  if (allocator) {
+    allocator->bytes -= header->size;
+  }
+
+  cmc_heap_raw_free(allocator, header);
+}
+
+struct cmc_Allocator *cmc_heap_use(struct cmc_Allocator *allocator) {
+  struct cmc_Allocator *previous = cmc_heap_current;
+  cmc_heap_current = allocator;
+  return previous;
+}
+
+struct cmc_Allocator *cmc_heap_allocator(void) { return cmc_heap_current; }
+
+static void *cmc_heap_raw_alloc(struct cmc_Allocator *allocator,
+                                const size_t size) {
+  if (allocator && allocator->malloc) {
+    return allocator->malloc(size, allocator->ctx);
+  }
+  return malloc(size);
+}
+
+static void *cmc_heap_raw_realloc(struct cmc_Allocator *allocator, void *ptr,
+                                  const size_t size) {
+  if (allocator && allocator->realloc) {
+    return allocator->realloc(ptr, size, allocator->ctx);
+  }
+  return realloc(ptr, size);
+}
+
+static void cmc_heap_raw_free(struct cmc_Allocator *allocator, void *ptr) {
+  if (allocator && allocator->free) {
+    allocator->free(ptr, allocator->ctx);
+    return;
+  }
+  free(ptr);
+}
+
+static void cmc_heap_count(struct cmc_Allocator *allocator,
+                           const size_t old_size, const size_t size) {
+  if (!allocator) {
+    return;
+  }
+
+  allocator->allocations++;
+  allocator->bytes = allocator->bytes - old_size + size;
+  if (allocator->bytes > allocator->peak_bytes) {
+    allocator->peak_bytes = allocator->bytes;
+  }
+}
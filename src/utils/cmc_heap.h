@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_HEAP_H
+#define C_MINILIB_CONFIG_CMC_HEAP_H
+
+#include <stddef.h>
+
+#include "c_minilib_config.h"
+
+/*
+ * Heap memory of the library. Every allocation remembers the allocator it
+ * came from, so it is freed through the same hooks and counted against
+ * the same allocator, no matter which config or thread frees it. New
+ * allocations use the allocator of the calling thread, see
+ * `cmc_heap_use`, NULL allocator is libc without accounting.
+ */
+void *cmc_heap_alloc(const size_t size);
+void *cmc_heap_realloc(void *ptr, const size_t size);
+void cmc_heap_free(void *ptr);
+
+/*
+ * Make `allocator` current for the calling thread, returns the previous
+ * one which should be restored afterwards. Config functions do it for
+ * the allocator in config's settings. `cmc_heap_allocator` returns the
+ * current one.
+ */
+struct cmc_Allocator *cmc_heap_use(struct cmc_Allocator *allocator);
+struct cmc_Allocator *cmc_heap_allocator(void);
+
+#endif // C_MINILIB_CONFIG_CMC_HEAP_H
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/cmc_hash.h"
+#include "utils/cmc_heap.h"
+#include "utils/cmc_intern.h"
+#include "utils/cmc_tree.h"
+
+#define CMC_INTERN_BUCKETS_MIN 64
+
+struct cmc_InternEntry {
+  struct cmc_InternEntry *next;
+  struct cmc_InternPool *pool;
+  uint64_t hash;
+  uint32_t refs;
+  uint32_t str_len;
+  char str[];
+};
+
+// Strings are pooled per allocator, so memory of a pool comes from and is
+//  counted against one allocator and no string outlives the configs
+//  using it.
+struct cmc_InternPool {
+  struct cmc_InternPool *next;
+  struct cmc_Allocator *allocator;
+  struct cmc_InternEntry **buckets;
+  uint32_t buckets_len; // Power of 2
+  uint32_t entries_len;
+};
+
+static pthread_mutex_t cmc_intern_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct cmc_InternPool *cmc_intern_pools = NULL;
+
+static struct cmc_InternPool *
+cmc_intern_pool_get(struct cmc_Allocator *allocator);
+static void cmc_intern_pool_drop(struct cmc_InternPool *pool);
+static bool cmc_intern_grow(struct cmc_InternPool *pool);
+
+char *cmc_intern(const char *str, const uint32_t str_len, const uint64_t hash) {
+  struct cmc_InternEntry *entry = NULL;
+
+  pthread_mutex_lock(&cmc_intern_lock);
+
+  struct cmc_InternPool *pool = cmc_intern_pool_get(cmc_heap_allocator());
+  if (!pool) {
+    goto out;
+  }
+
+  if (pool->buckets_len) {
+    const uint32_t bucket =
+        cmc_hash_finalize(hash) & (pool->buckets_len - 1);
+    for (entry = pool->buckets[bucket]; entry; entry = entry->next) {
+      if (entry->hash == hash && entry->str_len == str_len &&
+          memcmp(entry->str, str, str_len) == 0) {
+        entry->refs++;
+        goto out;
+      }
+    }
+  }
+
+  // Load is kept under 1, so chains stay short.
+  if (pool->entries_len >= pool->buckets_len && !cmc_intern_grow(pool)) {
+    goto error_pool_cleanup;
+  }
+
+  entry = cmc_heap_alloc(sizeof(struct cmc_InternEntry) + str_len + 1);
+  if (!entry) {
+    goto error_pool_cleanup;
+  }
+
+  memcpy(entry->str, str, str_len);
+  entry->str[str_len] = 0;
+  entry->str_len = str_len;
+  entry->hash = hash;
+  entry->refs = 1;
+  entry->pool = pool;
+
+  const uint32_t bucket = cmc_hash_finalize(hash) & (pool->buckets_len - 1);
+  entry->next = pool->buckets[bucket];
+  pool->buckets[bucket] = entry;
+  pool->entries_len++;
+
+out:
+  pthread_mutex_unlock(&cmc_intern_lock);
+  return entry ? entry->str : NULL;
+
+error_pool_cleanup:
+  cmc_intern_pool_drop(pool);
+  goto out;
+}
+
+void cmc_intern_release(const char *str) {
+  if (!str) {
+    return;
+  }
+
+  struct cmc_InternEntry *entry =
+      cmc_container_of(str, struct cmc_InternEntry, str);
+  struct cmc_InternPool *pool = entry->pool;
+
+  pthread_mutex_lock(&cmc_intern_lock);
+
+  if (--entry->refs > 0) {
+    goto out;
+  }
+
+  const uint32_t bucket =
+      cmc_hash_finalize(entry->hash) & (pool->buckets_len - 1);
+  struct cmc_InternEntry **link = &pool->buckets[bucket];
+  while (*link != entry) {
+    link = &(*link)->next;
+  }
+  *link = entry->next;
+  cmc_heap_free(entry);
+  pool->entries_len--;
+
+  cmc_intern_pool_drop(pool);
+
+out:
+  pthread_mutex_unlock(&cmc_intern_lock);
+}
+
+static struct cmc_InternPool *
+cmc_intern_pool_get(struct cmc_Allocator *allocator) {
+  struct cmc_InternPool *pool;
+
+  // There are as many pools as allocators in use, usually one.
+  for (pool = cmc_intern_pools; pool; pool = pool->next) {
+    if (pool->allocator == allocator) {
+      return pool;
+    }
+  }
+
+  pool = cmc_heap_alloc(sizeof(struct cmc_InternPool));
+  if (!pool) {
+    return NULL;
+  }
+
+  pool->allocator = allocator;
+  pool->buckets = NULL;
+  pool->buckets_len = 0;
+  pool->entries_len = 0;
+  pool->next = cmc_intern_pools;
+  cmc_intern_pools = pool;
+
+  return pool;
+}
+
+// Pool is released together with it's last string, so it leaves nothing
+//  behind once all configs of it's allocator are destroyed.
+static void cmc_intern_pool_drop(struct cmc_InternPool *pool) {
+  if (pool->entries_len) {
+    return;
+  }
+
+  struct cmc_InternPool **link = &cmc_intern_pools;
+  while (*link != pool) {
+    link = &(*link)->next;
+  }
+  *link = pool->next;
+
+  cmc_heap_free(pool->buckets);
+  cmc_heap_free(pool);
+}
+
+static bool cmc_intern_grow(struct cmc_InternPool *pool) {
+  const uint32_t buckets_len =
+      pool->buckets_len ? pool->buckets_len * 2 : CMC_INTERN_BUCKETS_MIN;
+  if (buckets_len < pool->buckets_len) {
+    return false;
+  }
+
+  struct cmc_InternEntry **buckets =
+      cmc_heap_alloc(buckets_len * sizeof(struct cmc_InternEntry *));
+  if (!buckets) {
+    return false;
+  }
+  memset(buckets, 0, buckets_len * sizeof(struct cmc_InternEntry *));
+
+  for (uint32_t i = 0; i < pool->buckets_len; i++) {
+    struct cmc_InternEntry *entry = pool->buckets[i];
+    while (entry) {
+      struct cmc_InternEntry *next = entry->next;
+      const uint32_t bucket =
+          cmc_hash_finalize(entry->hash) & (buckets_len - 1);
+      entry->next = buckets[bucket];
+      buckets[bucket] = entry;
+      entry = next;
+    }
+  }
+
+  cmc_heap_free(pool->buckets);
+  pool->buckets = buckets;
+  pool->buckets_len = buckets_len;
+
+  return true;
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_INTERN_H
+#define C_MINILIB_CONFIG_CMC_INTERN_H
+
+#include <stdint.h>
+
+/*
+ * Process wide pool of field names and shared values. Equal strings share
+ * one reference counted copy, so configs built from the same schema store
+ * every name once and interned strings are equal only if their pointers
+ * are. Pool is guarded by a mutex, it can be used from any thread.
+ *
+ * Strings are kept apart per allocator current for the calling thread,
+ * see `cmc_heap_use`. Only configs of one allocator share them and their
+ * memory is counted against it, the allocator's part of the pool is freed
+ * with it's last string.
+ *
+ * `hash` is `cmc_hash_str` of the string, which fields already keep for
+ * their names. Interned strings are read-only. Returns NULL once memory is
+ * exhausted.
+ */
+char *cmc_intern(const char *str, const uint32_t str_len, const uint64_t hash);
+void cmc_intern_release(const char *str);
+
+#endif // C_MINILIB_CONFIG_CMC_INTERN_H
@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_field.h"
+#include "utils/cmc_hash.h"
+#include "utils/cmc_lookup.h"
+#include "utils/cmc_tree.h"
+
+static void cmc_lookup_count(const struct cmc_TreeNode *node,
+                             const bool is_array, uint64_t *fields_len,
+                             uint64_t *named_len);
+static void cmc_lookup_fill(struct cmc_Lookup *lookup,
+                            const struct cmc_TreeNode *node,
+                            const bool is_array);
+static cme_error_t cmc_lookup_resolve(const struct cmc_Config *config,
+                                      const char *path,
+                                      struct cmc_ConfigField **field,
+                                      uint32_t *element);
+static cme_error_t
+cmc_lookup_handle_resolve(const struct cmc_Config *config,
+                          struct cmc_FieldHandle *handle,
+                          struct cmc_ConfigField **field);
+static cme_error_t cmc_lookup_field_str(const struct cmc_ConfigField *field,
+                                        const uint32_t element,
+                                        const char *path, char **output);
+static cme_error_t cmc_lookup_field_int(const struct cmc_ConfigField *field,
+                                        const uint32_t element,
+                                        const char *path, int *output);
+static uint32_t cmc_lookup_slot(const struct cmc_Lookup *lookup,
+                                const struct cmc_TreeNode *parent,
+                                const uint64_t name_hash);
+static struct cmc_ConfigField *
+cmc_lookup_child(const struct cmc_Config *config,
+                 const struct cmc_TreeNode *parent, const char *name,
+                 const uint32_t name_len);
+
+cme_error_t cmc_lookup_create(struct cmc_Arena *arena,
+                              const struct cmc_TreeNode *fields,
+                              struct cmc_Lookup **lookup) {
+  uint64_t fields_len = 0, named_len = 0;
+  cme_error_t err;
+
+  cmc_lookup_count(fields, false, &fields_len, &named_len);
+  if (fields_len > UINT32_MAX / 2) {
+    err = cme_errorf(EFBIG, "Too many fields to index `fields_len=%llu`",
+                     (unsigned long long)fields_len);
+    goto error_out;
+  }
+
+  // At most half of slots is used, so probe sequences stay short.
+  uint32_t slots_len = 8;
+  while (slots_len < named_len * 2) {
+    slots_len *= 2;
+  }
+
+  const size_t slots_size = slots_len * sizeof(struct cmc_LookupSlot);
+  const size_t lookup_size = sizeof(struct cmc_Lookup) + slots_size +
+                             fields_len * sizeof(struct cmc_ConfigField *);
+  struct cmc_Lookup *local_lookup = cmc_alloc(arena, lookup_size);
+  if (!local_lookup) {
+    err = cme_error(ENOMEM, "Unable to allocate memory for `lookup`");
+    goto error_out;
+  }
+  memset(local_lookup, 0, lookup_size);
+
+  local_lookup->slots = (struct cmc_LookupSlot *)(local_lookup + 1);
+  local_lookup->slots_mask = slots_len - 1;
+  local_lookup->fields =
+      (struct cmc_ConfigField **)((char *)local_lookup->slots + slots_size);
+
+  cmc_lookup_fill(local_lookup, fields, false);
+
+  *lookup = local_lookup;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+void cmc_lookup_destroy(struct cmc_Arena *arena, struct cmc_Lookup **lookup) {
+  if (!lookup || !*lookup) {
+    return;
+  }
+
+  cmc_free(arena, *lookup);
+  *lookup = NULL;
+}
+
+struct cmc_ConfigField *cmc_lookup_find(const struct cmc_Lookup *lookup,
+                                        const struct cmc_TreeNode *parent,
+                                        const char *name,
+                                        const uint32_t name_len,
+                                        const uint64_t name_hash) {
+  for (uint32_t i = cmc_lookup_slot(lookup, parent, name_hash);
+       lookup->slots[i].field; i = (i + 1) & lookup->slots_mask) {
+    const struct cmc_LookupSlot *slot = &lookup->slots[i];
+    if (slot->parent == parent && slot->field->_name_hash == name_hash &&
+        cmc_field_name_equal(slot->field, name, name_len)) {
+      return slot->field;
+    }
+  }
+
+  return NULL;
+}
+
+cme_error_t cmc_config_get(const struct cmc_Config *config, const char *path,
+                           struct cmc_ConfigField **field) {
+  struct cmc_ConfigField *local_field;
+  uint32_t element;
+  cme_error_t err;
+
+  err = cmc_lookup_resolve(config, path, &local_field, &element);
+  if (err) {
+    goto error_out;
+  }
+
+  if (element != CMC_LOOKUP_NO_ELEMENT) {
+    err = cme_errorf(EINVAL,
+                     "Element of parsed array of `path=%s` has no field, "
+                     "read it by value", path);
+    goto error_out;
+  }
+
+  *field = local_field;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_get_str(const struct cmc_Config *config,
+                               const char *path, char **output) {
+  struct cmc_ConfigField *field;
+  uint32_t element;
+  cme_error_t err;
+
+  err = cmc_lookup_resolve(config, path, &field, &element);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmc_lookup_field_str(field, element, path, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_get_int(const struct cmc_Config *config,
+                               const char *path, int *output) {
+  struct cmc_ConfigField *field;
+  uint32_t element;
+  cme_error_t err;
+
+  err = cmc_lookup_resolve(config, path, &field, &element);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmc_lookup_field_int(field, element, path, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_handle_init(const struct cmc_Config *config,
+                                   const char *path,
+                                   struct cmc_FieldHandle *handle) {
+  struct cmc_ConfigField *field;
+  cme_error_t err;
+
+  if (!handle) {
+    err = cme_error(EINVAL, "`handle` cannot be NULL");
+    goto error_out;
+  }
+
+  handle->path = path;
+  handle->id = 0;
+  handle->generation = 0;
+  handle->element = CMC_LOOKUP_NO_ELEMENT;
+
+  err = cmc_lookup_handle_resolve(config, handle, &field);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_handle_get(const struct cmc_Config *config,
+                                  struct cmc_FieldHandle *handle,
+                                  struct cmc_ConfigField **field) {
+  struct cmc_ConfigField *local_field;
+  cme_error_t err;
+
+  if (!field) {
+    err = cme_error(EINVAL, "`field` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmc_lookup_handle_resolve(config, handle, &local_field);
+  if (err) {
+    goto error_out;
+  }
+
+  if (handle->element != CMC_LOOKUP_NO_ELEMENT) {
+    err = cme_errorf(EINVAL,
+                     "Element of parsed array of `path=%s` has no field, "
+                     "read it by value", handle->path);
+    goto error_out;
+  }
+
+  *field = local_field;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_handle_get_str(const struct cmc_Config *config,
+                                      struct cmc_FieldHandle *handle,
+                                      char **output) {
+  struct cmc_ConfigField *field;
+  cme_error_t err;
+
+  err = cmc_lookup_handle_resolve(config, handle, &field);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmc_lookup_field_str(field, handle->element, handle->path, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_config_handle_get_int(const struct cmc_Config *config,
+                                      struct cmc_FieldHandle *handle,
+                                      int *output) {
+  struct cmc_ConfigField *field;
+  cme_error_t err;
+
+  err = cmc_lookup_handle_resolve(config, handle, &field);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmc_lookup_field_int(field, handle->element, handle->path, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static void cmc_lookup_count(const struct cmc_TreeNode *node,
+                             const bool is_array, uint64_t *fields_len,
+                             uint64_t *named_len) {
+  CMC_TREE_SUBNODES_FOREACH(subnode, *node) {
+    const struct cmc_ConfigField *field = cmc_field_of_node(subnode);
+    (*fields_len)++;
+    if (!is_array) {
+      (*named_len)++;
+    }
+    cmc_lookup_count(&field->_self,
+                     field->type == cmc_ConfigFieldTypeEnum_ARRAY, fields_len,
+                     named_len);
+  }
+}
+
+static void cmc_lookup_fill(struct cmc_Lookup *lookup,
+                            const struct cmc_TreeNode *node,
+                            const bool is_array) {
+  CMC_TREE_SUBNODES_FOREACH(subnode, *node) {
+    struct cmc_ConfigField *field = cmc_field_of_node(subnode);
+    field->_id = lookup->fields_len;
+    lookup->fields[lookup->fields_len++] = field;
+
+    // Elements of packed arrays have no fields and array of one value
+    //  and array without values have equal subnodes, so the shape covers
+    //  `_array_len` too.
+    const uint64_t node_shape =
+        ((uint64_t)field->type << 32) | field->_self.subnodes_len;
+    lookup->shape = (lookup->shape ^ field->_name_hash) * CMC_HASH_BASE;
+    lookup->shape = (lookup->shape ^ node_shape) * CMC_HASH_BASE;
+    lookup->shape = (lookup->shape ^ field->_array_len) * CMC_HASH_BASE;
+
+    if (!is_array) {
+      // Probing never passes an equal key, so the first of duplicated
+      //  names is the one found.
+      uint32_t i = cmc_lookup_slot(lookup, node, field->_name_hash);
+      while (lookup->slots[i].field) {
+        i = (i + 1) & lookup->slots_mask;
+      }
+      lookup->slots[i] =
+          (struct cmc_LookupSlot){.parent = node, .field = field};
+    }
+    cmc_lookup_fill(lookup, &field->_self,
+                    field->type == cmc_ConfigFieldTypeEnum_ARRAY);
+  }
+}
+
+static cme_error_t cmc_lookup_field_str(const struct cmc_ConfigField *field,
+                                        const uint32_t element,
+                                        const char *path, char **output) {
+  cme_error_t err;
+
+  if (element != CMC_LOOKUP_NO_ELEMENT) {
+    err = cmc_field_array_get_str(field, element, output);
+    if (err) {
+      goto error_out;
+    }
+
+    return NULL;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_STRING) {
+    err = cme_errorf(EINVAL, "Field of `path=%s` is not a string", path);
+    goto error_out;
+  }
+
+  err = cmc_field_get_str(field, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmc_lookup_field_int(const struct cmc_ConfigField *field,
+                                        const uint32_t element,
+                                        const char *path, int *output) {
+  cme_error_t err;
+
+  if (element != CMC_LOOKUP_NO_ELEMENT) {
+    err = cmc_field_array_get_int(field, element, output);
+    if (err) {
+      goto error_out;
+    }
+
+    return NULL;
+  }
+
+  if (field->type != cmc_ConfigFieldTypeEnum_INT) {
+    err = cme_errorf(EINVAL, "Field of `path=%s` is not an integer", path);
+    goto error_out;
+  }
+
+  err = cmc_field_get_int(field, output);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+static uint32_t cmc_lookup_slot(const struct cmc_Lookup *lookup,
+                                const struct cmc_TreeNode *parent,
+                                const uint64_t name_hash) {
+  const uint64_t parent_hash =
+      (uint64_t)(uintptr_t)parent * 0x9e3779b97f4a7c15ULL;
+  return cmc_hash_finalize(name_hash ^ parent_hash) & lookup->slots_mask;
+}
+
+static struct cmc_ConfigField *
+cmc_lookup_child(const struct cmc_Config *config,
+                 const struct cmc_TreeNode *parent, const char *name,
+                 const uint32_t name_len) {
+  const uint64_t name_hash = cmc_hash_str(name, name_len).hash;
+
+  if (config->_lookup) {
+    return cmc_lookup_find(config->_lookup, parent, name, name_len, name_hash);
+  }
+
+  // Schema changed since the last parse, children are scanned instead.
+  CMC_TREE_SUBNODES_FOREACH(subnode, *parent) {
+    struct cmc_ConfigField *field = cmc_field_of_node(subnode);
+    if (field->_name_hash == name_hash &&
+        cmc_field_name_equal(field, name, name_len)) {
+      return field;
+    }
+  }
+
+  return NULL;
+}
+
+// Field at `path`, elements of packed arrays have no field, they resolve
+//  to the array and index of the element. `element` is
+//  `CMC_LOOKUP_NO_ELEMENT` for other fields.
+static cme_error_t cmc_lookup_resolve(const struct cmc_Config *config,
+                                      const char *path,
+                                      struct cmc_ConfigField **field,
+                                      uint32_t *element) {
+  struct cmc_ConfigField *current = NULL;
+  const char *cursor = path;
+  cme_error_t err;
+
+  if (!config || !path || !field) {
+    err = cme_error(EINVAL, "`config`, `path` and `field` cannot be NULL");
+    goto error_out;
+  }
+
+  while (true) {
+    const char *name = cursor;
+    while (*cursor && *cursor != '.' && *cursor != '[' && *cursor != ']') {
+      cursor++;
+    }
+
+    if (cursor == name) {
+      err = cme_errorf(EINVAL, "Missing name at `offset=%d` of `path=%s`",
+                       (int)(cursor - path), path);
+      goto error_out;
+    }
+
+    if (current && current->type != cmc_ConfigFieldTypeEnum_DICT) {
+      err = cme_errorf(EINVAL, "Field `name=%s` of `path=%s` is not a dict",
+                       current->name, path);
+      goto error_out;
+    }
+
+    current = cmc_lookup_child(config, current ? &current->_self
+                                               : &config->_fields,
+                               name, (uint32_t)(cursor - name));
+    if (!current) {
+      err = cme_errorf(ENOENT, "Missing field `%.*s` of `path=%s`",
+                       (int)(cursor - path), path, path);
+      goto error_out;
+    }
+
+    while (*cursor == '[') {
+      uint64_t index = 0;
+      const char *digits = ++cursor;
+      while (*cursor >= '0' && *cursor <= '9' && index <= UINT32_MAX) {
+        index = index * 10 + (uint64_t)(*cursor++ - '0');
+      }
+
+      if (cursor == digits || *cursor != ']') {
+        err = cme_errorf(EINVAL, "Malformed index at `offset=%d` of `path=%s`",
+                         (int)(digits - path), path);
+        goto error_out;
+      }
+      cursor++;
+
+      if (current->type != cmc_ConfigFieldTypeEnum_ARRAY) {
+        err = cme_errorf(EINVAL,
+                         "Field `name=%s` of `path=%s` is not an array",
+                         current->name, path);
+        goto error_out;
+      }
+
+      // Array without values keeps only its prototype.
+      if (index >= current->_array_len) {
+        err = cme_errorf(ENOENT, "Missing element `%.*s` of `path=%s`",
+                         (int)(cursor - path), path, path);
+        goto error_out;
+      }
+
+      if (cmc_field_array_is_packed(current)) {
+        if (*cursor != '\0') {
+          err = cme_errorf(EINVAL,
+                           "Element `%.*s` of `path=%s` has no fields",
+                           (int)(cursor - path), path, path);
+          goto error_out;
+        }
+
+        *field = current;
+        *element = (uint32_t)index;
+        return NULL;
+      }
+
+      current = cmc_field_of_node(current->_self.subnodes[index]);
+    }
+
+    if (*cursor == '\0') {
+      break;
+    }
+
+    if (*cursor != '.') {
+      err = cme_errorf(EINVAL, "Unexpected `%c` at `offset=%d` of `path=%s`",
+                       *cursor, (int)(cursor - path), path);
+      goto error_out;
+    }
+    cursor++;
+  }
+
+  *field = current;
+  *element = CMC_LOOKUP_NO_ELEMENT;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+// Same as `cmc_lookup_resolve`, element index is kept by the handle.
+static cme_error_t
+cmc_lookup_handle_resolve(const struct cmc_Config *config,
+                          struct cmc_FieldHandle *handle,
+                          struct cmc_ConfigField **field) {
+  struct cmc_ConfigField *local_field;
+  uint32_t element;
+  cme_error_t err;
+
+  if (!config || !handle || !field) {
+    err = cme_error(EINVAL, "`config`, `handle` and `field` cannot be NULL");
+    goto error_out;
+  }
+
+  // Handle filled by hand or for another config may carry any id.
+  if (config->_lookup && handle->generation == config->_generation &&
+      handle->id < config->_lookup->fields_len &&
+      config->_lookup->fields[handle->id]->_id == handle->id) {
+    *field = config->_lookup->fields[handle->id];
+    return NULL;
+  }
+
+  // Shape changed since the handle was resolved, config is not indexed or
+  //  handle is not valid for it.
+  err = cmc_lookup_resolve(config, handle->path, &local_field, &element);
+  if (err) {
+    goto error_out;
+  }
+
+  handle->element = element;
+  if (config->_lookup) {
+    handle->id = local_field->_id;
+    handle->generation = config->_generation;
+  }
+
+  *field = local_field;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
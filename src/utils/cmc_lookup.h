@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_CONFIG_CMC_LOOKUP_H
+#define C_MINILIB_CONFIG_CMC_LOOKUP_H
+
+#include <stdint.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
+
+/*
+ * Index of named fields of a config, built once after parsing. Fields are
+ * keyed by the tree node of their parent and case-folded name, so each
+ * segment of a path costs one probe. Array elements are not indexed, they
+ * are reached through the subnodes of the array. Every field, elements
+ * included, also gets a dense id, see `cmc_FieldHandle`.
+ */
+// Path resolves to a field, not to an element of a packed array.
+#define CMC_LOOKUP_NO_ELEMENT UINT32_MAX
+
+struct cmc_LookupSlot {
+  const struct cmc_TreeNode *parent;
+  struct cmc_ConfigField *field; // NULL marks an empty slot
+};
+
+struct cmc_Lookup {
+  struct cmc_LookupSlot *slots;
+  uint32_t slots_mask;
+  // All fields in depth-first order, position is the id of a field.
+  struct cmc_ConfigField **fields;
+  uint32_t fields_len;
+  // Hash of names, types and subnode counts of all fields. Configs of
+  //  equal shape give equal ids to fields of equal paths.
+  uint64_t shape;
+};
+
+/*
+ * Index `fields` of the config and all their descendants. Memory comes
+ * from `arena`, NULL arena means heap.
+ */
+cme_error_t cmc_lookup_create(struct cmc_Arena *arena,
+                              const struct cmc_TreeNode *fields,
+                              struct cmc_Lookup **lookup);
+void cmc_lookup_destroy(struct cmc_Arena *arena, struct cmc_Lookup **lookup);
+
+/*
+ * Child of `parent` called `name`, NULL if there is none. `name_hash` is
+ * `cmc_hash_str` of the name.
+ */
+struct cmc_ConfigField *cmc_lookup_find(const struct cmc_Lookup *lookup,
+                                        const struct cmc_TreeNode *parent,
+                                        const char *name,
+                                        const uint32_t name_len,
+                                        const uint64_t name_hash);
+
+#endif // C_MINILIB_CONFIG_CMC_LOOKUP_H
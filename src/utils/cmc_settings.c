@@ -12,21 +12,19 @@
 #include <unistd.h>
 
 #include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
 
-static char *safe_getcwd() {
-  char *buf = malloc(PATH_MAX);
-  if (!buf) {
-    return NULL;
-  }
+static char *safe_getcwd(struct cmc_Arena *arena) {
+  char buf[PATH_MAX];
 
-  if (!getcwd(buf, PATH_MAX)) {
-    free(buf);
+  if (!getcwd(buf, sizeof(buf))) {
     return NULL;
   }
-  return buf;
+  return cmc_strndup(arena, buf, strlen(buf));
 }
 
-cme_error_t cmc_settings_create(const uint32_t paths_length,
+cme_error_t cmc_settings_create(struct cmc_Arena *arena,
+                                const uint32_t paths_length,
                                 const char **supported_paths, const char *name,
                                 const void *log_func,
                                 struct cmc_ConfigSettings **settings) {
@@ -38,7 +36,7 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
     goto error_out;
   }
 
-  local_settings = malloc(sizeof(struct cmc_ConfigSettings));
+  local_settings = cmc_alloc(arena, sizeof(struct cmc_ConfigSettings));
   if (!local_settings) {
     err = cme_error(ENOMEM, "Unable to allocate memory for `local_settings`");
     goto error_out;
@@ -57,8 +55,9 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
        i < local_paths_length + additional_paths; i++) {
     char **local_supported_paths;
 
-    local_supported_paths = (char **)realloc(
-        (void *)local_settings->supported_paths, sizeof(char *) * (i + 1));
+    local_supported_paths = (char **)cmc_realloc(
+        arena, (void *)local_settings->supported_paths, sizeof(char *) * i,
+        sizeof(char *) * (i + 1));
     if (!local_supported_paths) {
       err = cme_error(ENOMEM,
                       "Unable to allocate memory for `local_supported_paths`");
@@ -69,14 +68,15 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
 
     // First we are injecting additional paths
     if (i == 0) {
-      local_settings->supported_paths[i] = safe_getcwd();
+      local_settings->supported_paths[i] = safe_getcwd(arena);
     } else {
       // Here starts normal processing
+      const char *path = supported_paths[i - additional_paths];
       local_settings->supported_paths[i] =
-          strdup(supported_paths[i - additional_paths]);
+          cmc_strndup(arena, path, strlen(path));
     }
 
-    if (!local_settings->supported_paths) {
+    if (!local_settings->supported_paths[i]) {
       err = cme_errorf(ENOMEM,
                        "Unable to allocate memory for "
                        "`local_settings->supported_paths[%d]`\n",
@@ -92,7 +92,7 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
     name = "config";
   }
 
-  local_settings->name = strdup(name);
+  local_settings->name = cmc_strndup(arena, name, strlen(name));
   if (!local_settings->name) {
     err = cme_error(ENOMEM, "Unable to allocate memory for "
                             "`local_settings->name`\n");
@@ -100,6 +100,15 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
   }
 
   local_settings->log_func = log_func;
+  local_settings->input_mode = cmc_InputModeEnum_READ;
+  local_settings->memory_mode = cmc_MemoryModeEnum_HEAP;
+  local_settings->value_mode = cmc_ValueModeEnum_COPY;
+  local_settings->threads = 0;
+  local_settings->static_memory = NULL;
+  local_settings->static_memory_size = 0;
+  local_settings->scratch_memory = NULL;
+  local_settings->scratch_memory_size = 0;
+  local_settings->allocator = NULL;
 
   *settings = local_settings;
 
@@ -107,29 +116,31 @@ cme_error_t cmc_settings_create(const uint32_t paths_length,
 
 error_settings_paths_iter_cleanup:
   while (local_settings->paths_length-- > 0) {
-    free(local_settings->supported_paths[local_settings->paths_length]);
+    cmc_free(arena,
+             local_settings->supported_paths[local_settings->paths_length]);
   }
 error_settings_paths_cleanup:
-  free((void *)local_settings->supported_paths);
-  free(local_settings);
+  cmc_free(arena, (void *)local_settings->supported_paths);
+  cmc_free(arena, local_settings);
 error_out:
   return cme_return(err);
 }
 
-void cmc_settings_destroy(struct cmc_ConfigSettings **settings) {
+void cmc_settings_destroy(struct cmc_Arena *arena,
+                          struct cmc_ConfigSettings **settings) {
   if (!settings || !(*settings)) {
     return;
   }
 
-  free((*settings)->name);
+  cmc_free(arena, (*settings)->name);
 
   while ((*settings)->paths_length-- > 0) {
-    free((*settings)->supported_paths[(*settings)->paths_length]);
+    cmc_free(arena, (*settings)->supported_paths[(*settings)->paths_length]);
   }
 
-  free((void *)(*settings)->supported_paths);
+  cmc_free(arena, (void *)(*settings)->supported_paths);
 
-  free(*settings);
+  cmc_free(arena, *settings);
 
   *settings = NULL;
 }
@@ -9,11 +9,14 @@
 
 #include "c_minilib_config.h"
 
-cme_error_t cmc_settings_create(const uint32_t paths_length,
+// NULL arena means the settings are allocated from the heap.
+cme_error_t cmc_settings_create(struct cmc_Arena *arena,
+                                const uint32_t paths_length,
                                 const char *supported_paths[paths_length],
                                 const char *name, const void *log_func,
                                 struct cmc_ConfigSettings **settings);
 
-void cmc_settings_destroy(struct cmc_ConfigSettings **settings);
+void cmc_settings_destroy(struct cmc_Arena *arena,
+                          struct cmc_ConfigSettings **settings);
 
 #endif // C_MINILIB_CONFIG_CMC_SETTINGS_H
@@ -10,6 +10,7 @@
 #include <c_minilib_config.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,25 +32,39 @@ static inline void cmc_join_str_stack(char *out, size_t out_len,
   }
 }
 
-static inline cme_error_t cmc_convert_str_to_int(char *str, uint32_t n,
+// Value is parsed in place, it may be arbitrarily long. Leading zeros are
+//  accepted, empty value and value which does not fit in `int` are
+//  rejected.
+static inline cme_error_t cmc_convert_str_to_int(const char *str, uint32_t n,
                                                  int *output) {
+  int64_t number = 0;
   cme_error_t err;
+
+  if (n == 0 || str[0] == 0) {
+    err = cme_error(EINVAL, "Unable to convert empty value to integer");
+    return err;
+  }
+
   for (uint32_t i = 0; i < n; i++) {
     if (str[i] == 0) {
       break;
     }
 
-    if (!isdigit(str[i])) {
-      err = cme_errorf(EINVAL, "Unable to convert to integer `str=%s`\n", str);
+    if (!isdigit((unsigned char)str[i])) {
+      err = cme_errorf(EINVAL, "Unable to convert to integer `str=%.*s`",
+                       (int)(n < 32 ? n : 32), str);
       return err;
     }
-  }
 
-  char number[n + 1];
-  memset(number, 0, n + 1);
-  strncpy(number, str, n);
+    number = number * 10 + (str[i] - '0');
+    if (number > INT_MAX) {
+      err = cme_errorf(ERANGE, "Integer out of range `str=%.*s`",
+                       (int)(n < 32 ? n : 32), str);
+      return err;
+    }
+  }
 
-  *output = atoi(number);
+  *output = (int)number;
 
   return NULL;
 }
@@ -6,11 +6,19 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "c_minilib_config.h"
 
+#include "utils/cmc_arena.h"
 #include "utils/cmc_tree.h"
 
+#define CMC_TREE_SUBNODES_MIN 4
+
+static cme_error_t cmc_tree_node_grow(struct cmc_Arena *arena,
+                                      struct cmc_TreeNode *node,
+                                      const uint32_t subnodes_len);
+
 cme_error_t cmc_tree_node_create(struct cmc_TreeNode *node) {
   cme_error_t err;
 
@@ -21,6 +29,7 @@ cme_error_t cmc_tree_node_create(struct cmc_TreeNode *node) {
 
   node->subnodes = NULL;
   node->subnodes_len = 0;
+  node->subnodes_max = 0;
 
   return NULL;
 
@@ -28,35 +37,68 @@ error_out:
   return cme_return(err);
 }
 
-void cmc_tree_node_destroy(struct cmc_TreeNode *node) {
+void cmc_tree_node_destroy(struct cmc_Arena *arena,
+                           struct cmc_TreeNode *node) {
   if (!node) {
     return;
   }
 
-  free((void *)node->subnodes);
+  cmc_free(arena, (void *)node->subnodes);
   node->subnodes = NULL;
   node->subnodes_len = 0;
+  node->subnodes_max = 0;
 };
 
-cme_error_t cmc_tree_node_add_subnode(const struct cmc_TreeNode *subnode,
-                                      struct cmc_TreeNode *node) {
+cme_error_t cmc_tree_node_reserve_subnodes(struct cmc_Arena *arena,
+                                           struct cmc_TreeNode *node,
+                                           const uint32_t subnodes_max) {
   struct cmc_TreeNode **local_subnodes;
   cme_error_t err;
 
-  if (!node || !subnode) {
-    err = cme_error(EINVAL, "`node` and `subnode` cannot be NULL");
+  if (!node) {
+    err = cme_error(EINVAL, "`node` cannot be NULL");
     goto error_out;
   }
 
-  local_subnodes = (struct cmc_TreeNode **)realloc(
-      (void *)node->subnodes,
-      (node->subnodes_len + 1) * sizeof(struct cmc_TreeNode *));
+  if (subnodes_max <= node->subnodes_max) {
+    return NULL;
+  }
+
+  local_subnodes = (struct cmc_TreeNode **)cmc_realloc(
+      arena, (void *)node->subnodes,
+      node->subnodes_max * sizeof(struct cmc_TreeNode *),
+      (size_t)subnodes_max * sizeof(struct cmc_TreeNode *));
   if (!local_subnodes) {
     err = cme_error(ENOMEM, "Unable to allocate moemory for `local_subnodes`");
     goto error_out;
   }
 
   node->subnodes = local_subnodes;
+  node->subnodes_max = subnodes_max;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmc_tree_node_add_subnode(struct cmc_Arena *arena,
+                                      const struct cmc_TreeNode *subnode,
+                                      struct cmc_TreeNode *node) {
+  cme_error_t err;
+
+  if (!node || !subnode) {
+    err = cme_error(EINVAL, "`node` and `subnode` cannot be NULL");
+    goto error_out;
+  }
+
+  if (node->subnodes_len == node->subnodes_max) {
+    err = cmc_tree_node_grow(arena, node, 1);
+    if (err) {
+      goto error_out;
+    }
+  }
+
   node->subnodes[node->subnodes_len++] = (struct cmc_TreeNode *)subnode;
 
   return NULL;
@@ -65,8 +107,38 @@ error_out:
   return cme_return(err);
 }
 
+cme_error_t cmc_tree_node_add_subnodes(struct cmc_Arena *arena,
+                                       struct cmc_TreeNode *const *subnodes,
+                                       const uint32_t subnodes_len,
+                                       struct cmc_TreeNode *node) {
+  cme_error_t err;
+
+  if (!node || (!subnodes && subnodes_len)) {
+    err = cme_error(EINVAL, "`node` and `subnodes` cannot be NULL");
+    goto error_out;
+  }
+
+  if (subnodes_len > node->subnodes_max - node->subnodes_len) {
+    err = cmc_tree_node_grow(arena, node, subnodes_len);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  // One copy, however many subnodes are added.
+  if (subnodes_len) {
+    memcpy(&node->subnodes[node->subnodes_len], subnodes,
+           subnodes_len * sizeof(struct cmc_TreeNode *));
+  }
+  node->subnodes_len += subnodes_len;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
+
 cme_error_t cmc_tree_node_pop_subnode(struct cmc_TreeNode *node) {
-  struct cmc_TreeNode **local_subnodes;
   cme_error_t err;
 
   if (!node) {
@@ -79,19 +151,70 @@ cme_error_t cmc_tree_node_pop_subnode(struct cmc_TreeNode *node) {
     goto error_out;
   }
 
-  local_subnodes = (struct cmc_TreeNode **)realloc(
-      (void *)node->subnodes,
-      (node->subnodes_len - 1) * sizeof(struct cmc_TreeNode *));
-  if (!local_subnodes) {
-    err = cme_error(ENOMEM, "Unable to allocate moemory for `local_subnodes`");
+  node->subnodes_len--;
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+};
+
+cme_error_t cmc_tree_node_resize_subnodes(struct cmc_Arena *arena,
+                                          struct cmc_TreeNode *node,
+                                          const uint32_t subnodes_len) {
+  cme_error_t err;
+
+  if (!node) {
+    err = cme_error(EINVAL, "`node` cannot be NULL");
     goto error_out;
   }
 
-  node->subnodes = local_subnodes;
-  node->subnodes_len--;
+  // Caller knows the final size, so no room is added beyond it.
+  err = cmc_tree_node_reserve_subnodes(arena, node, subnodes_len);
+  if (err) {
+    goto error_out;
+  }
+
+  // New slots are left empty, caller fills them in.
+  for (uint32_t i = node->subnodes_len; i < subnodes_len; i++) {
+    node->subnodes[i] = NULL;
+  }
+
+  node->subnodes_len = subnodes_len;
 
   return NULL;
 
 error_out:
   return cme_return(err);
-};
+}
+
+static cme_error_t cmc_tree_node_grow(struct cmc_Arena *arena,
+                                      struct cmc_TreeNode *node,
+                                      const uint32_t subnodes_len) {
+  cme_error_t err;
+
+  if (subnodes_len > UINT32_MAX - node->subnodes_len) {
+    err = cme_errorf(EFBIG, "Too many subnodes `subnodes_len=%u`",
+                     node->subnodes_len);
+    goto error_out;
+  }
+
+  // Capacity is doubled, so building N subnodes one by one copies O(N).
+  const uint32_t needed_max = node->subnodes_len + subnodes_len;
+  uint32_t subnodes_max =
+      node->subnodes_max ? node->subnodes_max : CMC_TREE_SUBNODES_MIN;
+  while (subnodes_max < needed_max) {
+    subnodes_max = subnodes_max > UINT32_MAX / 2 ? UINT32_MAX
+                                                 : subnodes_max * 2;
+  }
+
+  err = cmc_tree_node_reserve_subnodes(arena, node, subnodes_max);
+  if (err) {
+    goto error_out;
+  }
+
+  return NULL;
+
+error_out:
+  return cme_return(err);
+}
@@ -11,16 +11,38 @@
 #include <stdint.h>
 
 #include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
 #include "utils/cmc_common.h"
 
 #define cmc_container_of(ptr, type, member)                                    \
   ((type *)((char *)(ptr)-offsetof(type, member)))
 
+/*
+ * Subnode vectors are allocated from `arena`, NULL arena means heap. Node
+ * has to be used with the same arena for it's whole life.
+ */
 cme_error_t cmc_tree_node_create(struct cmc_TreeNode *node);
-void cmc_tree_node_destroy(struct cmc_TreeNode *node);
+void cmc_tree_node_destroy(struct cmc_Arena *arena, struct cmc_TreeNode *node);
 
-cme_error_t cmc_tree_node_add_subnode(const struct cmc_TreeNode *subnode,
+/*
+ * Make room for at least `subnodes_max` subnodes, so following appends do
+ * not reallocate.
+ */
+cme_error_t cmc_tree_node_reserve_subnodes(struct cmc_Arena *arena,
+                                           struct cmc_TreeNode *node,
+                                           const uint32_t subnodes_max);
+cme_error_t cmc_tree_node_add_subnode(struct cmc_Arena *arena,
+                                      const struct cmc_TreeNode *subnode,
                                       struct cmc_TreeNode *node);
+cme_error_t cmc_tree_node_add_subnodes(struct cmc_Arena *arena,
+                                       struct cmc_TreeNode *const *subnodes,
+                                       const uint32_t subnodes_len,
+                                       struct cmc_TreeNode *node);
+
+// Removal never reallocates, capacity is kept for the next appends.
 cme_error_t cmc_tree_node_pop_subnode(struct cmc_TreeNode *node);
+cme_error_t cmc_tree_node_resize_subnodes(struct cmc_Arena *arena,
+                                          struct cmc_TreeNode *node,
+                                          const uint32_t subnodes_len);
 
 #endif // C_MINILIB_CONFIG_CMC_TREE_H
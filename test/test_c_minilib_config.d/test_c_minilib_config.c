@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <unity.h>
@@ -14,6 +15,7 @@
 #include <c_minilib_error.h>
 
 #include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
 #include "utils/cmc_field.h"
 #include "utils/cmc_settings.h"
 
@@ -216,3 +218,1022 @@ void test_getters_on_unset_required_field_int(void) {
   err = cmc_field_get_int(field, &out_i);
   TEST_ASSERT_NOT_NULL(err);
 }
+
+static void create_push_config(struct cmc_ConfigField **f_name,
+                               struct cmc_ConfigField **f_arr) {
+  struct cmc_ConfigField *f_arr_element;
+
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("name", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_name, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL, false,
+                         f_arr);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_arr, config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         &f_arr_element);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(*f_arr, f_arr_element);
+  TEST_ASSERT_NULL(err);
+}
+
+void test_push_parse_in_chunks_of_any_size(void) {
+  const char *content = "# header\nNAME=first\nARR_0=\"multi\nline\"\n"
+                        "ARR_1='b'\nNAME=whatever";
+  const size_t len = strlen(content);
+
+  for (size_t chunk_len = 1; chunk_len <= len; chunk_len++) {
+    struct cmc_ConfigField *f_name, *f_arr;
+    create_push_config(&f_name, &f_arr);
+
+    err = cmc_config_parse_begin(config);
+    TEST_ASSERT_NULL(err);
+    for (size_t i = 0; i < len; i += chunk_len) {
+      const size_t n = len - i < chunk_len ? len - i : chunk_len;
+      err = cmc_config_parse_feed(content + i, n, config);
+      TEST_ASSERT_NULL(err);
+    }
+    err = cmc_config_parse_end(config);
+    TEST_ASSERT_NULL(err);
+
+    char *val_name = NULL;
+    err = cmc_field_get_str(f_name, &val_name);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING("whatever", val_name);
+
+    const char *expected[] = {"multi\nline", "b"};
+    uint32_t i = 0;
+    CMC_FOREACH_FIELD_ARRAY(element, char *, &f_arr, {
+      TEST_ASSERT_TRUE(i < 2);
+      TEST_ASSERT_EQUAL_STRING(expected[i++], element);
+    });
+    TEST_ASSERT_EQUAL_UINT32(2, i);
+
+    cmc_config_destroy(&config);
+  }
+}
+
+void test_push_parse_reports_line_of_whole_input(void) {
+  struct cmc_ConfigField *f_name, *f_arr;
+  create_push_config(&f_name, &f_arr);
+
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed("NAME=a\nARR_0=b\n", 15, config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed("ARR_1=c\nbad key=1\n", 18, config);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NOT_NULL(strstr(err->msg, "line 4, column 5"));
+
+  // Failed feed aborts parsing.
+  err = cmc_config_parse_feed("A=1\n", 4, config);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_push_parse_requires_begin(void) {
+  struct cmc_ConfigField *f_name, *f_arr;
+  create_push_config(&f_name, &f_arr);
+
+  err = cmc_config_parse_end(config);
+  TEST_ASSERT_NOT_NULL(err);
+
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EALREADY, err->code);
+  err = cmc_config_parse(config);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EALREADY, err->code);
+
+  // Push parsing goes on after the rejected one-shot parse.
+  err = cmc_config_parse_feed("NAME=a\nARR_0=b\n", 14, config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_end(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+
+  // Config destroyed in the middle of parsing releases parser state.
+}
+
+void test_configs_of_one_schema_share_names(void) {
+  const char *content = "NAME=a\nARR_0=b\nARR_1=c\n";
+  struct cmc_Config *configs[2];
+  struct cmc_ConfigField *f_name, *f_arrs[2];
+
+  for (uint32_t i = 0; i < 2; i++) {
+    create_push_config(&f_name, &f_arrs[i]);
+    err = cmc_config_parse_begin(config);
+    TEST_ASSERT_NULL(err);
+    err = cmc_config_parse_feed(content, strlen(content), config);
+    TEST_ASSERT_NULL(err);
+    err = cmc_config_parse_end(config);
+    TEST_ASSERT_NULL(err);
+
+    configs[i] = config;
+    config = NULL;
+  }
+
+  TEST_ASSERT_EQUAL_PTR(f_arrs[0]->name, f_arrs[1]->name);
+  TEST_ASSERT_EQUAL_UINT32(2, f_arrs[0]->_array_len);
+  TEST_ASSERT_EQUAL_UINT32(2, f_arrs[1]->_array_len);
+  TEST_ASSERT_EQUAL_PTR(cmc_field_of_node(f_arrs[0]->_self.subnodes[0])->name,
+                        cmc_field_of_node(f_arrs[1]->_self.subnodes[0])->name);
+
+  cmc_config_destroy(&configs[0]);
+  cmc_config_destroy(&configs[1]);
+}
+
+static void create_shared_config(struct cmc_Config **output,
+                                 struct cmc_ConfigField **f_host,
+                                 struct cmc_ConfigField **f_motd) {
+  const char *content = "HOST=dns.example.com\n"
+                        "MOTD=\"a long message\\nwith an escape\"\n";
+
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.value_mode = cmc_ValueModeEnum_SHARED},
+      output);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("host", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         f_host);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_host, *output);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("motd", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         f_motd);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_motd, *output);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_parse_begin(*output);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed(content, strlen(content), *output);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_end(*output);
+  TEST_ASSERT_NULL(err);
+}
+
+void test_shared_values_are_hash_consed_across_configs(void) {
+  struct cmc_Config *other_config;
+  struct cmc_ConfigField *f_host, *f_motd, *f_other_host, *f_other_motd;
+
+  create_shared_config(&config, &f_host, &f_motd);
+  create_shared_config(&other_config, &f_other_host, &f_other_motd);
+
+  TEST_ASSERT_EQUAL_STRING("dns.example.com", (char *)f_host->value);
+  TEST_ASSERT_EQUAL_STRING("a long message\nwith an escape",
+                           (char *)f_motd->value);
+  TEST_ASSERT_EQUAL_PTR(f_host->value, f_other_host->value);
+  TEST_ASSERT_EQUAL_PTR(f_motd->value, f_other_motd->value);
+
+  // Shared value outlives the config which parsed it first.
+  cmc_config_destroy(&config);
+  TEST_ASSERT_EQUAL_STRING("dns.example.com", (char *)f_other_host->value);
+
+  // Field leaves the store once it gets a value of it's own.
+  err = cmc_field_add_value_str(f_other_host, "localhost");
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_FALSE(f_other_host->_is_value_shared);
+
+  cmc_config_destroy(&other_config);
+}
+
+void test_shared_values_reject_arena_mode(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.value_mode = cmc_ValueModeEnum_SHARED,
+                                   .memory_mode = cmc_MemoryModeEnum_ARENA},
+      &config);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+static void create_arena_schema(struct cmc_ConfigField **f_name,
+                                struct cmc_ConfigField **f_arr) {
+  struct cmc_ConfigField *f_arr_element;
+
+  err = cmc_config_field_create("name", cmc_ConfigFieldTypeEnum_STRING,
+                                "<none>", true, config, f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_name, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                                true, config, f_arr);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_arr, config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_field_create("", cmc_ConfigFieldTypeEnum_STRING, NULL,
+                                true, config, &f_arr_element);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(*f_arr, f_arr_element);
+  TEST_ASSERT_NULL(err);
+}
+
+void test_parse_in_arena_memory_mode_and_reset(void) {
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+
+  char *paths[] = {(char *)CONFIG_DIR};
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = paths,
+          .paths_length = 1,
+          .name = "superApp",
+          .memory_mode = cmc_MemoryModeEnum_ARENA,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NOT_NULL(config->_arena);
+
+  // Reload reuses memory of the previous schema and values.
+  for (uint32_t reload = 0; reload < 3; reload++) {
+    struct cmc_ConfigField *f_name, *f_arr;
+    cmc_config_reset(config);
+    create_arena_schema(&f_name, &f_arr);
+
+    err = cmc_config_parse(config);
+    TEST_ASSERT_NULL(err);
+
+    char *val_name = NULL;
+    err = cmc_field_get_str(f_name, &val_name);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING("whatever", val_name);
+
+    const char *expected[] = {"abc", "def"};
+    uint32_t i = 0;
+    CMC_FOREACH_FIELD_ARRAY(element, char *, &f_arr, {
+      TEST_ASSERT_TRUE(i < 2);
+      TEST_ASSERT_EQUAL_STRING(expected[i++], element);
+    });
+    TEST_ASSERT_EQUAL_UINT32(2, i);
+    TEST_ASSERT_EQUAL_PTR(config->_arena, f_arr->_arena);
+  }
+
+  TEST_ASSERT_NULL(config->_arena->blocks->next);
+}
+
+void test_arena_config_rejects_heap_field(void) {
+  struct cmc_ConfigField *field;
+
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .name = "superApp",
+          .memory_mode = cmc_MemoryModeEnum_ARENA,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("name", cmc_ConfigFieldTypeEnum_STRING, NULL, true,
+                         &field);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_add_field(field, config);
+  TEST_ASSERT_NOT_NULL(err);
+
+  cmc_field_destroy(&field);
+}
+
+static const int schema_amount = 7;
+static const char schema_motd[] = "default message of the day";
+
+static const struct cmc_ConfigFieldDescriptor schema_arr_element[] = {
+    {.name = "", .type = cmc_ConfigFieldTypeEnum_STRING, .optional = true},
+};
+
+static const struct cmc_ConfigFieldDescriptor schema[] = {
+    {.name = "name", .type = cmc_ConfigFieldTypeEnum_STRING},
+    {.name = "amount",
+     .type = cmc_ConfigFieldTypeEnum_INT,
+     .default_value = &schema_amount,
+     .optional = true},
+    {.name = "motd",
+     .type = cmc_ConfigFieldTypeEnum_STRING,
+     .default_value = schema_motd,
+     .optional = true},
+    {.name = "arr",
+     .type = cmc_ConfigFieldTypeEnum_ARRAY,
+     .optional = true,
+     .children = schema_arr_element,
+     .children_len = 1},
+};
+
+void test_add_schema_borrows_names_and_defaults(void) {
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+
+  char *paths[] = {CONFIG_DIR};
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = paths, .paths_length = 1, .name = "superApp"},
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  // Reload registers the same table again, memory of the previous schema
+  //  is released by reset.
+  for (uint32_t reload = 0; reload < 2; reload++) {
+    struct cmc_ConfigField *fields = NULL;
+    cmc_config_reset(config);
+    err = cmc_config_add_schema(schema, 4, config, &fields);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_UINT32(4, config->_fields.subnodes_len);
+
+    for (uint32_t i = 0; i < 4; i++) {
+      TEST_ASSERT_EQUAL_PTR(schema[i].name, fields[i].name);
+    }
+
+    err = cmc_config_parse(config);
+    TEST_ASSERT_NULL(err);
+
+    char *value = NULL;
+    err = cmc_field_get_str(&fields[0], &value);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING("whatever", value);
+
+    int amount = -1;
+    err = cmc_field_get_int(&fields[1], &amount);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(1, amount);
+
+    err = cmc_field_get_str(&fields[2], &value);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_PTR(schema_motd, value);
+
+    const char *expected[] = {"abc", "def"};
+    struct cmc_ConfigField *f_arr = &fields[3];
+    uint32_t i = 0;
+    CMC_FOREACH_FIELD_ARRAY(element, char *, &f_arr, {
+      TEST_ASSERT_TRUE(i < 2);
+      TEST_ASSERT_EQUAL_STRING(expected[i++], element);
+    });
+    TEST_ASSERT_EQUAL_UINT32(2, i);
+  }
+}
+
+void test_add_schema_rejects_children_of_scalar(void) {
+  static const struct cmc_ConfigFieldDescriptor bad_schema[] = {
+      {.name = "name", .type = cmc_ConfigFieldTypeEnum_STRING},
+      {.name = "amount",
+       .type = cmc_ConfigFieldTypeEnum_INT,
+       .children = schema_arr_element,
+       .children_len = 1},
+  };
+
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_add_schema(bad_schema, 2, config, NULL);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(0, config->_fields.subnodes_len);
+  TEST_ASSERT_NULL(config->_schemas);
+}
+
+void test_add_schema_rejects_arrays_without_one_child(void) {
+  static const struct cmc_ConfigFieldDescriptor bad_schemas[][1] = {
+      {{.name = "arr", .type = cmc_ConfigFieldTypeEnum_ARRAY}},
+      {{.name = "arr",
+        .type = cmc_ConfigFieldTypeEnum_ARRAY,
+        .children = schema,
+        .children_len = 2}},
+  };
+
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+
+  for (uint32_t i = 0; i < 2; i++) {
+    err = cmc_config_add_schema(bad_schemas[i], 1, config, NULL);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+    TEST_ASSERT_EQUAL_UINT32(0, config->_fields.subnodes_len);
+    cme_error_destroy(err);
+    err = NULL;
+  }
+}
+
+static void *counting_malloc(size_t size, void *ctx) {
+  (*(int32_t *)ctx)++;
+  return malloc(size);
+}
+
+static void counting_free(void *ptr, void *ctx) {
+  (*(int32_t *)ctx)--;
+  free(ptr);
+}
+
+void test_allocator_receives_all_config_memory(void) {
+  int32_t live_blocks = 0;
+  struct cmc_Allocator allocator = {
+      .malloc = counting_malloc,
+      .free = counting_free,
+      .ctx = &live_blocks,
+  };
+  struct cmc_ConfigField *fields;
+
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+
+  char *paths[] = {CONFIG_DIR};
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.supported_paths = paths,
+                                   .paths_length = 1,
+                                   .name = "superApp",
+                                   .allocator = &allocator},
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_add_schema(schema, 4, config, &fields);
+  TEST_ASSERT_NULL(err);
+
+  const uint64_t schema_allocations = allocator.allocations;
+  err = cmc_config_parse(config);
+  TEST_ASSERT_NULL(err);
+
+  // Budget of a parse, index and values of a tiny file.
+  TEST_ASSERT_TRUE(allocator.allocations > schema_allocations);
+  TEST_ASSERT_TRUE(allocator.allocations - schema_allocations < 32);
+  TEST_ASSERT_TRUE(allocator.peak_bytes >= allocator.bytes);
+  TEST_ASSERT_TRUE(live_blocks > 0);
+
+  cmc_config_destroy(&config);
+  TEST_ASSERT_EQUAL_INT32(0, live_blocks);
+  TEST_ASSERT_EQUAL_UINT64(0, allocator.bytes);
+}
+
+static const struct cmc_ConfigFieldDescriptor path_pool[] = {
+    {.name = "pool", .type = cmc_ConfigFieldTypeEnum_STRING},
+};
+
+static const struct cmc_ConfigFieldDescriptor path_pools[] = {
+    {.name = "",
+     .type = cmc_ConfigFieldTypeEnum_DICT,
+     .children = path_pool,
+     .children_len = 1},
+};
+
+static const struct cmc_ConfigFieldDescriptor path_subnet[] = {
+    {.name = "id", .type = cmc_ConfigFieldTypeEnum_INT},
+    {.name = "pools",
+     .type = cmc_ConfigFieldTypeEnum_ARRAY,
+     .optional = true,
+     .children = path_pools,
+     .children_len = 1,
+     .index_by = "pool"},
+};
+
+static const struct cmc_ConfigFieldDescriptor path_subnets[] = {
+    {.name = "",
+     .type = cmc_ConfigFieldTypeEnum_DICT,
+     .children = path_subnet,
+     .children_len = 2},
+};
+
+static const struct cmc_ConfigFieldDescriptor path_dhcp4[] = {
+    {.name = "subnet4",
+     .type = cmc_ConfigFieldTypeEnum_ARRAY,
+     .children = path_subnets,
+     .children_len = 1,
+     .index_by = "id"},
+};
+
+static const struct cmc_ConfigFieldDescriptor path_schema[] = {
+    {.name = "dhcp4",
+     .type = cmc_ConfigFieldTypeEnum_DICT,
+     .children = path_dhcp4,
+     .children_len = 1},
+    {.name = "name", .type = cmc_ConfigFieldTypeEnum_STRING},
+};
+
+static const char path_content[] = "DHCP4_SUBNET4_0_ID=1\n"
+                                   "DHCP4_SUBNET4_1_ID=2\n"
+                                   "DHCP4_SUBNET4_1_POOLS_0_POOL=10.0.1.1\n"
+                                   "DHCP4_SUBNET4_1_POOLS_1_POOL=10.0.1.2\n"
+                                   "NAME=kea\n";
+
+// Reload the way an application does, schema is registered again.
+static void load_path_config(const char *content) {
+  cmc_config_reset(config);
+  err = cmc_config_add_schema(path_schema, 2, config, NULL);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed(content, strlen(content), config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_end(config);
+  TEST_ASSERT_NULL(err);
+}
+
+static void create_path_config(void) {
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+
+  load_path_config(path_content);
+}
+
+void test_get_by_path_after_parse(void) {
+  create_path_config();
+  TEST_ASSERT_NOT_NULL(config->_lookup);
+
+  int id = -1;
+  err = cmc_config_get_int(config, "dhcp4.subnet4[1].id", &id);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(2, id);
+
+  // Names are matched like keys of `.env` files, ignoring case.
+  err = cmc_config_get_int(config, "DHCP4.Subnet4[0].ID", &id);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(1, id);
+
+  char *pool = NULL;
+  err = cmc_config_get_str(config, "dhcp4.subnet4[1].pools[1].pool", &pool);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("10.0.1.2", pool);
+
+  struct cmc_ConfigField *subnet4, *element;
+  err = cmc_config_get(config, "dhcp4.subnet4", &subnet4);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_get(config, "dhcp4.subnet4[1]", &element);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(cmc_field_of_node(subnet4->_self.subnodes[1]),
+                        element);
+
+  char *name = NULL;
+  err = cmc_config_get_str(config, "name", &name);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("kea", name);
+}
+
+void test_get_by_path_rejects_bad_paths(void) {
+  struct cmc_ConfigField *field;
+  create_path_config();
+
+  // Prototype of an array without values is not its first element.
+  const char *missing[] = {"dhcp4.subnet4[2].id", "dhcp4.subnet", "names",
+                           "dhcp4.subnet4[1].pools[2]",
+                           "dhcp4.subnet4[0].pools[0]"};
+  for (uint32_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+    err = cmc_config_get(config, missing[i], &field);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+  }
+
+  const char *malformed[] = {"",
+                             "dhcp4..subnet4",
+                             "dhcp4.",
+                             "name[0]",
+                             "name.first",
+                             "dhcp4[0]",
+                             "dhcp4.subnet4[]",
+                             "dhcp4.subnet4[x]",
+                             "dhcp4.subnet4[1]x",
+                             "dhcp4.subnet4[99999999999]"};
+  for (uint32_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+    err = cmc_config_get(config, malformed[i], &field);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+  }
+
+  int value;
+  err = cmc_config_get_int(config, "name", &value);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+}
+
+void test_get_by_path_scans_until_parsed(void) {
+  struct cmc_ConfigField *field, *f_extra;
+
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_schema(path_schema, 2, config, NULL);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NULL(config->_lookup);
+
+  err = cmc_config_get(config, "dhcp4.subnet4[0].pools", &field);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("pools", field->name);
+
+  cmc_config_destroy(&config);
+  create_path_config();
+
+  // Added field is found before the next parse rebuilds the index.
+  err = cmc_field_create("extra", cmc_ConfigFieldTypeEnum_INT, NULL, true,
+                         &f_extra);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(f_extra, config);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NULL(config->_lookup);
+
+  err = cmc_config_get(config, "extra", &field);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(f_extra, field);
+}
+
+void test_handle_survives_reload_of_same_shape(void) {
+  struct cmc_FieldHandle handle;
+  struct cmc_ConfigField *field, *handle_field;
+  char *pool = NULL;
+  create_path_config();
+
+  err = cmc_config_handle_init(config, "dhcp4.subnet4[1].pools[1].pool",
+                               &handle);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(config->_generation, handle.generation);
+
+  const uint32_t id = handle.id;
+  const uint32_t generation = handle.generation;
+  for (uint32_t reload = 0; reload < 2; reload++) {
+    err = cmc_config_handle_get_str(config, &handle, &pool);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING("10.0.1.2", pool);
+
+    // Fields of the reloaded config are found by the same id.
+    err = cmc_config_get(config, "dhcp4.subnet4[1].pools[1].pool", &field);
+    TEST_ASSERT_NULL(err);
+    err = cmc_config_handle_get(config, &handle, &handle_field);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_PTR(field, handle_field);
+    TEST_ASSERT_EQUAL_UINT32(id, handle.id);
+    TEST_ASSERT_EQUAL_UINT32(generation, handle.generation);
+
+    load_path_config(path_content);
+  }
+}
+
+void test_handle_to_element_of_emptied_array(void) {
+  struct cmc_FieldHandle handle;
+  char *pool = NULL;
+  create_path_config();
+
+  load_path_config("DHCP4_SUBNET4_0_ID=1\n"
+                   "DHCP4_SUBNET4_0_POOLS_0_POOL=10.0.0.1\n"
+                   "NAME=kea\n");
+  err = cmc_config_handle_init(config, "dhcp4.subnet4[0].pools[0].pool",
+                               &handle);
+  TEST_ASSERT_NULL(err);
+
+  // Array left with its prototype only has the same subnodes.
+  load_path_config("DHCP4_SUBNET4_0_ID=1\nNAME=kea\n");
+  err = cmc_config_handle_get_str(config, &handle, &pool);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+}
+
+void test_handle_with_bad_id_resolves_by_path(void) {
+  struct cmc_FieldHandle handle;
+  int id = -1;
+  create_path_config();
+
+  err = cmc_config_handle_init(config, "dhcp4.subnet4[1].id", &handle);
+  TEST_ASSERT_NULL(err);
+
+  handle.id = UINT32_MAX;
+  err = cmc_config_handle_get_int(config, &handle, &id);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(2, id);
+  TEST_ASSERT_NOT_EQUAL(UINT32_MAX, handle.id);
+}
+
+void test_handle_resolves_again_when_shape_changes(void) {
+  struct cmc_FieldHandle handle;
+  int id = -1;
+  create_path_config();
+
+  err = cmc_config_handle_init(config, "dhcp4.subnet4[1].id", &handle);
+  TEST_ASSERT_NULL(err);
+  const struct cmc_FieldHandle old_handle = handle;
+
+  // First subnet gains pools, so fields of the second one move.
+  load_path_config("DHCP4_SUBNET4_0_ID=1\n"
+                   "DHCP4_SUBNET4_0_POOLS_0_POOL=10.0.0.1\n"
+                   "DHCP4_SUBNET4_0_POOLS_1_POOL=10.0.0.2\n"
+                   "DHCP4_SUBNET4_1_ID=3\n"
+                   "NAME=kea\n");
+  TEST_ASSERT_NOT_EQUAL(old_handle.generation, config->_generation);
+
+  err = cmc_config_handle_get_int(config, &handle, &id);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(3, id);
+  TEST_ASSERT_EQUAL_UINT32(config->_generation, handle.generation);
+  TEST_ASSERT_NOT_EQUAL(old_handle.id, handle.id);
+
+  // Without an index handle falls back to the path.
+  cmc_config_reset(config);
+  err = cmc_config_add_schema(path_schema, 2, config, NULL);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_handle_get_int(config, &handle, &id);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+
+  err = cmc_config_handle_init(config, "dhcp4.subnet", &handle);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+static void parse_push_config(const char *content) {
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed(content, strlen(content), config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_end(config);
+  TEST_ASSERT_NULL(err);
+}
+
+void test_get_element_of_parsed_scalar_array(void) {
+  struct cmc_ConfigField *f_name, *f_arr, *field;
+  struct cmc_FieldHandle handle;
+  char *value = NULL;
+  create_push_config(&f_name, &f_arr);
+  parse_push_config("NAME=a\nARR_0=b\nARR_1=c\n");
+
+  err = cmc_config_get_str(config, "arr[1]", &value);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("c", value);
+
+  err = cmc_config_handle_init(config, "arr[0]", &handle);
+  TEST_ASSERT_NULL(err);
+  for (uint32_t reload = 0; reload < 2; reload++) {
+    err = cmc_config_handle_get_str(config, &handle, &value);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(reload ? "d" : "b", value);
+    parse_push_config("NAME=a\nARR_0=d\nARR_1=e\n");
+  }
+
+  // Elements are values of the array, not fields.
+  err = cmc_config_get(config, "arr[0]", &field);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+  err = cmc_config_handle_get(config, &handle, &field);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+
+  int number;
+  err = cmc_config_get_int(config, "arr[0]", &number);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+
+  const char *malformed[] = {"arr[0].x", "arr[0][0]"};
+  for (uint32_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+    err = cmc_config_get_str(config, malformed[i], &value);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+  }
+
+  err = cmc_config_get_str(config, "arr[2]", &value);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+}
+
+void test_freeze_parsed_scalar_array(void) {
+  struct cmc_ConfigField *f_name, *f_arr;
+  struct cmc_FrozenConfig *frozen = NULL;
+  create_push_config(&f_name, &f_arr);
+  parse_push_config("NAME=a\nARR_0=b\nARR_1=\"c\\nd\"\n");
+
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+
+  uint32_t frozen_arr;
+  err = cmc_frozen_find(frozen, CMC_FROZEN_NONE, "arr", &frozen_arr);
+  TEST_ASSERT_NULL(err);
+
+  const char *expected[] = {"b", "c\nd"};
+  uint32_t i = 0;
+  CMC_FROZEN_FOREACH(element, frozen, frozen_arr) {
+    const char *value = NULL;
+    err = cmc_frozen_get_str(frozen, element, &value);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(expected[i], value);
+    i++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, i);
+
+  cmc_frozen_destroy(&frozen);
+}
+
+static const struct cmc_ConfigFieldDescriptor reload_host[] = {
+    {.name = "name", .type = cmc_ConfigFieldTypeEnum_STRING},
+    {.name = "port",
+     .type = cmc_ConfigFieldTypeEnum_INT,
+     .default_value = &(int){80},
+     .optional = true},
+};
+
+static const struct cmc_ConfigFieldDescriptor reload_hosts[] = {
+    {.name = "",
+     .type = cmc_ConfigFieldTypeEnum_DICT,
+     .children = reload_host,
+     .children_len = 2},
+};
+
+static const struct cmc_ConfigFieldDescriptor reload_schema[] = {
+    {.name = "hosts",
+     .type = cmc_ConfigFieldTypeEnum_ARRAY,
+     .children = reload_hosts,
+     .children_len = 1},
+};
+
+void test_parse_again_drops_values_of_previous_elements(void) {
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_schema(reload_schema, 1, config, NULL);
+  TEST_ASSERT_NULL(err);
+
+  parse_push_config("HOSTS_0_NAME=a\nHOSTS_0_PORT=1\n"
+                    "HOSTS_1_NAME=b\nHOSTS_1_PORT=2\n");
+
+  // Optional port is missing now, every element gets the default.
+  parse_push_config("HOSTS_0_NAME=c\nHOSTS_1_NAME=d\nHOSTS_2_NAME=e\n");
+
+  const char *names[] = {"c", "d", "e"};
+  for (uint32_t i = 0; i < 3; i++) {
+    char path[32];
+    char *name = NULL;
+    int port = -1;
+
+    snprintf(path, sizeof(path), "hosts[%u].name", i);
+    err = cmc_config_get_str(config, path, &name);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(names[i], name);
+
+    snprintf(path, sizeof(path), "hosts[%u].port", i);
+    err = cmc_config_get_int(config, path, &port);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(80, port);
+  }
+}
+
+void test_find_array_elements_by_member(void) {
+  struct cmc_ConfigField *subnet4, *pools, *element, *expected;
+  create_path_config();
+
+  err = cmc_config_get(config, "dhcp4.subnet4", &subnet4);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NOT_NULL(subnet4->_index_slots);
+
+  err = cmc_field_array_find_int(subnet4, "id", 2, &element);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_get(config, "dhcp4.subnet4[1]", &expected);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(expected, element);
+
+  // Arrays of cloned elements are indexed too.
+  err = cmc_config_get(config, "dhcp4.subnet4[1].pools", &pools);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NOT_NULL(pools->_index_slots);
+  err = cmc_field_array_find(pools, "pool", "10.0.1.2", &element);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_get(config, "dhcp4.subnet4[1].pools[1]", &expected);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(expected, element);
+
+  err = cmc_field_array_find(pools, "pool", "10.0.1.3", &element);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+  // Value of another type never matches.
+  err = cmc_field_array_find(subnet4, "id", "2", &element);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+
+  // Prototype of an array without values is not an element.
+  err = cmc_config_get(config, "dhcp4.subnet4[0].pools", &pools);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_array_find(pools, "pool", "", &element);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+}
+
+void test_find_array_element_added_after_parse(void) {
+  struct cmc_ConfigField *subnet4, *f_subnet, *f_id, *element;
+  create_path_config();
+
+  err = cmc_config_get(config, "dhcp4.subnet4", &subnet4);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_DICT, NULL, false,
+                         &f_subnet);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("id", cmc_ConfigFieldTypeEnum_INT, &(int){7}, true,
+                         &f_id);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_subnet, f_id);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(subnet4, f_subnet);
+  TEST_ASSERT_NULL(err);
+
+  // Index built by the parse does not know the new element.
+  err = cmc_field_array_find_int(subnet4, "id", 7, &element);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(f_subnet, element);
+
+  err = cmc_field_array_find_int(subnet4, "id", 2, &element);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(cmc_field_of_node(subnet4->_self.subnodes[1]),
+                        element);
+}
+
+void test_find_array_elements_without_index(void) {
+  struct cmc_ConfigField *subnet4, *element, *expected;
+  create_path_config();
+
+  err = cmc_config_get(config, "dhcp4.subnet4", &subnet4);
+  TEST_ASSERT_NULL(err);
+
+  // Index declared again is built by the next parse, until then elements
+  //  are scanned.
+  err = cmc_field_array_index(subnet4, "ID");
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_NULL(subnet4->_index_slots);
+
+  err = cmc_config_get(config, "dhcp4.subnet4[1]", &expected);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_array_find_int(subnet4, "id", 2, &element);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(expected, element);
+
+  err = cmc_field_array_index(subnet4, "pools");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+  err = cmc_field_array_index(subnet4, "missing");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+
+  struct cmc_ConfigField *f_name;
+  err = cmc_config_get(config, "name", &f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_array_index(f_name, "id");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+}
+
+void test_parse_int_of_several_megabytes(void) {
+  const char key[] = "NAME=kea\nDHCP4_SUBNET4_0_ID=";
+  const size_t digits_len = 4 * 1024 * 1024;
+  const size_t len = strlen(key) + digits_len + 2;
+  char *content = malloc(len + 1);
+  TEST_ASSERT_NOT_NULL(content);
+
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+
+  // Leading zeros do not count towards the range of `int`.
+  memcpy(content, key, strlen(key));
+  memset(content + strlen(key), '0', digits_len);
+  memcpy(content + len - 2, "7\n", 3);
+  load_path_config(content);
+
+  int id = -1;
+  err = cmc_config_get_int(config, "dhcp4.subnet4[0].id", &id);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(7, id);
+
+  memset(content + strlen(key), '9', digits_len);
+  cmc_config_reset(config);
+  err = cmc_config_add_schema(path_schema, 2, config, NULL);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed(content, len, config);
+  if (!err) {
+    err = cmc_config_parse_end(config);
+  }
+  free(content);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ERANGE, err->code);
+}
+
+// Quoted empty value is a value, unlike `KEY=` which leaves the field unset.
+void test_parse_empty_int_fails(void) {
+  const char content[] = "NAME=kea\nDHCP4_SUBNET4_0_ID=\"\"\n";
+
+  err = cmc_lib_init();
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_schema(path_schema, 2, config, NULL);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_parse_feed(content, strlen(content), config);
+  if (!err) {
+    err = cmc_config_parse_end(config);
+  }
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+}
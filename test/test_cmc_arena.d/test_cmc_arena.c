@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "utils/cmc_arena.h"
+
+static struct cmc_Arena *arena = NULL;
+static cme_error_t err = NULL;
+
+void setUp(void) {
+  cme_init();
+  err = cmc_arena_create(256, &arena);
+  TEST_ASSERT_NULL(err);
+}
+
+void tearDown(void) {
+  cmc_arena_destroy(&arena);
+  cme_destroy();
+}
+
+void test_arena_create_null_output(void) {
+  err = cmc_arena_create(0, NULL);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_arena_alloc_is_aligned(void) {
+  for (uint32_t i = 1; i < 64; i++) {
+    void *ptr = cmc_arena_alloc(arena, i);
+    TEST_ASSERT_NOT_NULL(ptr);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)ptr % _Alignof(max_align_t));
+    memset(ptr, 0xff, i);
+  }
+}
+
+void test_arena_alloc_bigger_than_block(void) {
+  char *ptr = cmc_arena_alloc(arena, 4096);
+  TEST_ASSERT_NOT_NULL(ptr);
+  memset(ptr, 1, 4096);
+
+  TEST_ASSERT_NOT_NULL(cmc_arena_alloc(arena, 16));
+}
+
+void test_arena_realloc_grows_last_in_place(void) {
+  cmc_arena_alloc(arena, 16);
+  char *ptr = cmc_arena_alloc(arena, 16);
+  strcpy(ptr, "abc");
+
+  TEST_ASSERT_EQUAL_PTR(ptr, cmc_arena_realloc(arena, ptr, 16, 64));
+
+  // Not the last allocation anymore, content is moved.
+  cmc_arena_alloc(arena, 16);
+  char *moved = cmc_arena_realloc(arena, ptr, 64, 128);
+  TEST_ASSERT_NOT_NULL(moved);
+  TEST_ASSERT_TRUE(moved != ptr);
+  TEST_ASSERT_EQUAL_STRING("abc", moved);
+}
+
+void test_arena_reset_reuses_blocks(void) {
+  void *first = cmc_arena_alloc(arena, 200);
+  cmc_arena_alloc(arena, 200);
+  struct cmc_ArenaBlock *blocks = arena->blocks;
+
+  cmc_arena_reset(arena);
+
+  TEST_ASSERT_EQUAL_PTR(first, cmc_arena_alloc(arena, 200));
+  TEST_ASSERT_EQUAL_PTR(blocks, arena->blocks);
+  TEST_ASSERT_NOT_NULL(blocks->next);
+  TEST_ASSERT_NULL(blocks->next->next);
+}
+
+void test_arena_strndup(void) {
+  char *str = cmc_strndup(arena, "hello world", 5);
+  TEST_ASSERT_EQUAL_STRING("hello", str);
+}
+
+void test_arena_static_is_bounded_by_memory(void) {
+  static char memory[1024];
+  struct cmc_Arena *static_arena = NULL;
+
+  // Misaligned start is fine, arena aligns itself.
+  err = cmc_arena_create_static(memory + 1, sizeof(memory) - 1, &static_arena);
+  TEST_ASSERT_NULL(err);
+
+  uint32_t allocations = 0;
+  char *ptr;
+  while ((ptr = cmc_arena_alloc(static_arena, 16))) {
+    TEST_ASSERT_TRUE(ptr >= memory && ptr + 16 <= memory + sizeof(memory));
+    allocations++;
+  }
+  TEST_ASSERT_TRUE(allocations > 0);
+  TEST_ASSERT_NULL(cmc_arena_alloc(static_arena, 16));
+
+  cmc_arena_reset(static_arena);
+  TEST_ASSERT_NOT_NULL(cmc_arena_alloc(static_arena, 16));
+
+  cmc_arena_destroy(&static_arena);
+  TEST_ASSERT_NULL(static_arena);
+}
+
+void test_arena_static_too_small(void) {
+  static char memory[8];
+  struct cmc_Arena *static_arena = NULL;
+
+  err = cmc_arena_create_static(memory, sizeof(memory), &static_arena);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOMEM, err->code);
+}
+
+void test_arena_keep_survives_reset(void) {
+  char *kept = cmc_arena_alloc(arena, 16);
+  strcpy(kept, "kept");
+  cmc_arena_keep(arena);
+
+  char *dropped = cmc_arena_alloc(arena, 16);
+  cmc_arena_reset(arena);
+
+  TEST_ASSERT_EQUAL_PTR(dropped, cmc_arena_alloc(arena, 16));
+  TEST_ASSERT_EQUAL_STRING("kept", kept);
+}
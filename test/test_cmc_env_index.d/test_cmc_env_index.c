@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "cmc_parse_interface/cmc_env_parser/cmc_env_index.h"
+#include "utils/cmc_hash.h"
+
+static struct cmc_EnvIndex env_index;
+static cme_error_t err = NULL;
+
+static void create_index(const char *content) {
+  err = cmc_env_index_create(NULL, content, strlen(content), 0, &env_index);
+  TEST_ASSERT_NULL(err);
+}
+
+static const char *get_value(const char *name, uint32_t *value_len) {
+  return cmc_env_index_get(&env_index, name, strlen(name),
+                           cmc_hash_str(name, strlen(name)).hash, value_len);
+}
+
+static void assert_value(const char *expected, const char *name) {
+  uint32_t value_len = 0;
+  const char *value = get_value(name, &value_len);
+  TEST_ASSERT_NOT_NULL(value);
+  TEST_ASSERT_EQUAL_UINT32(strlen(expected), value_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, value, value_len);
+}
+
+void setUp(void) {
+  cme_init();
+  memset(&env_index, 0, sizeof(env_index));
+  err = NULL;
+}
+
+void tearDown(void) {
+  cmc_env_index_destroy(&env_index);
+  cme_destroy();
+}
+
+void test_index_create_null_args(void) {
+  err = cmc_env_index_create(NULL, NULL, 0, 0, &env_index);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_index_get_key_value(void) {
+  uint32_t value_len;
+  create_index("NAME=john\nAGE=99\n");
+
+  TEST_ASSERT_EQUAL_UINT32(2, env_index.entries_len);
+  assert_value("john", "name");
+  assert_value("99", "age");
+  TEST_ASSERT_NULL(get_value("missing", &value_len));
+}
+
+void test_index_get_is_case_insensitive(void) {
+  create_index("Mixed_Case=value");
+
+  assert_value("value", "mixed_case");
+  assert_value("value", "MIXED_CASE");
+}
+
+void test_index_does_not_modify_buffer(void) {
+  const char content[] = "KEY=value\nOTHER=x";
+  char buffer[sizeof(content)];
+  memcpy(buffer, content, sizeof(content));
+
+  create_index(buffer);
+
+  TEST_ASSERT_EQUAL_STRING(content, buffer);
+  assert_value("x", "other");
+}
+
+void test_index_skips_empty_lines_and_values(void) {
+  uint32_t value_len;
+  create_index("\nEMPTY=\n  \nKEY=v\n");
+
+  TEST_ASSERT_EQUAL_UINT32(1, env_index.entries_len);
+  TEST_ASSERT_NULL(get_value("empty", &value_len));
+  assert_value("v", "key");
+}
+
+void test_index_last_definition_wins(void) {
+  create_index("KEY=first\nKEY=second\n");
+
+  TEST_ASSERT_EQUAL_UINT32(1, env_index.entries_len);
+  assert_value("second", "key");
+}
+
+void test_index_quoted_values(void) {
+  create_index("SINGLE='a b'\nDOUBLE=\"c=d\"\nEMPTY=\"\"\n");
+
+  assert_value("a b", "single");
+  assert_value("c=d", "double");
+  assert_value("", "empty");
+}
+
+void test_index_create_fails_on_syntax_error(void) {
+  const char *content = "KEY=v\nno delimeter\n";
+  err = cmc_env_index_create(NULL, content, strlen(content), 0, &env_index);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NULL(env_index.entries);
+}
+
+void test_index_multi_line_value(void) {
+  create_index("CERT=\"-----BEGIN-----\nabc\n-----END-----\"\nNEXT=1\n");
+
+  TEST_ASSERT_EQUAL_UINT32(2, env_index.entries_len);
+  assert_value("-----BEGIN-----\nabc\n-----END-----", "cert");
+  assert_value("1", "next");
+}
+
+void test_index_skips_comment_lines(void) {
+  uint32_t value_len;
+  create_index("# NAME=commented\nNAME=john\n#AGE=99\n");
+
+  TEST_ASSERT_EQUAL_UINT32(1, env_index.entries_len);
+  assert_value("john", "name");
+  TEST_ASSERT_NULL(get_value("#age", &value_len));
+}
+
+void test_index_get_by_composed_hash(void) {
+  uint32_t value_len;
+  create_index("ARR_0_NAME=john\n");
+
+  // Hash of flattened name composed from it's segments has to match hash
+  //  computed by tokenizer over the whole key.
+  struct cmc_Hash hash = cmc_hash_str("ARR", 3);
+  hash = cmc_hash_concat(hash, cmc_hash_str("_0", 2));
+  hash = cmc_hash_concat(hash, cmc_hash_str("_", 1));
+  hash = cmc_hash_concat(hash, cmc_hash_str("name", 4));
+
+  const char *value =
+      cmc_env_index_get(&env_index, "arr_0_name", 10, hash.hash, &value_len);
+  TEST_ASSERT_NOT_NULL(value);
+  TEST_ASSERT_EQUAL_STRING_LEN("john", value, value_len);
+}
+
+static const struct cmc_EnvIndexEntry *find_node(const char *name) {
+  return cmc_env_index_find(&env_index, name, strlen(name),
+                            cmc_hash_str(name, strlen(name)).hash);
+}
+
+void test_index_builds_prefix_trie(void) {
+  uint32_t value_len;
+  create_index("ARR_0_NAME=john\nARR_1_NAME=bob\nARR_1_AGE=7\n");
+
+  const struct cmc_EnvIndexEntry *node = find_node("arr");
+  TEST_ASSERT_NOT_NULL(node);
+  TEST_ASSERT_FALSE(node->has_value);
+  TEST_ASSERT_EQUAL_UINT32(2, node->children_len);
+  TEST_ASSERT_NULL(get_value("arr", &value_len));
+
+  TEST_ASSERT_EQUAL_UINT32(1, find_node("arr_0")->children_len);
+  TEST_ASSERT_EQUAL_UINT32(2, find_node("arr_1")->children_len);
+  TEST_ASSERT_NULL(find_node("arr_2"));
+  TEST_ASSERT_NULL(find_node("ar"));
+  assert_value("bob", "arr_1_name");
+}
+
+void test_index_grows_with_nested_keys(void) {
+  // A single line produces a node for every segment, table has to grow
+  //  past the size picked from the number of lines.
+  create_index("A_B_C_D_E_F_G_H_I_J_K_L_M_N_O_P_Q_R_S_T_U_V_W_X_Y_Z=deep");
+
+  TEST_ASSERT_EQUAL_UINT32(26, env_index.entries_len);
+  TEST_ASSERT_EQUAL_UINT32(1, find_node("a_b_c")->children_len);
+  assert_value("deep", "a_b_c_d_e_f_g_h_i_j_k_l_m_n_o_p_q_r_s_t_u_v_w_x_y_z");
+}
+
+// Generates content big enough to be split between threads, every key is
+//  defined twice so the later definition has to win across chunks.
+static char *generate_content(const char *middle, size_t *content_len) {
+  const uint32_t lines_len = 20000;
+  const size_t middle_len = strlen(middle);
+  const size_t max = lines_len * 32 + middle_len;
+  char *content = malloc(max);
+  TEST_ASSERT_NOT_NULL(content);
+
+  size_t len = 0;
+  for (uint32_t i = 0; i < lines_len; i++) {
+    if (i == lines_len / 2) {
+      memcpy(content + len, middle, middle_len);
+      len += middle_len;
+    }
+    len += sprintf(content + len, "ARR_%u_KEY=v%u\n", i % (lines_len / 2), i);
+  }
+
+  *content_len = len;
+  return content;
+}
+
+static void assert_threads_match(const char *content, const size_t len) {
+  struct cmc_EnvIndex threaded_index;
+
+  err = cmc_env_index_create(NULL, content, len, 0, &env_index);
+  TEST_ASSERT_NULL(err);
+  err = cmc_env_index_create(NULL, content, len, 4, &threaded_index);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(env_index.entries_len, threaded_index.entries_len);
+  TEST_ASSERT_EQUAL_UINT32(env_index.entries_max, threaded_index.entries_max);
+  TEST_ASSERT_EQUAL_MEMORY(env_index.entries, threaded_index.entries,
+                           env_index.entries_max *
+                               sizeof(struct cmc_EnvIndexEntry));
+
+  cmc_env_index_destroy(&threaded_index);
+}
+
+void test_index_threads_match_single_thread(void) {
+  size_t len;
+  char *content = generate_content("", &len);
+
+  assert_threads_match(content, len);
+  assert_value("v19999", "arr_9999_key");
+  TEST_ASSERT_EQUAL_UINT32(10000, find_node("arr")->children_len);
+
+  free(content);
+}
+
+void test_index_threads_hash_prefixes_like_single_thread(void) {
+  // Leading and doubled separators do not end a prefix of their own.
+  size_t len;
+  char *content = generate_content("_ARR__0_KEY_=x\n", &len);
+
+  assert_threads_match(content, len);
+  assert_value("x", "_arr__0_key_");
+  TEST_ASSERT_NOT_NULL(find_node("_arr_"));
+
+  free(content);
+}
+
+void test_index_threads_quote_spans_chunks(void) {
+  // Quoted value over most of the buffer, workers lex chunks inside it as
+  //  if they were regular lines.
+  const size_t middle_len = 400000;
+  char *middle = malloc(middle_len + 1);
+  TEST_ASSERT_NOT_NULL(middle);
+  memcpy(middle, "QUOTE=\"\n", 8);
+  for (size_t i = 8; i < middle_len; i += 4) {
+    memcpy(middle + i, "A=1\n", 4);
+  }
+  memcpy(middle + middle_len - 12, "\"\nX=1\nY=\"2\"\n", 12);
+  middle[middle_len] = 0;
+
+  size_t len;
+  char *content = generate_content(middle, &len);
+
+  assert_threads_match(content, len);
+  TEST_ASSERT_NOT_NULL(find_node("quote"));
+  TEST_ASSERT_NULL(find_node("a"));
+  assert_value("1", "x");
+  assert_value("2", "y");
+
+  free(content);
+  free(middle);
+}
+
+void test_index_threads_report_same_syntax_error(void) {
+  size_t len;
+  char *content = generate_content("no delimeter\n", &len);
+  struct cmc_EnvIndex threaded_index;
+
+  err = cmc_env_index_create(NULL, content, len, 0, &env_index);
+  TEST_ASSERT_NOT_NULL(err);
+  cme_error_t threaded_err =
+      cmc_env_index_create(NULL, content, len, 4, &threaded_index);
+  TEST_ASSERT_NOT_NULL(threaded_err);
+  TEST_ASSERT_EQUAL_STRING(err->msg, threaded_err->msg);
+  TEST_ASSERT_NOT_NULL(strstr(err->msg, "line 10001, column 4"));
+
+  free(content);
+}
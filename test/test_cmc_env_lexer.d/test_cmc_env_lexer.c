@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "cmc_parse_interface/cmc_env_parser/cmc_env_lexer.h"
+#include "cmc_parse_interface/cmc_env_parser/cmc_env_scan.h"
+
+#define TOKENS_MAX 16
+
+static const char *content;
+static struct cmc_EnvToken tokens[TOKENS_MAX];
+static uint32_t tokens_len;
+static struct cmc_EnvScanTable table;
+static cme_error_t err = NULL;
+
+static bool collect_token(const struct cmc_EnvToken *token, void *data) {
+  TEST_ASSERT_TRUE(tokens_len < TOKENS_MAX);
+  tokens[tokens_len++] = *token;
+  return true;
+}
+
+static cme_error_t lex(const char *local_content) {
+  struct cmc_EnvLexer lexer;
+  const uint32_t len = strlen(local_content);
+
+  content = local_content;
+  cmc_env_scan_destroy(&table);
+  err = cmc_env_scan_create(NULL, content, len, &table);
+  TEST_ASSERT_NULL(err);
+
+  cmc_env_lexer_init(&lexer);
+  if (!cmc_env_lexer_feed(&lexer, content, 0, len, &table, collect_token,
+                          NULL) ||
+      !cmc_env_lexer_end(&lexer, content, len, collect_token, NULL)) {
+    return cmc_env_lexer_error(&lexer, content);
+  }
+
+  return NULL;
+}
+
+static void assert_token(const uint32_t i, const char *name,
+                         const char *value) {
+  TEST_ASSERT_TRUE(i < tokens_len);
+  TEST_ASSERT_EQUAL_UINT32(strlen(name), tokens[i].name_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(name, content + tokens[i].name_offset,
+                               tokens[i].name_len);
+  TEST_ASSERT_EQUAL_UINT32(strlen(value), tokens[i].value_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(value, content + tokens[i].value_offset,
+                               tokens[i].value_len);
+}
+
+static void assert_syntax_error(const char *local_content,
+                                const char *position) {
+  err = lex(local_content);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NOT_NULL(strstr(err->msg, position));
+}
+
+void setUp(void) {
+  cme_init();
+  memset(&table, 0, sizeof(table));
+  tokens_len = 0;
+  err = NULL;
+}
+
+void tearDown(void) {
+  cmc_env_scan_destroy(&table);
+  cme_destroy();
+}
+
+void test_lex_key_value_pairs(void) {
+  err = lex("A=1\nB=two words\nC=x=y");
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(3, tokens_len);
+  assert_token(0, "A", "1");
+  assert_token(1, "B", "two words");
+  assert_token(2, "C", "x=y");
+}
+
+void test_lex_comments_and_whitespace(void) {
+  err = lex("# comment = \"'\n  A = 1   # trailing\r\nB=#not comment\n"
+            "C= # empty\n\tD=d\n");
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(3, tokens_len);
+  assert_token(0, "A", "1");
+  assert_token(1, "B", "#not comment");
+  assert_token(2, "D", "d");
+}
+
+void test_lex_export_prefix(void) {
+  err = lex("export A=1\nexport  B = 2\n");
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(2, tokens_len);
+  assert_token(0, "A", "1");
+  assert_token(1, "B", "2");
+}
+
+void test_lex_quoted_values(void) {
+  err = lex("A='# \"raw\\n\"'\nB=\"a\\\"b\" # c\nC=\"multi\nline\"\nD=''");
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(4, tokens_len);
+  assert_token(0, "A", "# \"raw\\n\"");
+  TEST_ASSERT_FALSE(tokens[0].is_escaped);
+  assert_token(1, "B", "a\\\"b");
+  TEST_ASSERT_TRUE(tokens[1].is_escaped);
+  assert_token(2, "C", "multi\nline");
+  assert_token(3, "D", "");
+}
+
+void test_lex_unescape(void) {
+  char value[] = "a\\tb\\\"c\\\\d\\ne\\x";
+  uint32_t value_len = cmc_env_lexer_unescape(value, strlen(value));
+
+  TEST_ASSERT_EQUAL_STRING_LEN("a\tb\"c\\d\ne\\x", value, value_len);
+  TEST_ASSERT_EQUAL_UINT32(strlen("a\tb\"c\\d\ne\\x"), value_len);
+}
+
+void test_lex_reports_syntax_errors(void) {
+  assert_syntax_error("A=1\nno delimeter\n", "line 2, column 4");
+  assert_syntax_error("A=1\n=value\n", "line 2, column 1");
+  assert_syntax_error("A B=1\n", "line 1, column 3");
+  assert_syntax_error("A=1\nB=\"open\nC=3\n", "line 2, column 3");
+  assert_syntax_error("A='x' y\n", "line 1, column 7");
+  assert_syntax_error("A$=1\n", "line 1, column 2");
+}
+
+void test_lex_resumes_between_ranges(void) {
+  struct cmc_EnvLexer lexer;
+  content = "A=1\nB=\"x\ny\"\nC=3";
+  const uint32_t len = strlen(content);
+
+  err = cmc_env_scan_create(NULL, content, len, &table);
+  TEST_ASSERT_NULL(err);
+
+  // Every split point has to give the same tokens as a single range.
+  for (uint32_t split = 0; split <= len; split++) {
+    tokens_len = 0;
+    cmc_env_lexer_init(&lexer);
+    TEST_ASSERT_TRUE(cmc_env_lexer_feed(&lexer, content, 0, split, &table,
+                                        collect_token, NULL));
+    if (split == 4) {
+      TEST_ASSERT_TRUE(cmc_env_lexer_is_line_start(&lexer));
+    }
+    if (split == 9) {
+      TEST_ASSERT_FALSE(cmc_env_lexer_is_line_start(&lexer));
+    }
+    TEST_ASSERT_TRUE(cmc_env_lexer_feed(&lexer, content, split, len, &table,
+                                        collect_token, NULL));
+    TEST_ASSERT_TRUE(cmc_env_lexer_end(&lexer, content, len, collect_token,
+                                       NULL));
+
+    TEST_ASSERT_EQUAL_UINT32(3, tokens_len);
+    assert_token(0, "A", "1");
+    assert_token(1, "B", "x\ny");
+    assert_token(2, "C", "3");
+  }
+}
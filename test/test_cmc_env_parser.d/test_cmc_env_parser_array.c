@@ -63,17 +63,24 @@ void test_flat_array_parsing(void) {
   TEST_ASSERT_NULL(err);
 
   const char *expected[] = {"a", "b", "c", "d"};
-  // there should be 4 elements in the subnodes array
-  TEST_ASSERT_EQUAL_UINT32(4, f_array->_self.subnodes_len);
+  // there should be 4 elements, stored without element fields
+  uint32_t len = 0;
+  err = cmc_field_array_len(f_array, &len);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(4, len);
+  TEST_ASSERT_EQUAL_UINT32(1, f_array->_self.subnodes_len);
 
-  for (uint32_t i = 0; i < f_array->_self.subnodes_len; ++i) {
-    struct cmc_TreeNode *node = f_array->_self.subnodes[i];
-    struct cmc_ConfigField *elem = cmc_field_of_node(node);
+  for (uint32_t i = 0; i < len; ++i) {
     char *out = NULL;
-    err = cmc_field_get_str(elem, &out);
+    err = cmc_field_array_get_str(f_array, i, &out);
     TEST_ASSERT_NULL(err);
     TEST_ASSERT_EQUAL_STRING(expected[i], out);
   }
+
+  int val;
+  err = cmc_field_array_get_int(f_array, 0, &val);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
 }
 
 void test_required_array_without_default_should_fail_always(void) {
@@ -168,6 +175,12 @@ void test_optional_array_parsing(void) {
 
   /* and it has no further children */
   TEST_ASSERT_EQUAL_UINT32(0, elem->_self.subnodes_len);
+
+  /* which is why it is not counted as an element */
+  uint32_t len = 1;
+  err = cmc_field_array_len(f_array, &len);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(0, len);
 }
 
 void test_nested_array_parsing(void) {
@@ -220,12 +233,10 @@ void test_nested_array_parsing(void) {
     struct cmc_TreeNode *row_node = f_outer->_self.subnodes[i];
     struct cmc_ConfigField *row = cmc_field_of_node(row_node);
     /* each row has 2 cells */
-    TEST_ASSERT_EQUAL_UINT32(2, row->_self.subnodes_len);
-    for (uint32_t j = 0; j < row->_self.subnodes_len; ++j) {
-      struct cmc_TreeNode *cell_node = row->_self.subnodes[j];
-      struct cmc_ConfigField *cell = cmc_field_of_node(cell_node);
+    TEST_ASSERT_EQUAL_UINT32(2, row->_array_len);
+    for (uint32_t j = 0; j < row->_array_len; ++j) {
       int val = -1;
-      err = cmc_field_get_int(cell, &val);
+      err = cmc_field_array_get_int(row, j, &val);
       TEST_ASSERT_NULL(err);
       TEST_ASSERT_EQUAL_INT(expected[i][j], val);
     }
@@ -277,11 +288,9 @@ void test_double_nested_array_parsing(void) {
     struct cmc_ConfigField *lvl1 = cmc_field_of_node(outer->_self.subnodes[i]);
     for (uint32_t j = 0; j < lvl1->_self.subnodes_len; ++j) {
       struct cmc_ConfigField *lvl2 = cmc_field_of_node(lvl1->_self.subnodes[j]);
-      for (uint32_t k = 0; k < lvl2->_self.subnodes_len; ++k) {
-        struct cmc_ConfigField *lvl3 =
-            cmc_field_of_node(lvl2->_self.subnodes[k]);
+      for (uint32_t k = 0; k < lvl2->_array_len; ++k) {
         int val = -1;
-        err = cmc_field_get_int(lvl3, &val);
+        err = cmc_field_array_get_int(lvl2, k, &val);
         TEST_ASSERT_NULL(err);
 
         if (i == 0) {
@@ -299,3 +308,243 @@ void test_double_nested_array_parsing(void) {
     }
   }
 }
+
+void test_array_ends_on_element_without_known_keys(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = (char *[]){(char *)ARRAY_CONFIG_PATH},
+          .paths_length = 1,
+          .name = "array",
+          .log_func = NULL,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  struct cmc_ConfigField *f_array, *f_dict, *f_name;
+  err = cmc_field_create("dict_array", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                         true, &f_array);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_DICT, NULL, true, &f_dict);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_array, f_dict);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("name", cmc_ConfigFieldTypeEnum_STRING, NULL, true,
+                         &f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_dict, f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(f_array, config);
+  TEST_ASSERT_NULL(err);
+
+  err =
+      parser.parse(strlen(ARRAY_CONFIG_PATH), ARRAY_CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  // `DICT_ARRAY_2` has no `NAME`, so `DICT_ARRAY_3` is never reached.
+  const char *expected[] = {"a", "b"};
+  TEST_ASSERT_EQUAL_UINT32(2, f_array->_self.subnodes_len);
+
+  for (uint32_t i = 0; i < f_array->_self.subnodes_len; ++i) {
+    struct cmc_ConfigField *elem =
+        cmc_field_of_node(f_array->_self.subnodes[i]);
+    struct cmc_ConfigField *name = cmc_field_of_node(elem->_self.subnodes[0]);
+    char *out = NULL;
+    err = cmc_field_get_str(name, &out);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(expected[i], out);
+  }
+}
+
+void test_int_arrays_are_contiguous(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = (char *[]){(char *)ARRAY_CONFIG_PATH},
+          .paths_length = 1,
+          .name = "array",
+          .log_func = NULL,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  struct cmc_ConfigField *f_outer = NULL, *f_inner = NULL, *f_int = NULL;
+  err = cmc_field_create("nested_array", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                         true, &f_outer);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(f_outer, config);
+  TEST_ASSERT_NULL(err);
+  err =
+      cmc_field_create("", cmc_ConfigFieldTypeEnum_ARRAY, NULL, true, &f_inner);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_outer, f_inner);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_INT, NULL, true, &f_int);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_inner, f_int);
+  TEST_ASSERT_NULL(err);
+
+  /* arrays built by hand have no buffer */
+  const int32_t *ints = NULL;
+  uint32_t len = 0;
+  err = cmc_field_array_ints(f_inner, &ints, &len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENODATA, err->code);
+
+  const int32_t expected[2][2] = {{0, 1}, {10, 11}};
+  /* second parse packs elements again */
+  for (uint32_t parse = 0; parse < 2; parse++) {
+    err = parser.parse(strlen(ARRAY_CONFIG_PATH), ARRAY_CONFIG_PATH, NULL,
+                       config);
+    TEST_ASSERT_NULL(err);
+
+    err = cmc_field_array_len(f_outer, &len);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_UINT32(2, len);
+
+    /* outer array holds arrays, not integers */
+    err = cmc_field_array_ints(f_outer, &ints, &len);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+
+    for (uint32_t i = 0; i < 2; i++) {
+      struct cmc_ConfigField *row =
+          cmc_field_of_node(f_outer->_self.subnodes[i]);
+      err = cmc_field_array_ints(row, &ints, &len);
+      TEST_ASSERT_NULL(err);
+      TEST_ASSERT_EQUAL_UINT32(2, len);
+
+      /* elements have no fields, only the prototype is kept */
+      TEST_ASSERT_EQUAL_UINT32(1, row->_self.subnodes_len);
+
+      for (uint32_t j = 0; j < len; j++) {
+        TEST_ASSERT_EQUAL_INT32(expected[i][j], ints[j]);
+
+        int val = -1;
+        err = cmc_field_array_get_int(row, j, &val);
+        TEST_ASSERT_NULL(err);
+        TEST_ASSERT_EQUAL_INT(expected[i][j], val);
+      }
+
+      int val;
+      err = cmc_field_array_get_int(row, len, &val);
+      TEST_ASSERT_NOT_NULL(err);
+      TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+    }
+  }
+}
+
+void test_add_subfield_to_parsed_array(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = (char *[]){(char *)ARRAY_CONFIG_PATH},
+          .paths_length = 1,
+          .name = "array",
+          .log_func = NULL,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  struct cmc_ConfigField *f_array, *f_elem, *f_new;
+  err = cmc_field_create("flat_array", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                         true, &f_array);
+  TEST_ASSERT_NULL(err);
+  err =
+      cmc_field_create("", cmc_ConfigFieldTypeEnum_STRING, NULL, true, &f_elem);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_array, f_elem);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(f_array, config);
+  TEST_ASSERT_NULL(err);
+
+  err =
+      parser.parse(strlen(ARRAY_CONFIG_PATH), ARRAY_CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  /* elements get their fields back, new one is appended after them */
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_STRING, "e", true,
+                         &f_new);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_array, f_new);
+  TEST_ASSERT_NULL(err);
+
+  const char *expected[] = {"a", "b", "c", "d", "e"};
+  uint32_t len = 0;
+  err = cmc_field_array_len(f_array, &len);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(5, len);
+  TEST_ASSERT_EQUAL_UINT32(5, f_array->_self.subnodes_len);
+
+  uint32_t i = 0;
+  CMC_FOREACH_FIELD_ARRAY(value, char *, &f_array, {
+    char *out = NULL;
+    err = cmc_field_array_get_str(f_array, i, &out);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(expected[i], out);
+    TEST_ASSERT_EQUAL_STRING(expected[i], value);
+    i++;
+  });
+  TEST_ASSERT_EQUAL_UINT32(5, i);
+
+  /* next parse packs the array again */
+  err =
+      parser.parse(strlen(ARRAY_CONFIG_PATH), ARRAY_CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_array_len(f_array, &len);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(4, len);
+  TEST_ASSERT_EQUAL_UINT32(1, f_array->_self.subnodes_len);
+}
+
+void test_add_subfield_to_parsed_int_array(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = (char *[]){(char *)ARRAY_CONFIG_PATH},
+          .paths_length = 1,
+          .name = "array",
+          .log_func = NULL,
+      },
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  struct cmc_ConfigField *f_outer, *f_inner, *f_int, *f_new;
+  err = cmc_field_create("nested_array", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                         true, &f_outer);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(f_outer, config);
+  TEST_ASSERT_NULL(err);
+  err =
+      cmc_field_create("", cmc_ConfigFieldTypeEnum_ARRAY, NULL, true, &f_inner);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_outer, f_inner);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_INT, NULL, true, &f_int);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(f_inner, f_int);
+  TEST_ASSERT_NULL(err);
+
+  err =
+      parser.parse(strlen(ARRAY_CONFIG_PATH), ARRAY_CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  struct cmc_ConfigField *row = cmc_field_of_node(f_outer->_self.subnodes[1]);
+  err = cmc_field_create("", cmc_ConfigFieldTypeEnum_INT, &(int){12}, true,
+                         &f_new);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(row, f_new);
+  TEST_ASSERT_NULL(err);
+
+  const int32_t expected[] = {10, 11, 12};
+  for (uint32_t i = 0; i < 3; i++) {
+    int val = -1;
+    err = cmc_field_array_get_int(row, i, &val);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_INT(expected[i], val);
+  }
+
+  /* values live in element fields again */
+  const int32_t *ints = NULL;
+  uint32_t len = 0;
+  err = cmc_field_array_ints(row, &ints, &len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENODATA, err->code);
+}
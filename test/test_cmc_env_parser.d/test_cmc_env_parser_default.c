@@ -106,3 +106,126 @@ void test_parse_valid_env_file(void) {
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_EQUAL_STRING("default_value", out_empty);
 }
+
+void test_parse_valid_env_file_mmap(void) {
+  struct cmc_ConfigField *field_str = NULL;
+  struct cmc_ConfigField *field_int = NULL;
+
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.supported_paths =
+                                       (char *[]){(char *)CONFIG_PATH},
+                                   .paths_length = 1,
+                                   .name = "config",
+                                   .log_func = NULL,
+                                   .input_mode = cmc_InputModeEnum_MMAP},
+      &config);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(cmc_InputModeEnum_MMAP, config->settings->input_mode);
+
+  err = cmc_field_create("cmc_str_config", cmc_ConfigFieldTypeEnum_STRING,
+                         "default_value", true, &field_str);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_str, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("cmc_int_config", cmc_ConfigFieldTypeEnum_INT, NULL,
+                         false, &field_int);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_int, config);
+  TEST_ASSERT_NULL(err);
+
+  err = parser.parse(strlen(CONFIG_PATH), CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  char *out_str = NULL;
+  err = cmc_field_get_str(field_str, &out_str);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("whatever", out_str);
+
+  int out_int = -1;
+  err = cmc_field_get_int(field_int, &out_int);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(1, out_int);
+}
+
+void test_parse_long_name_and_multi_line_value(void) {
+  struct cmc_ConfigField *field_long = NULL;
+  struct cmc_ConfigField *field_multiline = NULL;
+  char long_name[512] = "cmc_";
+
+  for (int i = 0; i < 60; i++) {
+    strcat(long_name, "long_");
+  }
+  strcat(long_name, "config");
+
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.supported_paths =
+                                       (char *[]){(char *)CONFIG_PATH},
+                                   .paths_length = 1,
+                                   .name = "config",
+                                   .log_func = NULL},
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create(long_name, cmc_ConfigFieldTypeEnum_STRING, NULL,
+                         false, &field_long);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_long, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("cmc_multiline_config", cmc_ConfigFieldTypeEnum_STRING,
+                         NULL, false, &field_multiline);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_multiline, config);
+  TEST_ASSERT_NULL(err);
+
+  err = parser.parse(strlen(CONFIG_PATH), CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  char *out_str = NULL;
+  err = cmc_field_get_str(field_long, &out_str);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("long", out_str);
+
+  err = cmc_field_get_str(field_multiline, &out_str);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("first\nsecond", out_str);
+}
+
+void test_parse_dotenv_grammar(void) {
+  struct cmc_ConfigField *field_exported = NULL;
+  struct cmc_ConfigField *field_escaped = NULL;
+
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.supported_paths =
+                                       (char *[]){(char *)CONFIG_PATH},
+                                   .paths_length = 1,
+                                   .name = "config",
+                                   .log_func = NULL},
+      &config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("cmc_exported_config", cmc_ConfigFieldTypeEnum_STRING,
+                         NULL, false, &field_exported);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_exported, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_create("cmc_escaped_config", cmc_ConfigFieldTypeEnum_STRING,
+                         NULL, false, &field_escaped);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(field_escaped, config);
+  TEST_ASSERT_NULL(err);
+
+  err = parser.parse(strlen(CONFIG_PATH), CONFIG_PATH, NULL, config);
+  TEST_ASSERT_NULL(err);
+
+  char *out_str = NULL;
+  err = cmc_field_get_str(field_exported, &out_str);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("exported value", out_str);
+
+  err = cmc_field_get_str(field_escaped, &out_str);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("tab\there \"quoted\"", out_str);
+}
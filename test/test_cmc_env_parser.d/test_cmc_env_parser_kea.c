@@ -74,10 +74,9 @@ void test_kea_interfaces_config_parsing(void) {
   err = parser.parse(strlen(KEA_CONFIG_PATH), KEA_CONFIG_PATH, NULL, config);
   TEST_ASSERT_NULL(err);
 
-  TEST_ASSERT_EQUAL_UINT32(1, arr->_self.subnodes_len);
-  struct cmc_ConfigField *iface = cmc_field_of_node(arr->_self.subnodes[0]);
+  TEST_ASSERT_EQUAL_UINT32(1, arr->_array_len);
   char *out = NULL;
-  err = cmc_field_get_str(iface, &out);
+  err = cmc_field_array_get_str(arr, 0, &out);
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_EQUAL_STRING("eth0", out);
 }
@@ -452,7 +451,7 @@ void test_parse_full_kea_env_file(void) {
   char *s = NULL;
   int v = -1;
 
-  err = cmc_field_get_str(iface0, &s);
+  err = cmc_field_array_get_str(ifaces, 0, &s);
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_EQUAL_STRING("eth0", s);
 
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "cmc_parse_interface/cmc_env_parser/cmc_env_scan.h"
+
+static struct cmc_EnvScanTable table;
+static struct cmc_EnvScanTable scalar_table;
+static enum cmc_EnvScanImplEnum default_impl;
+static cme_error_t err = NULL;
+
+// Scans content with every supported implementation and compares the
+//  result with the scalar one.
+static void assert_all_impls_match(const char *content, const size_t len) {
+  TEST_ASSERT_NULL(cmc_env_scan_set_impl(cmc_EnvScanImplEnum_SCALAR));
+  err = cmc_env_scan_create(NULL, content, len, &scalar_table);
+  TEST_ASSERT_NULL(err);
+
+  for (int32_t i = 0; i < cmc_EnvScanImplEnum_MAX; i++) {
+    if (!cmc_env_scan_is_supported(i)) {
+      continue;
+    }
+
+    TEST_ASSERT_NULL(cmc_env_scan_set_impl(i));
+    err = cmc_env_scan_create(NULL, content, len, &table);
+    TEST_ASSERT_NULL(err);
+
+    TEST_ASSERT_EQUAL_UINT32(scalar_table.offsets_len, table.offsets_len);
+    for (uint32_t j = 0; j < table.offsets_len; j++) {
+      TEST_ASSERT_EQUAL_UINT32(scalar_table.offsets[j], table.offsets[j]);
+    }
+
+    cmc_env_scan_destroy(&table);
+  }
+
+  cmc_env_scan_destroy(&scalar_table);
+}
+
+void setUp(void) {
+  cme_init();
+  memset(&table, 0, sizeof(table));
+  memset(&scalar_table, 0, sizeof(scalar_table));
+  default_impl = cmc_env_scan_get_impl();
+  err = NULL;
+}
+
+void tearDown(void) {
+  cmc_env_scan_destroy(&table);
+  cmc_env_scan_destroy(&scalar_table);
+  cmc_env_scan_set_impl(default_impl);
+  cme_destroy();
+}
+
+void test_scan_create_null_args(void) {
+  err = cmc_env_scan_create(NULL, NULL, 0, &table);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_scan_scalar_is_always_supported(void) {
+  TEST_ASSERT_TRUE(cmc_env_scan_is_supported(cmc_EnvScanImplEnum_SCALAR));
+  TEST_ASSERT_NOT_NULL(cmc_env_scan_set_impl(cmc_EnvScanImplEnum_MAX));
+}
+
+void test_scan_finds_structural_bytes(void) {
+  const char *content = "A=1\n#B='x\"\n";
+
+  TEST_ASSERT_NULL(cmc_env_scan_set_impl(cmc_EnvScanImplEnum_SCALAR));
+  err = cmc_env_scan_create(NULL, content, strlen(content), &table);
+  TEST_ASSERT_NULL(err);
+
+  const uint32_t expected[] = {1, 3, 4, 6, 7, 9, 10};
+  TEST_ASSERT_EQUAL_UINT32(7, table.offsets_len);
+  TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, table.offsets, 7);
+}
+
+void test_scan_empty_buffer(void) {
+  err = cmc_env_scan_create(NULL, "", 0, &table);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(0, table.offsets_len);
+}
+
+void test_scan_range_rejects_table_overflow(void) {
+  const char *content = "A=1\nB=2\n";
+
+  // Table this full is never allocated, growing it has to fail first.
+  table.offsets_len = UINT32_MAX - 4;
+  table.offsets_max = UINT32_MAX - 4;
+  TEST_ASSERT_FALSE(cmc_env_scan_range(content, 0, strlen(content), &table));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX - 4, table.offsets_len);
+  table.offsets_len = 0;
+  table.offsets_max = 0;
+}
+
+void test_scan_impls_match_on_short_buffer(void) {
+  const char *content = "NAME=john\n";
+  assert_all_impls_match(content, strlen(content));
+}
+
+void test_scan_impls_match_on_generated_buffer(void) {
+  // Over several scan steps and not a multiple of any block size, so
+  //  both block loops and scalar tails are exercised.
+  const size_t len = 3 * 4096 + 77;
+  const char alphabet[] = "ab_=\n#\"'\\1 ";
+  char *content = malloc(len);
+  TEST_ASSERT_NOT_NULL(content);
+
+  srand(1);
+  for (size_t i = 0; i < len; i++) {
+    content[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+  }
+
+  assert_all_impls_match(content, len);
+
+  free(content);
+}
@@ -4,6 +4,8 @@
  * See LICENSE file in the project root for full license information.
  */
 
+#include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unity.h>
@@ -11,6 +13,7 @@
 #include "c_minilib_config.h"
 #include "c_minilib_error.h"
 #include "utils/cmc_field.h"
+#include "utils/cmc_heap.h"
 
 // Global parent fields only
 static struct cmc_ConfigField *field = NULL;
@@ -72,6 +75,15 @@ void test_field_add_string_value(void) {
   TEST_ASSERT_EQUAL_STRING("value", (char *)field->value);
 }
 
+void test_field_add_string_value_with_length(void) {
+  err = cmc_field_create("my_field", cmc_ConfigFieldTypeEnum_STRING, NULL, true,
+                         &field);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_value_strn(field, "value\nNEXT=other", 5);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("value", (char *)field->value);
+}
+
 void test_field_add_value_null(void) {
   err = cmc_field_add_value_str(NULL, NULL);
   TEST_ASSERT_NOT_NULL(err);
@@ -104,6 +116,46 @@ void test_field_add_int_value_optional(void) {
   TEST_ASSERT_EQUAL_INT(333, *(int32_t *)field->value);
 }
 
+void test_field_short_values_are_inline(void) {
+  err = cmc_field_create("port", cmc_ConfigFieldTypeEnum_INT, NULL, false,
+                         &field);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_value_int(field, 8080);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(&field->_value, field->value);
+
+  err = cmc_field_create("host", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         &parent);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_value_str(parent, "localhost");
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(&parent->_value, parent->value);
+  TEST_ASSERT_EQUAL_STRING("localhost", (char *)parent->value);
+}
+
+void test_field_string_switches_between_inline_and_heap(void) {
+  const char *long_value = "a value longer than the inline buffer";
+
+  err = cmc_field_create("host", cmc_ConfigFieldTypeEnum_STRING, NULL, false,
+                         &field);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_field_add_value_str(field, long_value);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_TRUE(field->value != (void *)&field->_value);
+  TEST_ASSERT_EQUAL_STRING(long_value, (char *)field->value);
+
+  // Value taken from the current one, so both overlap.
+  err = cmc_field_add_value_strn(field, (char *)field->value + 2, 5);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(&field->_value, field->value);
+  TEST_ASSERT_EQUAL_STRING("value", (char *)field->value);
+
+  err = cmc_field_add_value_str(field, long_value);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING(long_value, (char *)field->value);
+}
+
 void test_field_add_valid_subfield(void) {
   struct cmc_ConfigField *child = NULL;
   err = cmc_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL, true,
@@ -253,3 +305,95 @@ void test_iter_array_macro_should_visit_all_nested_elements(void) {
 
   TEST_ASSERT_EQUAL_INT(3, count); // 2 flat + 1 nested
 }
+
+static void fill_dict(const uint32_t keys_len) {
+  err =
+      cmc_field_create("dict", cmc_ConfigFieldTypeEnum_DICT, NULL, true, &dict);
+  TEST_ASSERT_NULL(err);
+
+  for (uint32_t i = 0; i < keys_len; i++) {
+    struct cmc_ConfigField *subfield;
+    char key[16];
+    snprintf(key, sizeof(key), "key%u", i);
+    err = cmc_field_create(key, cmc_ConfigFieldTypeEnum_INT, NULL, true,
+                           &subfield);
+    TEST_ASSERT_NULL(err);
+    cmc_field_add_value_int(subfield, (int32_t)i);
+    err = cmc_field_add_subfield(dict, subfield);
+    TEST_ASSERT_NULL(err);
+  }
+}
+
+void test_dict_get_finds_every_key(void) {
+  const uint32_t sizes[] = {3, 9, 300};
+
+  for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    fill_dict(sizes[s]);
+    // Small dicts are scanned, big ones keep a table.
+    TEST_ASSERT_EQUAL(sizes[s] > 8, dict->_dict_slots != NULL);
+
+    for (uint32_t i = 0; i < sizes[s]; i++) {
+      struct cmc_ConfigField *child = NULL;
+      char key[16];
+      snprintf(key, sizeof(key), "KEY%u", i);
+      err = cmc_field_dict_get(dict, key, &child);
+      TEST_ASSERT_NULL(err);
+      TEST_ASSERT_EQUAL_INT(i, *(int32_t *)child->value);
+    }
+
+    cmc_field_destroy(&dict);
+  }
+}
+
+void test_dict_get_reports_missing_key(void) {
+  struct cmc_ConfigField *child = NULL;
+
+  fill_dict(100);
+  err = cmc_field_dict_get(dict, "key100", &child);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+  err = cmc_field_dict_get(dict, "key", &child);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(ENOENT, err->code);
+
+  err = cmc_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL, true,
+                         &arr);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_dict_get(arr, "key1", &child);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL_INT(EINVAL, err->code);
+}
+
+void test_array_add_elements_appends_block_in_order(void) {
+  // More elements than one bulk append takes.
+  const uint32_t elements_len = 130;
+  const size_t elements_size = elements_len * sizeof(struct cmc_ConfigField);
+  struct cmc_ConfigField *elements = cmc_heap_alloc(elements_size);
+  TEST_ASSERT_NOT_NULL(elements);
+  memset(elements, 0, elements_size);
+
+  err = cmc_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL, true,
+                         &arr);
+  TEST_ASSERT_NULL(err);
+  arr->_elements = elements;
+  err = cmc_field_create("x", cmc_ConfigFieldTypeEnum_INT, NULL, true, &field);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(arr, field);
+  TEST_ASSERT_NULL(err);
+  field = NULL;
+
+  for (uint32_t i = 0; i < elements_len; i++) {
+    err = cmc_field_init("x", cmc_ConfigFieldTypeEnum_INT, NULL, true, NULL,
+                         &elements[i]);
+    TEST_ASSERT_NULL(err);
+    elements[i]._is_borrowed = true;
+  }
+
+  err = cmc_field_array_add_elements(arr, elements, elements_len);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(elements_len + 1, arr->_self.subnodes_len);
+  for (uint32_t i = 0; i < elements_len; i++) {
+    TEST_ASSERT_EQUAL_PTR(&elements[i]._self, arr->_self.subnodes[i + 1]);
+  }
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+
+static struct cmc_Config *config = NULL;
+static struct cmc_FrozenConfig *frozen = NULL;
+static struct cmc_FrozenConfig *compact_frozen = NULL;
+static cme_error_t err = NULL;
+
+static void add_field(const char *name, enum cmc_ConfigFieldTypeEnum type,
+                      const void *value, bool optional,
+                      struct cmc_ConfigField *parent,
+                      struct cmc_ConfigField **output) {
+  struct cmc_ConfigField *field = NULL;
+  err = cmc_field_create(name, type, value, optional, &field);
+  TEST_ASSERT_NULL(err);
+
+  if (parent) {
+    err = cmc_field_add_subfield(parent, field);
+  } else {
+    err = cmc_config_add_field(field, config);
+  }
+  TEST_ASSERT_NULL(err);
+
+  if (output) {
+    *output = field;
+  }
+}
+
+void setUp(void) {
+  cme_init();
+  err = cmc_config_create(NULL, &config);
+  TEST_ASSERT_NULL(err);
+}
+
+void tearDown(void) {
+  cmc_frozen_destroy(&frozen);
+  cmc_frozen_destroy(&compact_frozen);
+  cmc_config_destroy(&config);
+  cme_destroy();
+}
+
+void test_freeze_null_args(void) {
+  err = cmc_config_freeze(NULL, &frozen);
+  TEST_ASSERT_NOT_NULL(err);
+  err = cmc_config_freeze(config, NULL);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_freeze_empty_config(void) {
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(1, frozen->fields_len);
+
+  uint32_t count = 0;
+  CMC_FROZEN_FOREACH(field, frozen, CMC_FROZEN_NONE) { count++; }
+  TEST_ASSERT_EQUAL_UINT32(0, count);
+}
+
+void test_freeze_scalars(void) {
+  const int amount = -7;
+  add_field("NAME", cmc_ConfigFieldTypeEnum_STRING, "john", true, NULL,
+            NULL);
+  add_field("AMOUNT", cmc_ConfigFieldTypeEnum_INT, &amount, true, NULL,
+            NULL);
+  add_field("EXTRA", cmc_ConfigFieldTypeEnum_STRING, NULL, true, NULL, NULL);
+  add_field("MISSING", cmc_ConfigFieldTypeEnum_INT, NULL, false, NULL, NULL);
+
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+  // Snapshot does not depend on the config.
+  cmc_config_destroy(&config);
+
+  uint32_t field;
+  const char *str;
+  int value;
+
+  TEST_ASSERT_NULL(cmc_frozen_find(frozen, CMC_FROZEN_NONE, "NAME", &field));
+  TEST_ASSERT_EQUAL(cmc_ConfigFieldTypeEnum_STRING,
+                    cmc_frozen_get_type(frozen, field));
+  TEST_ASSERT_EQUAL_STRING("NAME", cmc_frozen_get_name(frozen, field));
+  TEST_ASSERT_NULL(cmc_frozen_get_str(frozen, field, &str));
+  TEST_ASSERT_EQUAL_STRING("john", str);
+
+  TEST_ASSERT_NULL(
+      cmc_frozen_find(frozen, CMC_FROZEN_NONE, "AMOUNT", &field));
+  TEST_ASSERT_NULL(cmc_frozen_get_int(frozen, field, &value));
+  TEST_ASSERT_EQUAL_INT(-7, value);
+
+  TEST_ASSERT_NULL(cmc_frozen_find(frozen, CMC_FROZEN_NONE, "EXTRA", &field));
+  TEST_ASSERT_NULL(cmc_frozen_get_str(frozen, field, &str));
+  TEST_ASSERT_NULL(str);
+
+  TEST_ASSERT_NULL(
+      cmc_frozen_find(frozen, CMC_FROZEN_NONE, "MISSING", &field));
+  err = cmc_frozen_get_int(frozen, field, &value);
+  TEST_ASSERT_NOT_NULL(err);
+
+  err = cmc_frozen_find(frozen, CMC_FROZEN_NONE, "OTHER", &field);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_freeze_nested_fields_keep_order(void) {
+  struct cmc_ConfigField *dict;
+  struct cmc_ConfigField *array;
+  add_field("DB", cmc_ConfigFieldTypeEnum_DICT, NULL, false, NULL, &dict);
+  add_field("HOST", cmc_ConfigFieldTypeEnum_STRING, "localhost", true, dict,
+            NULL);
+  add_field("HOSTS", cmc_ConfigFieldTypeEnum_ARRAY, NULL, false, dict,
+            &array);
+  add_field("", cmc_ConfigFieldTypeEnum_STRING, "a", true, array, NULL);
+  add_field("", cmc_ConfigFieldTypeEnum_STRING, "b", true, array, NULL);
+  add_field("", cmc_ConfigFieldTypeEnum_STRING, "c", true, array, NULL);
+  add_field("PORT", cmc_ConfigFieldTypeEnum_STRING, "5432", true, dict,
+            NULL);
+  add_field("NAME", cmc_ConfigFieldTypeEnum_STRING, "app", true, NULL,
+            NULL);
+
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(9, frozen->fields_len);
+
+  uint32_t db;
+  TEST_ASSERT_NULL(cmc_frozen_find(frozen, CMC_FROZEN_NONE, "DB", &db));
+  TEST_ASSERT_EQUAL(cmc_ConfigFieldTypeEnum_DICT,
+                    cmc_frozen_get_type(frozen, db));
+
+  const char *names[] = {"HOST", "HOSTS", "PORT"};
+  uint32_t i = 0;
+  CMC_FROZEN_FOREACH(field, frozen, db) {
+    TEST_ASSERT_TRUE(i < 3);
+    TEST_ASSERT_EQUAL_STRING(names[i++], cmc_frozen_get_name(frozen, field));
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, i);
+
+  uint32_t hosts;
+  TEST_ASSERT_NULL(cmc_frozen_find(frozen, db, "HOSTS", &hosts));
+
+  // Siblings are adjacent, so elements can also be walked by index.
+  const char *values[] = {"a", "b", "c"};
+  i = 0;
+  CMC_FROZEN_FOREACH(element, frozen, hosts) {
+    const char *str;
+    TEST_ASSERT_EQUAL_UINT32(frozen->fields[hosts].first_child + i, element);
+    TEST_ASSERT_NULL(cmc_frozen_get_str(frozen, element, &str));
+    TEST_ASSERT_EQUAL_STRING(values[i++], str);
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, i);
+}
+
+#define ELEMENTS_LEN 40
+
+void test_freeze_compact_front_codes_names(void) {
+  struct cmc_ConfigField *array;
+  char name[64];
+  add_field("OPTION_DATA", cmc_ConfigFieldTypeEnum_ARRAY, NULL, false, NULL,
+            &array);
+  for (uint32_t i = 0; i < ELEMENTS_LEN; i++) {
+    snprintf(name, sizeof(name), "DHCP4_SUBNET4_123_OPTION_DATA_%u", i);
+    add_field(name, cmc_ConfigFieldTypeEnum_STRING, "on", true, array, NULL);
+  }
+
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_freeze_compact(config, &compact_frozen);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_TRUE(compact_frozen->is_compact);
+  TEST_ASSERT_TRUE(compact_frozen->strings_len * 2 < frozen->strings_len);
+
+  uint32_t compact_array;
+  TEST_ASSERT_NULL(cmc_frozen_find(compact_frozen, CMC_FROZEN_NONE,
+                                   "OPTION_DATA", &compact_array));
+
+  for (uint32_t i = 0; i < ELEMENTS_LEN; i++) {
+    uint32_t field;
+    char read_name[64];
+    const char *value;
+
+    snprintf(name, sizeof(name), "DHCP4_SUBNET4_123_OPTION_DATA_%u", i);
+    err = cmc_frozen_find(compact_frozen, compact_array, name, &field);
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_NULL(cmc_frozen_get_name(compact_frozen, field));
+    err = cmc_frozen_read_name(compact_frozen, field, read_name,
+                               sizeof(read_name));
+    TEST_ASSERT_NULL(err);
+    TEST_ASSERT_EQUAL_STRING(name, read_name);
+    TEST_ASSERT_NULL(cmc_frozen_get_str(compact_frozen, field, &value));
+    TEST_ASSERT_EQUAL_STRING("on", value);
+  }
+
+  uint32_t field;
+  const char *missing[] = {"DHCP4_SUBNET4_123_OPTION_DATA_",
+                           "DHCP4_SUBNET4_123_OPTION_DATA_400",
+                           "DHCP4_SUBNET4_124_OPTION_DATA_1", ""};
+  for (uint32_t i = 0; i < 4; i++) {
+    err = cmc_frozen_find(compact_frozen, compact_array, missing[i], &field);
+    TEST_ASSERT_NOT_NULL(err);
+    cme_error_destroy(err);
+  }
+
+  err = cmc_frozen_read_name(compact_frozen, compact_array + 1, name, 8);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_freeze_finds_names_ignoring_case(void) {
+  struct cmc_ConfigField *array;
+  char name[64];
+  add_field("OPTION_DATA", cmc_ConfigFieldTypeEnum_ARRAY, NULL, false, NULL,
+            &array);
+  for (uint32_t i = 0; i < ELEMENTS_LEN; i++) {
+    snprintf(name, sizeof(name), "DHCP4_SUBNET4_123_OPTION_DATA_%u", i);
+    add_field(name, cmc_ConfigFieldTypeEnum_STRING, "on", true, array, NULL);
+  }
+
+  err = cmc_config_freeze(config, &frozen);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_freeze_compact(config, &compact_frozen);
+  TEST_ASSERT_NULL(err);
+
+  // Case differs both in the prefix shared with the head and the suffix.
+  const struct cmc_FrozenConfig *snapshots[] = {frozen, compact_frozen};
+  for (uint32_t i = 0; i < 2; i++) {
+    uint32_t snapshot_array, field, expected;
+    TEST_ASSERT_NULL(cmc_frozen_find(snapshots[i], CMC_FROZEN_NONE,
+                                     "Option_Data", &snapshot_array));
+    TEST_ASSERT_NULL(cmc_frozen_find(snapshots[i], snapshot_array,
+                                     "DHCP4_SUBNET4_123_OPTION_DATA_17",
+                                     &expected));
+    TEST_ASSERT_NULL(cmc_frozen_find(snapshots[i], snapshot_array,
+                                     "dhcp4_Subnet4_123_option_DATA_17",
+                                     &field));
+    TEST_ASSERT_EQUAL_UINT32(expected, field);
+
+    err = cmc_frozen_find(snapshots[i], snapshot_array,
+                          "dhcp4_subnet4_123_option_data_17_", &field);
+    TEST_ASSERT_NOT_NULL(err);
+    cme_error_destroy(err);
+    err = NULL;
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "utils/cmc_heap.h"
+
+// Hooks count live blocks in their context.
+static void *test_malloc(size_t size, void *ctx) {
+  (*(int32_t *)ctx)++;
+  return malloc(size);
+}
+
+static void *test_realloc(void *ptr, size_t size, void *ctx) {
+  (void)ctx;
+  return realloc(ptr, size);
+}
+
+static void test_free(void *ptr, void *ctx) {
+  (*(int32_t *)ctx)--;
+  free(ptr);
+}
+
+static int32_t live_blocks = 0;
+static struct cmc_Allocator allocator;
+
+void setUp(void) {
+  cme_init();
+  live_blocks = 0;
+  memset(&allocator, 0, sizeof(allocator));
+  allocator.malloc = test_malloc;
+  allocator.realloc = test_realloc;
+  allocator.free = test_free;
+  allocator.ctx = &live_blocks;
+}
+
+void tearDown(void) {
+  cmc_heap_use(NULL);
+  cme_destroy();
+}
+
+void test_heap_counts_allocations(void) {
+  TEST_ASSERT_NULL(cmc_heap_use(&allocator));
+
+  char *ptr = cmc_heap_alloc(100);
+  TEST_ASSERT_NOT_NULL(ptr);
+  memset(ptr, 1, 100);
+  TEST_ASSERT_EQUAL_INT32(1, live_blocks);
+  TEST_ASSERT_EQUAL_UINT64(100, allocator.bytes);
+
+  ptr = cmc_heap_realloc(ptr, 300);
+  TEST_ASSERT_NOT_NULL(ptr);
+  TEST_ASSERT_EQUAL_INT8(1, ptr[99]);
+  ptr = cmc_heap_realloc(ptr, 200);
+  TEST_ASSERT_NOT_NULL(ptr);
+
+  TEST_ASSERT_EQUAL_UINT64(3, allocator.allocations);
+  TEST_ASSERT_EQUAL_UINT64(200, allocator.bytes);
+  TEST_ASSERT_EQUAL_UINT64(300, allocator.peak_bytes);
+
+  cmc_heap_free(ptr);
+  TEST_ASSERT_EQUAL_INT32(0, live_blocks);
+  TEST_ASSERT_EQUAL_UINT64(0, allocator.bytes);
+}
+
+void test_heap_frees_through_owning_allocator(void) {
+  cmc_heap_use(&allocator);
+  void *ptr = cmc_heap_alloc(16);
+  TEST_ASSERT_EQUAL_PTR(&allocator, cmc_heap_use(NULL));
+
+  // Memory from libc is not counted, memory of the allocator returns to
+  //  it even if other allocator is current.
+  void *libc_ptr = cmc_heap_alloc(16);
+  TEST_ASSERT_NOT_NULL(libc_ptr);
+  TEST_ASSERT_EQUAL_INT32(1, live_blocks);
+
+  cmc_heap_free(ptr);
+  cmc_heap_free(libc_ptr);
+  TEST_ASSERT_EQUAL_INT32(0, live_blocks);
+  TEST_ASSERT_EQUAL_UINT64(1, allocator.allocations);
+  TEST_ASSERT_EQUAL_UINT64(0, allocator.bytes);
+}
+
+void test_heap_allocator_without_hooks_only_counts(void) {
+  struct cmc_Allocator counting = {0};
+  cmc_heap_use(&counting);
+
+  void *ptr = cmc_heap_alloc(64);
+  TEST_ASSERT_NOT_NULL(ptr);
+  TEST_ASSERT_EQUAL_UINT64(64, counting.bytes);
+
+  cmc_heap_free(ptr);
+  TEST_ASSERT_EQUAL_UINT64(0, counting.bytes);
+  TEST_ASSERT_EQUAL_UINT64(64, counting.peak_bytes);
+}
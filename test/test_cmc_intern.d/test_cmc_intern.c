@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "c_minilib_config.h"
+#include "c_minilib_error.h"
+#include "utils/cmc_field.h"
+#include "utils/cmc_hash.h"
+#include "utils/cmc_heap.h"
+#include "utils/cmc_intern.h"
+
+#define NAMES_MAX 1000
+
+static struct cmc_ConfigField *field = NULL;
+static struct cmc_ConfigField *other_field = NULL;
+static cme_error_t err = NULL;
+
+static char *intern(const char *str) {
+  return cmc_intern(str, strlen(str), cmc_hash_str(str, strlen(str)).hash);
+}
+
+void setUp(void) {
+  cme_init();
+  field = other_field = NULL;
+  err = NULL;
+}
+
+void tearDown(void) {
+  cmc_field_destroy(&field);
+  cmc_field_destroy(&other_field);
+  cme_destroy();
+}
+
+void test_intern_equal_names_share_memory(void) {
+  char *name = intern("database_host");
+  char *same_name = intern("database_host");
+  char *other_name = intern("database_port");
+
+  TEST_ASSERT_NOT_NULL(name);
+  TEST_ASSERT_EQUAL_PTR(name, same_name);
+  TEST_ASSERT_TRUE(name != other_name);
+  TEST_ASSERT_EQUAL_STRING("database_host", name);
+
+  cmc_intern_release(name);
+  cmc_intern_release(same_name);
+  cmc_intern_release(other_name);
+}
+
+void test_intern_compares_bytes_not_hashes(void) {
+  // Hash is case-folded, so these two collide.
+  char *name = intern("NAME");
+  char *lower_name = intern("name");
+
+  TEST_ASSERT_TRUE(name != lower_name);
+  TEST_ASSERT_EQUAL_STRING("NAME", name);
+  TEST_ASSERT_EQUAL_STRING("name", lower_name);
+
+  cmc_intern_release(name);
+  cmc_intern_release(lower_name);
+}
+
+void test_intern_survives_growth(void) {
+  char *names[NAMES_MAX];
+  char buffer[32];
+
+  for (uint32_t i = 0; i < NAMES_MAX; i++) {
+    snprintf(buffer, sizeof(buffer), "ARR_%u", i);
+    names[i] = intern(buffer);
+    TEST_ASSERT_NOT_NULL(names[i]);
+  }
+
+  for (uint32_t i = 0; i < NAMES_MAX; i++) {
+    snprintf(buffer, sizeof(buffer), "ARR_%u", i);
+    char *name = intern(buffer);
+    TEST_ASSERT_EQUAL_PTR(names[i], name);
+    cmc_intern_release(name);
+  }
+
+  for (uint32_t i = 0; i < NAMES_MAX; i++) {
+    cmc_intern_release(names[i]);
+  }
+}
+
+void test_heap_fields_share_names(void) {
+  err = cmc_field_create("HOST", cmc_ConfigFieldTypeEnum_STRING, NULL, true,
+                         &field);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_create("HOST", cmc_ConfigFieldTypeEnum_STRING, NULL, true,
+                         &other_field);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_PTR(field->name, other_field->name);
+
+  err = cmc_field_set_name(other_field, "PORT", 4, cmc_hash_str("PORT", 4));
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("PORT", other_field->name);
+  TEST_ASSERT_EQUAL_STRING("HOST", field->name);
+  TEST_ASSERT_TRUE(field->_name_hash != other_field->_name_hash);
+}
+
+void test_intern_keeps_strings_of_allocator_apart(void) {
+  struct cmc_Allocator allocator = {0};
+
+  char *name = intern("database_host");
+  cmc_heap_use(&allocator);
+  char *allocator_name = intern("database_host");
+  char *same_allocator_name = intern("database_host");
+  cmc_heap_use(NULL);
+
+  TEST_ASSERT_NOT_NULL(allocator_name);
+  TEST_ASSERT_TRUE(name != allocator_name);
+  TEST_ASSERT_EQUAL_PTR(allocator_name, same_allocator_name);
+  TEST_ASSERT_EQUAL_STRING("database_host", allocator_name);
+  TEST_ASSERT_TRUE(allocator.bytes > 0);
+
+  cmc_intern_release(allocator_name);
+  cmc_intern_release(same_allocator_name);
+  // Pool of the allocator is gone with it's last string.
+  TEST_ASSERT_EQUAL_UINT64(0, allocator.bytes);
+  TEST_ASSERT_EQUAL_STRING("database_host", name);
+
+  cmc_intern_release(name);
+}
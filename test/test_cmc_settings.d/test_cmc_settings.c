@@ -24,7 +24,7 @@ void setUp(void) {
 }
 
 void tearDown(void) {
-  cmc_settings_destroy(&settings);
+  cmc_settings_destroy(NULL, &settings);
   cme_destroy();
 }
 
@@ -33,7 +33,7 @@ void test_cmc_settings_create_basic(void) {
   const uint32_t paths_len = sizeof(paths) / sizeof(char *);
   const char *name = "app_config";
 
-  err = cmc_settings_create(paths_len, paths, name, NULL, &settings);
+  err = cmc_settings_create(NULL, paths_len, paths, name, NULL, &settings);
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_NOT_NULL(settings);
   TEST_ASSERT_EQUAL_UINT32(paths_len + 1, settings->paths_length);
@@ -46,7 +46,7 @@ void test_cmc_settings_create_basic(void) {
 }
 
 void test_cmc_settings_create_null_paths(void) {
-  err = cmc_settings_create(0, NULL, NULL, NULL, &settings);
+  err = cmc_settings_create(NULL, 0, NULL, NULL, NULL, &settings);
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_NOT_NULL(settings);
   // Default search path is current working dir
@@ -62,6 +62,6 @@ void test_cmc_settings_create_null_paths(void) {
 }
 
 void test_cmc_settings_create_invalid_output(void) {
-  err = cmc_settings_create(0, NULL, NULL, NULL, NULL);
+  err = cmc_settings_create(NULL, 0, NULL, NULL, NULL, NULL);
   TEST_ASSERT_NOT_NULL(err);
 }
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+
+#include <c_minilib_error.h>
+
+#include "c_minilib_config.h"
+#include "utils/cmc_arena.h"
+
+#ifndef CONFIG_DIR
+#error                                                                         \
+    "CONFIG_DIR must be defined to point at the base directory for superApp.env"
+#endif
+
+// Allocator of the process is replaced, so every heap allocation made by
+//  the library while `is_counting` is set is seen by the test.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static bool is_counting = false;
+static uint32_t allocations = 0;
+
+void *malloc(size_t size) {
+  allocations += is_counting;
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+  allocations += is_counting;
+  return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  allocations += is_counting;
+  return __libc_realloc(ptr, size);
+}
+
+static _Alignas(max_align_t) char static_memory[32 * 1024];
+static _Alignas(max_align_t) char scratch_memory[16 * 1024];
+static struct cmc_Config *config = NULL;
+static cme_error_t err = NULL;
+
+void setUp(void) {
+  cme_init();
+  TEST_ASSERT_NULL(cmc_lib_init());
+  config = NULL;
+  err = NULL;
+  is_counting = false;
+  allocations = 0;
+}
+
+void tearDown(void) {
+  is_counting = false;
+  cmc_config_destroy(&config);
+  cme_destroy();
+}
+
+static void create_static_config(const size_t static_memory_size,
+                                 const bool has_scratch) {
+  char *paths[] = {CONFIG_DIR};
+
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){
+          .supported_paths = paths,
+          .paths_length = 1,
+          .name = "superApp",
+          .memory_mode = cmc_MemoryModeEnum_STATIC,
+          .static_memory = static_memory,
+          .static_memory_size = static_memory_size,
+          .scratch_memory = has_scratch ? scratch_memory : NULL,
+          .scratch_memory_size = has_scratch ? sizeof(scratch_memory) : 0,
+      },
+      &config);
+}
+
+static void create_static_schema(struct cmc_ConfigField **f_name,
+                                 struct cmc_ConfigField **f_arr) {
+  struct cmc_ConfigField *f_arr_element;
+
+  err = cmc_config_field_create("name", cmc_ConfigFieldTypeEnum_STRING,
+                                "<none>", true, config, f_name);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_name, config);
+  TEST_ASSERT_NULL(err);
+
+  err = cmc_config_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY, NULL,
+                                true, config, f_arr);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_add_field(*f_arr, config);
+  TEST_ASSERT_NULL(err);
+  err = cmc_config_field_create("", cmc_ConfigFieldTypeEnum_STRING, NULL,
+                                true, config, &f_arr_element);
+  TEST_ASSERT_NULL(err);
+  err = cmc_field_add_subfield(*f_arr, f_arr_element);
+  TEST_ASSERT_NULL(err);
+}
+
+static void assert_static_values(struct cmc_ConfigField *f_name,
+                                 struct cmc_ConfigField *f_arr) {
+  char *value = NULL;
+  err = cmc_field_get_str(f_name, &value);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_STRING("whatever", value);
+  TEST_ASSERT_TRUE(value >= static_memory &&
+                   value < static_memory + sizeof(static_memory));
+
+  const char *expected[] = {"abc", "def"};
+  uint32_t i = 0;
+  CMC_FOREACH_FIELD_ARRAY(element, char *, &f_arr, {
+    TEST_ASSERT_TRUE(i < 2);
+    TEST_ASSERT_EQUAL_STRING(expected[i++], element);
+  });
+  TEST_ASSERT_EQUAL_UINT32(2, i);
+}
+
+void test_static_create_requires_memory(void) {
+  err = cmc_config_create(
+      &(struct cmc_ConfigSettings){.memory_mode = cmc_MemoryModeEnum_STATIC},
+      &config);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NULL(config);
+}
+
+void test_static_file_parse_does_not_use_heap(void) {
+  struct cmc_ConfigField *f_name, *f_arr;
+
+  is_counting = true;
+  create_static_config(sizeof(static_memory), true);
+  TEST_ASSERT_NULL(err);
+  create_static_schema(&f_name, &f_arr);
+
+  err = cmc_config_parse(config);
+  TEST_ASSERT_NULL(err);
+  assert_static_values(f_name, f_arr);
+
+  cmc_config_destroy(&config);
+  is_counting = false;
+
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+void test_static_push_parse_does_not_use_heap(void) {
+  const char *content = "NAME=whatever\nARR_0=abc\nARR_1=def";
+  struct cmc_ConfigField *f_name, *f_arr;
+
+  is_counting = true;
+  create_static_config(sizeof(static_memory), false);
+  TEST_ASSERT_NULL(err);
+  create_static_schema(&f_name, &f_arr);
+
+  // Fed byte by byte, so pending line has to grow.
+  err = cmc_config_parse_begin(config);
+  TEST_ASSERT_NULL(err);
+  for (size_t i = 0; i < strlen(content); i++) {
+    err = cmc_config_parse_feed(content + i, 1, config);
+    TEST_ASSERT_NULL(err);
+  }
+  err = cmc_config_parse_end(config);
+  TEST_ASSERT_NULL(err);
+  assert_static_values(f_name, f_arr);
+
+  cmc_config_destroy(&config);
+  is_counting = false;
+
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+void test_static_reload_reuses_memory(void) {
+  size_t used = 0;
+
+  create_static_config(sizeof(static_memory), true);
+  TEST_ASSERT_NULL(err);
+
+  // Scratch memory is dropped after each parse and fields are dropped by
+  //  reset, so reloads do not use up static memory.
+  for (uint32_t reload = 0; reload < 3; reload++) {
+    struct cmc_ConfigField *f_name, *f_arr;
+    cmc_config_reset(config);
+    create_static_schema(&f_name, &f_arr);
+
+    err = cmc_config_parse(config);
+    TEST_ASSERT_NULL(err);
+    assert_static_values(f_name, f_arr);
+
+    if (reload == 0) {
+      used = config->_arena->blocks->used;
+    }
+    TEST_ASSERT_EQUAL_UINT64(used, config->_arena->blocks->used);
+    TEST_ASSERT_EQUAL_UINT64(0, config->_scratch->blocks->used);
+  }
+}
+
+// Same as the file parse test, but stops at the first error.
+static cme_error_t load_static_config(const size_t static_memory_size,
+                                      struct cmc_ConfigField **f_name,
+                                      struct cmc_ConfigField **f_arr) {
+  struct cmc_ConfigField *f_arr_element;
+
+  create_static_config(static_memory_size, false);
+  if (err) {
+    return err;
+  }
+
+  if ((err = cmc_config_field_create("name", cmc_ConfigFieldTypeEnum_STRING,
+                                     "<none>", true, config, f_name)) ||
+      (err = cmc_config_add_field(*f_name, config)) ||
+      (err = cmc_config_field_create("arr", cmc_ConfigFieldTypeEnum_ARRAY,
+                                     NULL, true, config, f_arr)) ||
+      (err = cmc_config_add_field(*f_arr, config)) ||
+      (err = cmc_config_field_create("", cmc_ConfigFieldTypeEnum_STRING,
+                                     NULL, true, config, &f_arr_element)) ||
+      (err = cmc_field_add_subfield(*f_arr, f_arr_element))) {
+    return err;
+  }
+
+  return cmc_config_parse(config);
+}
+
+void test_static_memory_exhausted(void) {
+  struct cmc_ConfigField *f_name, *f_arr;
+  uint32_t failures = 0;
+
+  // Memory grows until the config fits, every smaller memory fails
+  //  cleanly with ENOMEM at some step.
+  for (size_t static_memory_size = 64;; static_memory_size += 64) {
+    TEST_ASSERT_TRUE(static_memory_size <= sizeof(static_memory));
+
+    err = load_static_config(static_memory_size, &f_name, &f_arr);
+    if (!err) {
+      break;
+    }
+
+    TEST_ASSERT_EQUAL_INT(ENOMEM, err->code);
+    cme_error_destroy(err);
+    cmc_config_destroy(&config);
+    failures++;
+  }
+
+  TEST_ASSERT_TRUE(failures > 0);
+  assert_static_values(f_name, f_arr);
+}
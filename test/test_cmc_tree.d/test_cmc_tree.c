@@ -7,6 +7,8 @@
 #include "utils/cmc_tree.h"
 #include <unity.h>
 
+#define NODES_MAX 100
+
 static struct cmc_TreeNode node;
 static struct cmc_TreeNode child;
 static cme_error_t err = NULL;
@@ -22,16 +24,17 @@ void setUp(void) {
 void tearDown(void) {
   cme_destroy();
   cme_error_destroy(err);
-  cmc_tree_node_destroy(&node);
+  cmc_tree_node_destroy(NULL, &node);
 }
 
 void test_create_node_sets_defaults(void) {
   TEST_ASSERT_NULL(node.subnodes);
   TEST_ASSERT_EQUAL_UINT32(0, node.subnodes_len);
+  TEST_ASSERT_EQUAL_UINT32(0, node.subnodes_max);
 }
 
 void test_add_subnode_increments_length(void) {
-  err = cmc_tree_node_add_subnode(&child, &node);
+  err = cmc_tree_node_add_subnode(NULL, &child, &node);
   TEST_ASSERT_NULL(err);
   TEST_ASSERT_EQUAL_UINT32(1, node.subnodes_len);
   TEST_ASSERT_EQUAL_PTR(&child, node.subnodes[0]);
@@ -43,11 +46,11 @@ void test_add_multiple_subnodes(void) {
   cmc_tree_node_create(&c2);
   cmc_tree_node_create(&c3);
 
-  err = cmc_tree_node_add_subnode(&c1, &node);
+  err = cmc_tree_node_add_subnode(NULL, &c1, &node);
   TEST_ASSERT_NULL(err);
-  err = cmc_tree_node_add_subnode(&c2, &node);
+  err = cmc_tree_node_add_subnode(NULL, &c2, &node);
   TEST_ASSERT_NULL(err);
-  err = cmc_tree_node_add_subnode(&c3, &node);
+  err = cmc_tree_node_add_subnode(NULL, &c3, &node);
   TEST_ASSERT_NULL(err);
 
   TEST_ASSERT_EQUAL_UINT32(3, node.subnodes_len);
@@ -55,10 +58,90 @@ void test_add_multiple_subnodes(void) {
 }
 
 void test_null_input_handling(void) {
-  err = cmc_tree_node_add_subnode(NULL, &node);
+  err = cmc_tree_node_add_subnode(NULL, NULL, &node);
   TEST_ASSERT_NOT_NULL(err);
   cme_error_destroy(err);
 
-  err = cmc_tree_node_add_subnode(&child, NULL);
+  err = cmc_tree_node_add_subnode(NULL, &child, NULL);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_add_subnode_grows_geometrically(void) {
+  struct cmc_TreeNode children[NODES_MAX];
+  uint32_t reallocs = 0;
+  uint32_t subnodes_max = node.subnodes_max;
+
+  for (uint32_t i = 0; i < NODES_MAX; i++) {
+    err = cmc_tree_node_add_subnode(NULL, &children[i], &node);
+    TEST_ASSERT_NULL(err);
+    if (node.subnodes_max != subnodes_max) {
+      subnodes_max = node.subnodes_max;
+      reallocs++;
+    }
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(NODES_MAX, node.subnodes_len);
+  TEST_ASSERT_TRUE(node.subnodes_max >= NODES_MAX);
+  TEST_ASSERT_TRUE(reallocs <= 8);
+  for (uint32_t i = 0; i < NODES_MAX; i++) {
+    TEST_ASSERT_EQUAL_PTR(&children[i], node.subnodes[i]);
+  }
+}
+
+void test_reserve_subnodes_avoids_realloc(void) {
+  struct cmc_TreeNode children[NODES_MAX];
+
+  err = cmc_tree_node_reserve_subnodes(NULL, &node, NODES_MAX);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(NODES_MAX, node.subnodes_max);
+  TEST_ASSERT_EQUAL_UINT32(0, node.subnodes_len);
+
+  struct cmc_TreeNode **subnodes = node.subnodes;
+  for (uint32_t i = 0; i < NODES_MAX; i++) {
+    err = cmc_tree_node_add_subnode(NULL, &children[i], &node);
+    TEST_ASSERT_NULL(err);
+  }
+  TEST_ASSERT_EQUAL_PTR(subnodes, node.subnodes);
+  TEST_ASSERT_EQUAL_UINT32(NODES_MAX, node.subnodes_max);
+}
+
+void test_add_subnodes_in_bulk(void) {
+  struct cmc_TreeNode c1, c2, c3;
+  struct cmc_TreeNode *subnodes[] = {&c1, &c2, &c3};
+
+  err = cmc_tree_node_add_subnode(NULL, &child, &node);
+  TEST_ASSERT_NULL(err);
+  err = cmc_tree_node_add_subnodes(NULL, subnodes, 3, &node);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(4, node.subnodes_len);
+  TEST_ASSERT_EQUAL_PTR(&child, node.subnodes[0]);
+  TEST_ASSERT_EQUAL_PTR(&c1, node.subnodes[1]);
+  TEST_ASSERT_EQUAL_PTR(&c3, node.subnodes[3]);
+}
+
+void test_removal_keeps_capacity(void) {
+  struct cmc_TreeNode c1, c2, c3;
+  struct cmc_TreeNode *subnodes[] = {&c1, &c2, &c3};
+
+  err = cmc_tree_node_add_subnodes(NULL, subnodes, 3, &node);
+  TEST_ASSERT_NULL(err);
+  const uint32_t subnodes_max = node.subnodes_max;
+
+  err = cmc_tree_node_pop_subnode(&node);
+  TEST_ASSERT_NULL(err);
+  TEST_ASSERT_EQUAL_UINT32(2, node.subnodes_len);
+  TEST_ASSERT_EQUAL_PTR(&c1, node.subnodes[0]);
+  TEST_ASSERT_EQUAL_PTR(&c2, node.subnodes[1]);
+
+  err = cmc_tree_node_pop_subnode(&node);
+  TEST_ASSERT_NULL(err);
+  err = cmc_tree_node_resize_subnodes(NULL, &node, 0);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL_UINT32(0, node.subnodes_len);
+  TEST_ASSERT_EQUAL_UINT32(subnodes_max, node.subnodes_max);
+
+  err = cmc_tree_node_pop_subnode(&node);
   TEST_ASSERT_NOT_NULL(err);
 }